@@ -0,0 +1,14 @@
+#include "bvh.h"
+#include "bvh.tcc"
+
+template struct BVH_Node<float, 3u>;
+
+template class BVH<float, 3u>;
+
+template struct Linear_BVH_Node<float, 3u>;
+static_assert(sizeof(Linear_BVH_Node<float, 3u>) == 32u);
+
+template class Linear_BVH<float, 3u>;
+
+template std::vector<AxisAlignedBoundingBox<float, 3u>> bounding_boxes(const std::vector<Sphere<float, 3u>> & primitives);
+template std::vector<AxisAlignedBoundingBox<float, 3u>> bounding_boxes(const std::vector<Triangle<float, 3u>> & primitives);
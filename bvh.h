@@ -0,0 +1,212 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include "math.h"
+#include "geometry.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// contains a bounding volume hierarchy (bvh) over primitives that are only known by their aabbs
+
+
+// a node of the bvh, either an inner node with two children or a leaf referencing a range of primitives
+template <class FLOAT, size_t N>
+struct BVH_Node {
+  AxisAlignedBoundingBox<FLOAT, N> bounds;
+  std::unique_ptr<BVH_Node<FLOAT, N>> left,
+                                      right;  // both are nullptr for leaves
+  size_t first = 0,   // a leaf contains the primitives BVH::primitive_order()[first], ...,
+         count = 0;   //   BVH::primitive_order()[first + count - 1]
+
+  BVH_Node(AxisAlignedBoundingBox<FLOAT, N> bounds) : bounds(bounds) {}
+
+  bool is_leaf() const { return left == nullptr; }
+};
+
+// the strategy used to split the primitives of a node into two children
+enum class BVH_Split {
+  MEDIAN,     // object median of the centers along the axis of largest extent, fastest to build
+  BINNED_SAH  // minimal surface area heuristic cost over a fixed number of bins per axis, fastest to trace
+};
+
+struct BVH_Build_Options {
+  BVH_Split split = BVH_Split::BINNED_SAH;
+  size_t max_leaf_size = 4;           // nodes with more primitives are always split, at most BVH::MAX_LEAF_SIZE
+  size_t bins = 16;                   // number of bins per axis for BINNED_SAH
+  float traversal_cost = 1.0f;        // cost of visiting an inner node relative to ...
+  float intersection_cost = 1.0f;     //   ... the cost of one primitive test
+  unsigned threads = 0;               // number of build threads, 0 selects std::thread::hardware_concurrency()
+  size_t parallel_threshold = 4096;   // subtrees with fewer primitives are built on the current thread
+};
+
+struct BVH_Build_Statistics {
+  double build_seconds = 0.0;
+  size_t node_count = 0,  // inner nodes and leaves
+         leaf_count = 0,
+         depth = 0;       // the number of nodes on the longest path from the root to a leaf
+  double sah_cost = 0.0;  // expected cost of a ray hitting the root in units of BVH_Build_Options::intersection_cost
+};
+
+// counters filled by the traversal functions if requested, e.g. to measure nodes visited per second
+struct BVH_Traversal_Statistics {
+  size_t nodes_visited = 0,      // number of node aabbs tested against the ray
+         primitives_tested = 0;
+};
+
+template <class FLOAT, size_t N>
+class BVH {
+public:
+  // the maximal depth of a bvh, limits the size of the traversal stacks
+  static constexpr size_t MAX_DEPTH = 64;
+
+  // the largest leaf, a larger BVH_Build_Options::max_leaf_size is clamped to it
+  // (Linear_BVH_Node stores the primitive count of a leaf in 16 bits)
+  static constexpr size_t MAX_LEAF_SIZE = UINT16_MAX;
+
+  // creates an empty bvh
+  BVH() = default;
+
+  // creates a bvh over the primitives 0, 1, ..., bounds.size() - 1 with the given aabbs
+  // large subtrees are built in parallel on up to options.threads threads
+  explicit BVH(const std::vector<AxisAlignedBoundingBox<FLOAT, N>> & bounds, const BVH_Build_Options & options = {});
+
+  bool empty() const { return root_node == nullptr; }
+
+  // returns the number of primitives the bvh was built over
+  size_t primitive_count() const { return primitives.size(); }
+
+  // returns the number of inner nodes and leaves
+  size_t node_count() const { return statistics.node_count; }
+
+  // returns build time, size and sah cost of this bvh
+  const BVH_Build_Statistics & build_statistics() const { return statistics; }
+
+  const BVH_Node<FLOAT, N> * root() const { return root_node.get(); }
+
+  // returns the primitive indices in leaf order, leaves reference ranges of this vector
+  const std::vector<size_t> & primitive_order() const { return primitives; }
+
+  // finds the primitive with the closest hit 0 < t < tmax along the given ray
+  // intersect(primitive, tmax) is called for the primitives of all leaves hit by the ray, near leaves first
+  //   it has to return true and lower tmax to the distance of the hit if the primitive is hit closer than tmax,
+  //   and false otherwise
+  // returns true iff any call of intersect returned true
+  // the visited nodes and tested primitives are added to statistics if it is not nullptr
+  template <class INTERSECT>
+  bool closest_hit(const Ray<FLOAT, N> & ray, FLOAT tmax, INTERSECT && intersect, BVH_Traversal_Statistics * statistics = nullptr) const;
+
+  // checks if any primitive is hit by the given ray with 0 < t < tmax
+  // occludes(primitive) is called for the primitives of the leaves hit by the ray until it returns true
+  // returns true iff any call of occludes returned true
+  template <class OCCLUDES>
+  bool any_hit(const Ray<FLOAT, N> & ray, FLOAT tmax, OCCLUDES && occludes) const;
+
+private:
+  // corners and center of a primitive's aabb, precomputed once per build
+  struct Primitive_Bounds {
+    FLOAT lower[N], upper[N], center[N];
+  };
+
+  std::unique_ptr<BVH_Node<FLOAT, N>> build(const std::vector<Primitive_Bounds> & bounds, size_t first, size_t count, size_t depth,
+                                            const BVH_Build_Options & options, size_t parallel_depth);
+
+  // partitions the primitives of a node at the split with the smallest sah cost
+  // returns false if a leaf is cheaper or the centers cannot be separated by bins
+  bool sah_split(const std::vector<Primitive_Bounds> & bounds, size_t first, size_t count, FLOAT node_area,
+                 const BVH_Build_Options & options, size_t & middle);
+
+  // partitions the primitives of a node at the median of their centers along the axis of largest extent
+  void median_split(const std::vector<Primitive_Bounds> & bounds, size_t first, size_t count, size_t & middle);
+
+  void collect_statistics(const BVH_Node<FLOAT, N> * node, size_t depth, FLOAT root_area, const BVH_Build_Options & options);
+
+  std::unique_ptr<BVH_Node<FLOAT, N>> root_node;
+  std::vector<size_t> primitives;
+  BVH_Build_Statistics statistics;
+};
+
+
+// a node of a Linear_BVH, 32 bytes for float and N = 3, i.e. two nodes per cache line
+template <class FLOAT, size_t N>
+struct alignas(32) Linear_BVH_Node {
+  FLOAT lower[N];   // corners of the node's aabb
+  uint32_t offset;  // leaves: position of the first primitive, inner nodes: index of the second child
+  FLOAT upper[N];
+  uint16_t count;   // number of primitives of a leaf, 0 for inner nodes
+  uint8_t axis;     // inner nodes: the first child lies on the lower side of the second one on this axis
+
+  bool is_leaf() const { return count > 0; }
+};
+
+// a bvh flattened into an array of nodes in depth first order
+// the first child of an inner node is stored directly after it, the index of the second child is stored in the node
+// leaves reference ranges of primitive_order(), the primitives are expected to be stored in this order by the owner,
+//   so that a leaf's primitives are contiguous in memory as well
+template <class FLOAT, size_t N>
+class Linear_BVH {
+public:
+  // creates an empty bvh
+  Linear_BVH() = default;
+
+  // flattens the given bvh
+  // throws std::length_error if a leaf has more than BVH::MAX_LEAF_SIZE primitives
+  explicit Linear_BVH(const BVH<FLOAT, N> & bvh);
+
+  bool empty() const { return nodes.empty(); }
+
+  size_t primitive_count() const { return primitives.size(); }
+
+  size_t node_count() const { return nodes.size(); }
+
+  const BVH_Build_Statistics & build_statistics() const { return statistics; }
+
+  const std::vector<Linear_BVH_Node<FLOAT, N>> & node_array() const { return nodes; }
+
+  // returns the primitive indices (wrt the bounds the bvh was built over) in leaf order
+  const std::vector<size_t> & primitive_order() const { return primitives; }
+
+  // same as BVH::closest_hit, but intersect(position, tmax) is called with the position of the primitive
+  // in primitive_order() instead of its original index
+  template <class INTERSECT>
+  bool closest_hit(const Ray<FLOAT, N> & ray, FLOAT tmax, INTERSECT && intersect, BVH_Traversal_Statistics * statistics = nullptr) const;
+
+  // same as BVH::any_hit, but occludes(position) is called with the position of the primitive in primitive_order()
+  template <class OCCLUDES>
+  bool any_hit(const Ray<FLOAT, N> & ray, FLOAT tmax, OCCLUDES && occludes) const;
+
+  // same as closest_hit, but intersect_leaf(first, count, tmax) is called once per leaf hit by the ray with the
+  // positions first, ..., first + count - 1, so that the primitives of a leaf can be intersected at once
+  template <class INTERSECT_LEAF>
+  bool closest_hit_leaves(const Ray<FLOAT, N> & ray, FLOAT tmax, INTERSECT_LEAF && intersect_leaf, BVH_Traversal_Statistics * statistics = nullptr) const;
+
+  // the same for the interval query.tmin < t < query.tmax, the nodes are tested with the precomputed inverse
+  // direction of the query, intersect_leaf gets query.tmax lowered by the hits found so far
+  template <class INTERSECT_LEAF>
+  bool closest_hit_leaves(const Ray_Query<FLOAT, N> & query, INTERSECT_LEAF && intersect_leaf, BVH_Traversal_Statistics * statistics = nullptr) const;
+
+  // same as any_hit, but occludes_leaf(first, count) is called once per leaf hit by the ray
+  template <class OCCLUDES_LEAF>
+  bool any_hit_leaves(const Ray<FLOAT, N> & ray, FLOAT tmax, OCCLUDES_LEAF && occludes_leaf) const;
+
+  // the same for the interval query.tmin < t < query.tmax
+  template <class OCCLUDES_LEAF>
+  bool any_hit_leaves(const Ray_Query<FLOAT, N> & query, OCCLUDES_LEAF && occludes_leaf) const;
+
+private:
+  uint32_t flatten(const BVH_Node<FLOAT, N> * node);
+
+  std::vector<Linear_BVH_Node<FLOAT, N>> nodes;
+  std::vector<size_t> primitives;
+  BVH_Build_Statistics statistics;
+};
+
+// returns the aabbs of the given primitives (e.g. Sphere or Triangle) in the same order
+template <class FLOAT, size_t N, template <class, size_t> class PRIMITIVE>
+std::vector<AxisAlignedBoundingBox<FLOAT, N>> bounding_boxes(const std::vector<PRIMITIVE<FLOAT, N>> & primitives);
+
+typedef BVH<float, 3u> BVH3df;
+typedef Linear_BVH<float, 3u> Linear_BVH3df;
+
+#endif
@@ -0,0 +1,524 @@
+#include "bvh.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <future>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+template <class FLOAT, size_t N>
+BVH<FLOAT, N>::BVH(const std::vector<AxisAlignedBoundingBox<FLOAT, N>> & bounds, const BVH_Build_Options & build_options)
+  : primitives(bounds.size())
+{
+  BVH_Build_Options options = build_options;
+  options.max_leaf_size = std::min(options.max_leaf_size, MAX_LEAF_SIZE);
+  auto start = std::chrono::steady_clock::now();
+  std::iota(primitives.begin(), primitives.end(), 0u);
+  if (!bounds.empty()) {
+    std::vector<Primitive_Bounds> primitive_bounds(bounds.size());
+    for (size_t i = 0; i < bounds.size(); i++) {
+      Vector<FLOAT, N> lower = bounds[i].minimum(),
+                       upper = bounds[i].maximum();
+      for (size_t k = 0; k < N; k++) {
+        primitive_bounds[i].lower[k] = lower[k];
+        primitive_bounds[i].upper[k] = upper[k];
+        primitive_bounds[i].center[k] = static_cast<FLOAT>(0.5) * (lower[k] + upper[k]);
+      }
+    }
+    // subtrees are spawned up to parallel_depth, two subtrees per thread give some slack for unbalanced splits
+    unsigned threads = options.threads > 0 ? options.threads : std::max(std::thread::hardware_concurrency(), 1u);
+    size_t parallel_depth = 0;
+    while ((1u << parallel_depth) < 2 * threads && threads > 1) {
+      parallel_depth++;
+    }
+    root_node = build(primitive_bounds, 0, bounds.size(), 1, options, parallel_depth);
+  }
+  statistics.build_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  if (root_node) {
+    collect_statistics(root_node.get(), 1, root_node->bounds.surface_area(), options);
+  }
+}
+
+template <class FLOAT, size_t N>
+std::unique_ptr<BVH_Node<FLOAT, N>> BVH<FLOAT, N>::build(const std::vector<Primitive_Bounds> & bounds, size_t first, size_t count, size_t depth,
+                                                         const BVH_Build_Options & options, size_t parallel_depth) {
+  Vector<FLOAT, N> lower = {0.0},
+                   upper = {0.0};
+  for (size_t k = 0; k < N; k++) {
+    lower[k] = bounds[primitives[first]].lower[k];
+    upper[k] = bounds[primitives[first]].upper[k];
+  }
+  for (size_t i = first + 1; i < first + count; i++) {
+    for (size_t k = 0; k < N; k++) {
+      lower[k] = std::min(lower[k], bounds[primitives[i]].lower[k]);
+      upper[k] = std::max(upper[k], bounds[primitives[i]].upper[k]);
+    }
+  }
+
+  auto node = std::make_unique<BVH_Node<FLOAT, N>>(AxisAlignedBoundingBox<FLOAT, N>::from_corners(lower, upper));
+  size_t max_leaf_size = std::max<size_t>(options.max_leaf_size, 1);
+  if (count <= 1) {
+    node->first = first;
+    node->count = count;
+    return node;
+  }
+
+  // median splits need at most median_depth further levels, sah splits are only used while these fit into MAX_DEPTH
+  size_t median_depth = 0;
+  while ((size_t{1} << median_depth) < count) {
+    median_depth++;
+  }
+  size_t middle;
+  if (options.split == BVH_Split::BINNED_SAH && depth + median_depth + 1 < MAX_DEPTH) {
+    if (!sah_split(bounds, first, count, node->bounds.surface_area(), options, middle)) {
+      if (count <= max_leaf_size) {
+        node->first = first;
+        node->count = count;
+        return node;
+      }
+      median_split(bounds, first, count, middle);
+    }
+  } else {
+    if (count <= max_leaf_size) {
+      node->first = first;
+      node->count = count;
+      return node;
+    }
+    median_split(bounds, first, count, middle);
+  }
+
+  if (depth <= parallel_depth && count >= options.parallel_threshold) {
+    auto left = std::async(std::launch::async, [&]() {
+      return build(bounds, first, middle - first, depth + 1, options, parallel_depth);
+    });
+    node->right = build(bounds, middle, first + count - middle, depth + 1, options, parallel_depth);
+    node->left = left.get();
+  } else {
+    node->left = build(bounds, first, middle - first, depth + 1, options, parallel_depth);
+    node->right = build(bounds, middle, first + count - middle, depth + 1, options, parallel_depth);
+  }
+  return node;
+}
+
+template <class FLOAT, size_t N>
+bool BVH<FLOAT, N>::sah_split(const std::vector<Primitive_Bounds> & bounds, size_t first, size_t count, FLOAT node_area,
+                              const BVH_Build_Options & options, size_t & middle) {
+  // a bin accumulates the aabb of all primitives whose center falls into it
+  struct Bin {
+    FLOAT lower[N], upper[N];
+    size_t count = 0;
+  };
+  // same as AxisAlignedBoundingBox::surface_area, without building the aabb
+  auto area = [](const FLOAT lower[N], const FLOAT upper[N]) {
+    FLOAT area = 0;
+    for (size_t i = 0; i < N; i++) {
+      FLOAT face = 2;
+      for (size_t j = 0; j < N; j++) {
+        face *= (j != i) ? upper[j] - lower[j] : static_cast<FLOAT>(1.0);
+      }
+      area += face;
+    }
+    return area;
+  };
+
+  FLOAT center_lower[N], center_upper[N];
+  for (size_t k = 0; k < N; k++) {
+    center_lower[k] = center_upper[k] = bounds[primitives[first]].center[k];
+  }
+  for (size_t i = first + 1; i < first + count; i++) {
+    for (size_t k = 0; k < N; k++) {
+      center_lower[k] = std::min(center_lower[k], bounds[primitives[i]].center[k]);
+      center_upper[k] = std::max(center_upper[k], bounds[primitives[i]].center[k]);
+    }
+  }
+
+  const size_t bin_count = std::max<size_t>(options.bins, 2);
+  FLOAT best_cost = std::numeric_limits<FLOAT>::max();
+  size_t best_axis = 0, best_bin = 0;
+  std::vector<Bin> bins(bin_count);
+  std::vector<FLOAT> right_area(bin_count);
+  std::vector<size_t> right_count(bin_count);
+
+  for (size_t axis = 0; axis < N; axis++) {
+    FLOAT extent = center_upper[axis] - center_lower[axis];
+    if (extent <= 0) {
+      continue;
+    }
+    FLOAT scale = bin_count / extent;
+    std::fill(bins.begin(), bins.end(), Bin{});
+    for (size_t i = first; i < first + count; i++) {
+      const Primitive_Bounds & primitive = bounds[primitives[i]];
+      size_t b = std::min(static_cast<size_t>((primitive.center[axis] - center_lower[axis]) * scale), bin_count - 1);
+      Bin & bin = bins[b];
+      for (size_t k = 0; k < N; k++) {
+        bin.lower[k] = bin.count ? std::min(bin.lower[k], primitive.lower[k]) : primitive.lower[k];
+        bin.upper[k] = bin.count ? std::max(bin.upper[k], primitive.upper[k]) : primitive.upper[k];
+      }
+      bin.count++;
+    }
+
+    // sweep from the right to get area and count of all bins right of each split plane
+    Bin accumulated;
+    for (size_t b = bin_count - 1; b > 0; b--) {
+      if (bins[b].count > 0) {
+        for (size_t k = 0; k < N; k++) {
+          accumulated.lower[k] = accumulated.count ? std::min(accumulated.lower[k], bins[b].lower[k]) : bins[b].lower[k];
+          accumulated.upper[k] = accumulated.count ? std::max(accumulated.upper[k], bins[b].upper[k]) : bins[b].upper[k];
+        }
+        accumulated.count += bins[b].count;
+      }
+      right_count[b] = accumulated.count;
+      right_area[b] = accumulated.count ? area(accumulated.lower, accumulated.upper) : 0;
+    }
+
+    // sweep from the left, the split after bin b puts bins 0..b left
+    accumulated = Bin{};
+    for (size_t b = 0; b + 1 < bin_count; b++) {
+      if (bins[b].count > 0) {
+        for (size_t k = 0; k < N; k++) {
+          accumulated.lower[k] = accumulated.count ? std::min(accumulated.lower[k], bins[b].lower[k]) : bins[b].lower[k];
+          accumulated.upper[k] = accumulated.count ? std::max(accumulated.upper[k], bins[b].upper[k]) : bins[b].upper[k];
+        }
+        accumulated.count += bins[b].count;
+      }
+      if (accumulated.count == 0 || right_count[b + 1] == 0) {
+        continue;
+      }
+      FLOAT cost = options.traversal_cost + options.intersection_cost *
+                   (area(accumulated.lower, accumulated.upper) * accumulated.count + right_area[b + 1] * right_count[b + 1]) / node_area;
+      if (cost < best_cost) {
+        best_cost = cost;
+        best_axis = axis;
+        best_bin = b;
+      }
+    }
+  }
+
+  if (best_cost == std::numeric_limits<FLOAT>::max() ||
+      (count <= options.max_leaf_size && best_cost >= options.intersection_cost * count)) {
+    return false;
+  }
+
+  FLOAT scale = bin_count / (center_upper[best_axis] - center_lower[best_axis]);
+  auto split = std::partition(primitives.begin() + first, primitives.begin() + first + count, [&](size_t p) {
+    return std::min(static_cast<size_t>((bounds[p].center[best_axis] - center_lower[best_axis]) * scale), bin_count - 1) <= best_bin;
+  });
+  middle = split - primitives.begin();
+  return true;
+}
+
+template <class FLOAT, size_t N>
+void BVH<FLOAT, N>::median_split(const std::vector<Primitive_Bounds> & bounds, size_t first, size_t count, size_t & middle) {
+  FLOAT center_lower[N], center_upper[N];
+  for (size_t k = 0; k < N; k++) {
+    center_lower[k] = center_upper[k] = bounds[primitives[first]].center[k];
+  }
+  for (size_t i = first + 1; i < first + count; i++) {
+    for (size_t k = 0; k < N; k++) {
+      center_lower[k] = std::min(center_lower[k], bounds[primitives[i]].center[k]);
+      center_upper[k] = std::max(center_upper[k], bounds[primitives[i]].center[k]);
+    }
+  }
+  size_t axis = 0;
+  for (size_t k = 1; k < N; k++) {
+    if (center_upper[k] - center_lower[k] > center_upper[axis] - center_lower[axis]) {
+      axis = k;
+    }
+  }
+
+  middle = first + count / 2;
+  std::nth_element(primitives.begin() + first, primitives.begin() + middle, primitives.begin() + first + count,
+                   [&](size_t p, size_t q) { return bounds[p].center[axis] < bounds[q].center[axis]; });
+}
+
+template <class FLOAT, size_t N>
+void BVH<FLOAT, N>::collect_statistics(const BVH_Node<FLOAT, N> * node, size_t depth, FLOAT root_area, const BVH_Build_Options & options) {
+  FLOAT probability = root_area > 0 ? node->bounds.surface_area() / root_area : 1;  // of hitting node given the root is hit
+  statistics.node_count++;
+  statistics.depth = std::max(statistics.depth, depth);
+  if (node->is_leaf()) {
+    statistics.leaf_count++;
+    statistics.sah_cost += probability * node->count;
+    return;
+  }
+  statistics.sah_cost += probability * options.traversal_cost / options.intersection_cost;
+  collect_statistics(node->left.get(), depth + 1, root_area, options);
+  collect_statistics(node->right.get(), depth + 1, root_area, options);
+}
+
+template <class FLOAT, size_t N>
+template <class INTERSECT>
+bool BVH<FLOAT, N>::closest_hit(const Ray<FLOAT, N> & ray, FLOAT tmax, INTERSECT && intersect, BVH_Traversal_Statistics * statistics) const {
+  if (empty()) {
+    return false;
+  }
+  Ray_Query<FLOAT, N> query(ray, 0, tmax);
+
+  // nodes still to visit together with the distance at which the ray enters their aabb
+  std::pair<const BVH_Node<FLOAT, N> *, FLOAT> stack[MAX_DEPTH + 1];
+  size_t size = 0;
+  FLOAT entry;
+  if (root_node->bounds.intersects(query, entry)) {
+    stack[size++] = {root_node.get(), entry};
+  }
+  if (statistics) {
+    statistics->nodes_visited++;
+  }
+
+  bool hit = false;
+  while (size > 0) {
+    auto [node, node_entry] = stack[--size];
+    if (node_entry > query.tmax) {
+      continue;  // a closer hit was found after the node had been pushed
+    }
+    if (node->is_leaf()) {
+      for (size_t i = node->first; i < node->first + node->count; i++) {
+        hit |= intersect(primitives[i], query.tmax);
+      }
+      if (statistics) {
+        statistics->primitives_tested += node->count;
+      }
+      continue;
+    }
+    if (statistics) {
+      statistics->nodes_visited += 2;
+    }
+    FLOAT left_entry, right_entry;
+    bool left = node->left->bounds.intersects(query, left_entry),
+         right = node->right->bounds.intersects(query, right_entry);
+    assert(size + 2 <= MAX_DEPTH + 1);
+    if (left && right) {
+      // the nearer child is pushed last and thus visited first
+      if (left_entry < right_entry) {
+        stack[size++] = {node->right.get(), right_entry};
+        stack[size++] = {node->left.get(), left_entry};
+      } else {
+        stack[size++] = {node->left.get(), left_entry};
+        stack[size++] = {node->right.get(), right_entry};
+      }
+    } else if (left) {
+      stack[size++] = {node->left.get(), left_entry};
+    } else if (right) {
+      stack[size++] = {node->right.get(), right_entry};
+    }
+  }
+  return hit;
+}
+
+template <class FLOAT, size_t N>
+template <class OCCLUDES>
+bool BVH<FLOAT, N>::any_hit(const Ray<FLOAT, N> & ray, FLOAT tmax, OCCLUDES && occludes) const {
+  if (empty()) {
+    return false;
+  }
+  Ray_Query<FLOAT, N> query(ray, 0, tmax);
+
+  const BVH_Node<FLOAT, N> * stack[MAX_DEPTH + 1];
+  size_t size = 0;
+  stack[size++] = root_node.get();
+
+  FLOAT entry;
+  while (size > 0) {
+    const BVH_Node<FLOAT, N> * node = stack[--size];
+    if (!node->bounds.intersects(query, entry)) {
+      continue;
+    }
+    if (node->is_leaf()) {
+      for (size_t i = node->first; i < node->first + node->count; i++) {
+        if (occludes(primitives[i])) {
+          return true;
+        }
+      }
+      continue;
+    }
+    assert(size + 2 <= MAX_DEPTH + 1);
+    stack[size++] = node->right.get();
+    stack[size++] = node->left.get();
+  }
+  return false;
+}
+
+template <class FLOAT, size_t N>
+Linear_BVH<FLOAT, N>::Linear_BVH(const BVH<FLOAT, N> & bvh)
+  : primitives(bvh.primitive_order()), statistics(bvh.build_statistics())
+{
+  nodes.reserve(bvh.node_count());
+  if (!bvh.empty()) {
+    flatten(bvh.root());
+  }
+}
+
+template <class FLOAT, size_t N>
+uint32_t Linear_BVH<FLOAT, N>::flatten(const BVH_Node<FLOAT, N> * node) {
+  uint32_t index = static_cast<uint32_t>(nodes.size());
+  nodes.emplace_back();
+  Vector<FLOAT, N> lower = node->bounds.minimum(),
+                   upper = node->bounds.maximum();
+  for (size_t k = 0; k < N; k++) {
+    nodes[index].lower[k] = lower[k];
+    nodes[index].upper[k] = upper[k];
+  }
+  if (node->is_leaf()) {
+    if (node->count == 0 || node->count > BVH<FLOAT, N>::MAX_LEAF_SIZE) {
+      throw std::length_error("Linear_BVH: leaf primitive count does not fit into a node");
+    }
+    nodes[index].offset = static_cast<uint32_t>(node->first);
+    nodes[index].count = static_cast<uint16_t>(node->count);
+    return index;
+  }
+
+  // the axis along which the children are separated the most decides the visiting order
+  Vector<FLOAT, N> separation = node->right->bounds.get_center() - node->left->bounds.get_center();
+  uint8_t axis = 0;
+  for (size_t k = 1; k < N; k++) {
+    if (std::fabs(separation[k]) > std::fabs(separation[axis])) {
+      axis = static_cast<uint8_t>(k);
+    }
+  }
+  const BVH_Node<FLOAT, N> * first = node->left.get(),
+                           * second = node->right.get();
+  if (separation[axis] < 0) {
+    std::swap(first, second);
+  }
+  nodes[index].count = 0;
+  nodes[index].axis = axis;
+  flatten(first);  // stored at index + 1
+  nodes[index].offset = flatten(second);
+  return index;
+}
+
+// slab test of the ray of a query against the aabb of a linear bvh node for query.tmin <= t <= tmax
+// like AxisAlignedBoundingBox::intersects(query, entry), the planes entered first are chosen by the signs of the direction
+template <class FLOAT, size_t N>
+inline bool node_intersects(const Linear_BVH_Node<FLOAT, N> & node, const Ray_Query<FLOAT, N> & query, FLOAT tmax) {
+  FLOAT tmin = query.tmin;
+  for (size_t k = 0; k < N; k++) {
+    FLOAT t0 = ((query.negative[k] ? node.upper[k] : node.lower[k]) - query.ray.origin[k]) * query.inverse_direction[k],
+          t1 = ((query.negative[k] ? node.lower[k] : node.upper[k]) - query.ray.origin[k]) * query.inverse_direction[k];
+    tmin = t0 > tmin ? t0 : tmin;
+    tmax = t1 < tmax ? t1 : tmax;
+  }
+  return tmin <= tmax;
+}
+
+template <class FLOAT, size_t N>
+template <class INTERSECT>
+bool Linear_BVH<FLOAT, N>::closest_hit(const Ray<FLOAT, N> & ray, FLOAT tmax, INTERSECT && intersect, BVH_Traversal_Statistics * statistics) const {
+  return closest_hit_leaves(ray, tmax, [&](uint32_t first, uint32_t count, FLOAT & t) {
+    bool hit = false;
+    for (uint32_t i = first; i < first + count; i++) {
+      hit |= intersect(i, t);
+    }
+    return hit;
+  }, statistics);
+}
+
+template <class FLOAT, size_t N>
+template <class INTERSECT_LEAF>
+bool Linear_BVH<FLOAT, N>::closest_hit_leaves(const Ray<FLOAT, N> & ray, FLOAT tmax, INTERSECT_LEAF && intersect_leaf, BVH_Traversal_Statistics * statistics) const {
+  return closest_hit_leaves(Ray_Query<FLOAT, N>(ray, 0, tmax), intersect_leaf, statistics);
+}
+
+template <class FLOAT, size_t N>
+template <class INTERSECT_LEAF>
+bool Linear_BVH<FLOAT, N>::closest_hit_leaves(const Ray_Query<FLOAT, N> & query, INTERSECT_LEAF && intersect_leaf, BVH_Traversal_Statistics * statistics) const {
+  if (empty()) {
+    return false;
+  }
+  FLOAT tmax = query.tmax;
+
+  uint32_t stack[BVH<FLOAT, N>::MAX_DEPTH + 1];
+  size_t size = 0;
+  uint32_t current = 0;
+  bool hit = false;
+  while (true) {
+    const Linear_BVH_Node<FLOAT, N> & node = nodes[current];
+    if (statistics) {
+      statistics->nodes_visited++;
+    }
+    if (node_intersects(node, query, tmax)) {
+      if (node.is_leaf()) {
+        hit |= intersect_leaf(node.offset, static_cast<uint32_t>(node.count), tmax);
+        if (statistics) {
+          statistics->primitives_tested += node.count;
+        }
+      } else if (query.negative[node.axis]) {
+        // the ray runs towards lower coordinates, the second child is the near one
+        stack[size++] = current + 1;
+        current = node.offset;
+        continue;
+      } else {
+        stack[size++] = node.offset;
+        current = current + 1;
+        continue;
+      }
+    }
+    if (size == 0) {
+      break;
+    }
+    current = stack[--size];
+  }
+  return hit;
+}
+
+template <class FLOAT, size_t N>
+template <class OCCLUDES>
+bool Linear_BVH<FLOAT, N>::any_hit(const Ray<FLOAT, N> & ray, FLOAT tmax, OCCLUDES && occludes) const {
+  return any_hit_leaves(ray, tmax, [&](uint32_t first, uint32_t count) {
+    for (uint32_t i = first; i < first + count; i++) {
+      if (occludes(i)) {
+        return true;
+      }
+    }
+    return false;
+  });
+}
+
+template <class FLOAT, size_t N>
+template <class OCCLUDES_LEAF>
+bool Linear_BVH<FLOAT, N>::any_hit_leaves(const Ray<FLOAT, N> & ray, FLOAT tmax, OCCLUDES_LEAF && occludes_leaf) const {
+  return any_hit_leaves(Ray_Query<FLOAT, N>(ray, 0, tmax), occludes_leaf);
+}
+
+template <class FLOAT, size_t N>
+template <class OCCLUDES_LEAF>
+bool Linear_BVH<FLOAT, N>::any_hit_leaves(const Ray_Query<FLOAT, N> & query, OCCLUDES_LEAF && occludes_leaf) const {
+  if (empty()) {
+    return false;
+  }
+
+  uint32_t stack[BVH<FLOAT, N>::MAX_DEPTH + 1];
+  size_t size = 0;
+  uint32_t current = 0;
+  while (true) {
+    const Linear_BVH_Node<FLOAT, N> & node = nodes[current];
+    if (node_intersects(node, query, query.tmax)) {
+      if (!node.is_leaf()) {
+        stack[size++] = node.offset;
+        current = current + 1;
+        continue;
+      }
+      if (occludes_leaf(node.offset, static_cast<uint32_t>(node.count))) {
+        return true;
+      }
+    }
+    if (size == 0) {
+      break;
+    }
+    current = stack[--size];
+  }
+  return false;
+}
+
+template <class FLOAT, size_t N, template <class, size_t> class PRIMITIVE>
+std::vector<AxisAlignedBoundingBox<FLOAT, N>> bounding_boxes(const std::vector<PRIMITIVE<FLOAT, N>> & primitives) {
+  std::vector<AxisAlignedBoundingBox<FLOAT, N>> bounds;
+  bounds.reserve(primitives.size());
+  for (const PRIMITIVE<FLOAT, N> & primitive : primitives) {
+    bounds.push_back(primitive.bounding_box());
+  }
+  return bounds;
+}
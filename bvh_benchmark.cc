@@ -0,0 +1,187 @@
+#include "scene.h"
+#include "bvh.tcc"
+#include "wide_bvh.tcc"
+#include "benchmark/benchmark.h"
+#include <limits>
+#include <numeric>
+#include <random>
+
+namespace {
+
+// the spheres, planes and lights of sphere_field(count) without a bvh, so that every query tests every sphere
+worldObjects sphere_field_without_bvh(size_t count) {
+  worldObjects field = sphere_field(count), world;
+  for (size_t i = 0; i < field.spheres.size(); i++) {
+    world.add(wObject(field.spheres[i], field.sphere_materials[i].color, field.sphere_materials[i].reflective));
+  }
+  for (size_t i = 0; i < field.planes.size(); i++) {
+    world.add(wPlane(field.planes[i], field.plane_materials[i].color, field.plane_materials[i].reflective));
+  }
+  world.lights = field.lights;
+  return world;
+}
+
+void closest_hit_queries(benchmark::State & state, bool with_bvh) {
+  size_t count = static_cast<size_t>(state.range(0));
+  worldObjects world = with_bvh ? sphere_field(count) : sphere_field_without_bvh(count);
+  std::mt19937 generator(7);
+  std::uniform_real_distribution<float> direction(-0.6f, 0.6f);
+  std::vector<Ray3df> rays;
+  for (int i = 0; i < 1024; i++) {
+    rays.push_back(Ray3df{{0.f, 0.f, 0.f}, {direction(generator), direction(generator), -1.f}});
+  }
+
+  Hit_Record3df hit;
+  size_t r = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(world.closest_hit(rays[r++ & 1023u], hit));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_ClosestHitLinear(benchmark::State & state) {
+  closest_hit_queries(state, false);
+}
+BENCHMARK(BM_ClosestHitLinear)->RangeMultiplier(10)->Range(100, 10000);
+
+// per ray cost should grow roughly logarithmically with the number of spheres
+void BM_ClosestHitBVH(benchmark::State & state) {
+  closest_hit_queries(state, true);
+}
+BENCHMARK(BM_ClosestHitBVH)->RangeMultiplier(10)->Range(100, 1000000);
+
+// memory traffic of the closest hit loop without a bvh: the spheres are read once per ray, either from the geometry
+// array of worldObjects or from spheres stored together with their material (wObject), as they were before geometry
+// and materials were split, bytes per second counts the bytes of the array read per ray
+template <class ELEMENT, class GEOMETRY>
+void linear_scan(benchmark::State & state, const std::vector<ELEMENT> & elements, GEOMETRY geometry) {
+  std::mt19937 generator(7);
+  std::uniform_real_distribution<float> direction(-0.6f, 0.6f);
+  std::vector<Ray3df> rays;
+  for (int i = 0; i < 1024; i++) {
+    rays.push_back(Ray3df{{0.f, 0.f, 0.f}, {direction(generator), direction(generator), -1.f}});
+  }
+
+  size_t r = 0;
+  for (auto _ : state) {
+    Ray_Query3df query = rays[r++ & 1023u];
+    size_t index = elements.size();
+    for (size_t i = 0; i < elements.size(); i++) {
+      if (geometry(elements[i]).intersects(query)) {
+        index = i;
+      }
+    }
+    benchmark::DoNotOptimize(index);
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(elements.size() * sizeof(ELEMENT)));
+  state.counters["bytes_per_primitive"] = static_cast<double>(sizeof(ELEMENT));
+}
+
+void BM_LinearScanGeometry(benchmark::State & state) {
+  worldObjects world = sphere_field(static_cast<size_t>(state.range(0)));
+  linear_scan(state, world.spheres, [](const Sphere3df & sphere) -> const Sphere3df & { return sphere; });
+}
+BENCHMARK(BM_LinearScanGeometry)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+void BM_LinearScanWithMaterials(benchmark::State & state) {
+  worldObjects world = sphere_field(static_cast<size_t>(state.range(0)));
+  std::vector<wObject> objects;
+  objects.reserve(world.spheres.size());
+  for (size_t i = 0; i < world.spheres.size(); i++) {
+    objects.push_back(wObject(world.spheres[i], world.sphere_materials[i].color, world.sphere_materials[i].reflective));
+  }
+  linear_scan(state, objects, [](const wObject & object) -> const Sphere3df & { return object.sphere; });
+}
+BENCHMARK(BM_LinearScanWithMaterials)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+// build time against trace quality: reports node count and sah cost of the resulting bvh
+void build_bvh(benchmark::State & state, BVH_Split split) {
+  worldObjects world = sphere_field(static_cast<size_t>(state.range(0)));
+  BVH_Build_Options options;
+  options.split = split;
+  options.threads = static_cast<unsigned>(state.range(1));
+  for (auto _ : state) {
+    world.build(options);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.counters["nodes"] = static_cast<double>(world.bvh_statistics().node_count);
+  state.counters["sah_cost"] = world.bvh_statistics().sah_cost;
+}
+
+void BM_BuildBVHMedian(benchmark::State & state) {
+  build_bvh(state, BVH_Split::MEDIAN);
+}
+BENCHMARK(BM_BuildBVHMedian)->ArgsProduct({{10000, 100000, 1000000}, {1, 0}})->Unit(benchmark::kMillisecond)->UseRealTime();
+
+void BM_BuildBVHBinnedSAH(benchmark::State & state) {
+  build_bvh(state, BVH_Split::BINNED_SAH);
+}
+BENCHMARK(BM_BuildBVHBinnedSAH)->ArgsProduct({{10000, 100000, 1000000}, {1, 0}})->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// pointer based tree against the flattened node array on the same spheres and rays,
+// nodes_visited is reported per second
+template <class TREE>
+void traverse(benchmark::State & state, const TREE & bvh, const std::vector<Sphere3df> & spheres, const std::vector<size_t> & order) {
+  std::mt19937 generator(7);
+  std::uniform_real_distribution<float> direction(-0.6f, 0.6f);
+  std::vector<Ray3df> rays;
+  for (int i = 0; i < 1024; i++) {
+    rays.push_back(Ray3df{{0.f, 0.f, 0.f}, {direction(generator), direction(generator), -1.f}});
+  }
+
+  BVH_Traversal_Statistics statistics;
+  size_t r = 0;
+  for (auto _ : state) {
+    const Ray3df & ray = rays[r++ & 1023u];
+    bool hit = bvh.closest_hit(ray, std::numeric_limits<float>::max(), [&](size_t i, float & tmax) {
+      float t = spheres[order[i]].intersects(ray);
+      if (t > 0.f && t < tmax) {
+        tmax = t;
+        return true;
+      }
+      return false;
+    }, &statistics);
+    benchmark::DoNotOptimize(hit);
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["nodes_visited"] = benchmark::Counter(static_cast<double>(statistics.nodes_visited), benchmark::Counter::kIsRate);
+  state.counters["nodes_per_ray"] = static_cast<double>(statistics.nodes_visited) / state.iterations();
+}
+
+void BM_TraversePointerBVH(benchmark::State & state) {
+  std::vector<Sphere3df> spheres = sphere_field(static_cast<size_t>(state.range(0))).spheres;
+  BVH3df bvh(bounding_boxes(spheres));
+  std::vector<size_t> identity(spheres.size());
+  std::iota(identity.begin(), identity.end(), 0u);
+  traverse(state, bvh, spheres, identity);
+}
+BENCHMARK(BM_TraversePointerBVH)->RangeMultiplier(10)->Range(1000, 1000000);
+
+void BM_TraverseLinearBVH(benchmark::State & state) {
+  std::vector<Sphere3df> spheres = sphere_field(static_cast<size_t>(state.range(0))).spheres;
+  Linear_BVH3df bvh{BVH3df(bounding_boxes(spheres))};
+  traverse(state, bvh, spheres, bvh.primitive_order());
+}
+BENCHMARK(BM_TraverseLinearBVH)->RangeMultiplier(10)->Range(1000, 1000000);
+
+// nodes_visited counts wide nodes, each tests 4 or 8 child aabbs at once
+void BM_TraverseBVH4(benchmark::State & state) {
+  std::vector<Sphere3df> spheres = sphere_field(static_cast<size_t>(state.range(0))).spheres;
+  BVH4 bvh{BVH3df(bounding_boxes(spheres))};
+  traverse(state, bvh, spheres, bvh.primitive_order());
+}
+BENCHMARK(BM_TraverseBVH4)->RangeMultiplier(10)->Range(1000, 1000000);
+
+void BM_TraverseBVH8(benchmark::State & state) {
+  if (simd_level() < BVH8::required_simd_level()) {
+    state.SkipWithError("cpu does not support AVX2");
+    return;
+  }
+  std::vector<Sphere3df> spheres = sphere_field(static_cast<size_t>(state.range(0))).spheres;
+  BVH8 bvh{BVH3df(bounding_boxes(spheres))};
+  traverse(state, bvh, spheres, bvh.primitive_order());
+}
+BENCHMARK(BM_TraverseBVH8)->RangeMultiplier(10)->Range(1000, 1000000);
+
+}
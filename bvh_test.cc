@@ -0,0 +1,281 @@
+#include "bvh.h"
+#include "bvh.tcc"
+#include "random_spheres.h"
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace {
+
+std::vector<AABB3df> bounds_of(const std::vector<Sphere3df> & spheres) {
+  return bounding_boxes(spheres);
+}
+
+// closest hit by testing every sphere, returns the index or spheres.size()
+size_t brute_force_closest(const std::vector<Sphere3df> & spheres, const Ray3df & ray, float & t) {
+  size_t closest = spheres.size();
+  t = std::numeric_limits<float>::max();
+  for (size_t i = 0; i < spheres.size(); i++) {
+    float candidate = spheres[i].intersects(ray);
+    if (candidate > 0.f && candidate < t) {
+      t = candidate;
+      closest = i;
+    }
+  }
+  return closest;
+}
+
+TEST(BVH, EmptyBVH) {
+  BVH3df bvh(std::vector<AABB3df>{});
+  Ray3df ray = { {0.0, 0.0, 0.0}, {1.0, 0.0, 0.0} };
+
+  EXPECT_TRUE(bvh.empty());
+  EXPECT_FALSE(bvh.closest_hit(ray, 100.f, [](size_t, float &) { return true; }));
+  EXPECT_FALSE(bvh.any_hit(ray, 100.f, [](size_t) { return true; }));
+}
+
+// checks that every primitive is in exactly one leaf and returns the number of nodes
+size_t check_leaves(const BVH3df & bvh, size_t max_leaf_size) {
+  std::vector<int> seen(bvh.primitive_count(), 0);
+
+  std::vector<const BVH_Node<float, 3u> *> stack = {bvh.root()};
+  size_t nodes = 0;
+  while (!stack.empty()) {
+    const BVH_Node<float, 3u> * node = stack.back();
+    stack.pop_back();
+    nodes++;
+    if (node->is_leaf()) {
+      EXPECT_LE(node->count, max_leaf_size);
+      for (size_t i = node->first; i < node->first + node->count; i++) {
+        seen[bvh.primitive_order()[i]]++;
+      }
+    } else {
+      stack.push_back(node->left.get());
+      stack.push_back(node->right.get());
+    }
+  }
+  for (int count : seen) {
+    EXPECT_EQ(1, count);
+  }
+  return nodes;
+}
+
+// closest hit via the bvh, returns the index or spheres.size()
+size_t bvh_closest(const BVH3df & bvh, const std::vector<Sphere3df> & spheres, const Ray3df & ray) {
+  size_t closest = spheres.size();
+  bvh.closest_hit(ray, std::numeric_limits<float>::max(), [&](size_t i, float & tmax) {
+    float t = spheres[i].intersects(ray);
+    if (t > 0.f && t < tmax) {
+      tmax = t;
+      closest = i;
+      return true;
+    }
+    return false;
+  });
+  return closest;
+}
+
+TEST(BVH, MedianLeavesContainEveryPrimitiveOnce) {
+  BVH_Build_Options options;
+  options.split = BVH_Split::MEDIAN;
+  BVH3df bvh(bounds_of(random_spheres(1000, 1)), options);
+
+  EXPECT_EQ(check_leaves(bvh, 4), bvh.node_count());
+  EXPECT_EQ(2 * bvh.build_statistics().leaf_count - 1, bvh.node_count());
+}
+
+TEST(BVH, SAHLeavesContainEveryPrimitiveOnce) {
+  BVH_Build_Options options;
+  options.split = BVH_Split::BINNED_SAH;
+  options.max_leaf_size = 2;
+  BVH3df bvh(bounds_of(random_spheres(1000, 4)), options);
+
+  EXPECT_EQ(check_leaves(bvh, 2), bvh.node_count());
+  EXPECT_LE(bvh.build_statistics().depth, BVH3df::MAX_DEPTH);
+}
+
+TEST(BVH, ParallelBuildEqualsSequentialBuild) {
+  std::vector<Sphere3df> spheres = random_spheres(5000, 5);
+  BVH_Build_Options options;
+  options.threads = 1;
+  BVH3df sequential(bounds_of(spheres), options);
+  options.threads = 8;
+  options.parallel_threshold = 64;
+  BVH3df parallel(bounds_of(spheres), options);
+
+  EXPECT_EQ(check_leaves(parallel, options.max_leaf_size), parallel.node_count());
+  EXPECT_EQ(sequential.node_count(), parallel.node_count());
+  EXPECT_EQ(sequential.primitive_order(), parallel.primitive_order());
+  EXPECT_NEAR(sequential.build_statistics().sah_cost, parallel.build_statistics().sah_cost, 0.0001);
+}
+
+TEST(BVH, SAHCostNotAboveMedianCost) {
+  // two distant clusters of different size, median splits cut through the larger cluster
+  std::vector<Sphere3df> spheres = random_spheres(900, 6);
+  for (const Sphere3df & sphere : random_spheres(100, 7)) {
+    AABB3df box = sphere.bounding_box();
+    spheres.push_back(Sphere3df(box.get_center() + Vector3df{1000.f, 0.f, 0.f}, 0.5f));
+  }
+  BVH_Build_Options options;
+  options.split = BVH_Split::MEDIAN;
+  BVH3df median(bounds_of(spheres), options);
+  options.split = BVH_Split::BINNED_SAH;
+  BVH3df sah(bounds_of(spheres), options);
+
+  EXPECT_LE(sah.build_statistics().sah_cost, median.build_statistics().sah_cost);
+  EXPECT_GT(sah.build_statistics().sah_cost, 0.0);
+}
+
+TEST(BVH, BoundingBoxesOfTriangles) {
+  std::vector<Triangle3df> triangles = { Triangle3df({0.0, 0.0, 0.0}, {2.0, 0.0, 0.0}, {0.0, 4.0, 1.0}) };
+  std::vector<AABB3df> bounds = bounding_boxes(triangles);
+
+  ASSERT_EQ(1u, bounds.size());
+  EXPECT_NEAR(0.0, bounds[0].minimum()[1], 0.00001);
+  EXPECT_NEAR(4.0, bounds[0].maximum()[1], 0.00001);
+  EXPECT_NEAR(1.0, bounds[0].maximum()[2], 0.00001);
+}
+
+TEST(BVH, ClosestHitMatchesBruteForce) {
+  std::vector<Sphere3df> spheres = random_spheres(2000, 2);
+  BVH_Build_Options options;
+  options.split = BVH_Split::MEDIAN;
+  BVH3df median(bounds_of(spheres), options);
+  options.split = BVH_Split::BINNED_SAH;
+  BVH3df sah(bounds_of(spheres), options);
+  std::mt19937 generator(3);
+  std::uniform_real_distribution<float> direction(-1.f, 1.f);
+
+  for (int r = 0; r < 500; r++) {
+    Ray3df ray = { {0.0, 0.0, 0.0}, {direction(generator), direction(generator), direction(generator)} };
+    float expected_t;
+    size_t expected = brute_force_closest(spheres, ray, expected_t);
+
+    EXPECT_EQ(expected, bvh_closest(median, spheres, ray));
+    EXPECT_EQ(expected, bvh_closest(sah, spheres, ray));
+  }
+}
+
+TEST(LINEAR_BVH, NodeLayout) {
+  EXPECT_EQ(32u, sizeof(Linear_BVH_Node<float, 3u>));
+  EXPECT_EQ(32u, alignof(Linear_BVH_Node<float, 3u>));
+
+  Linear_BVH3df bvh(BVH3df(bounds_of(random_spheres(1000, 8))));
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(bvh.node_array().data()) % 32u);
+}
+
+TEST(LINEAR_BVH, DepthFirstOrderWithLeafRanges) {
+  BVH3df tree(bounds_of(random_spheres(1000, 9)));
+  Linear_BVH3df bvh(tree);
+  const std::vector<Linear_BVH_Node<float, 3u>> & nodes = bvh.node_array();
+  std::vector<int> seen(bvh.primitive_count(), 0);
+
+  ASSERT_EQ(tree.node_count(), bvh.node_count());
+  EXPECT_EQ(tree.primitive_order(), bvh.primitive_order());
+  for (size_t i = 0; i < nodes.size(); i++) {
+    if (nodes[i].is_leaf()) {
+      for (size_t p = nodes[i].offset; p < nodes[i].offset + nodes[i].count; p++) {
+        seen[p]++;
+      }
+      continue;
+    }
+    // both children lie after their parent, the first one directly
+    EXPECT_GT(nodes[i].offset, i + 1);
+    EXPECT_LT(nodes[i].offset, nodes.size());
+    for (size_t k = 0; k < 3; k++) {
+      EXPECT_LE(nodes[i].lower[k], nodes[i + 1].lower[k] + 0.0001f);
+      EXPECT_GE(nodes[i].upper[k] + 0.0001f, nodes[nodes[i].offset].upper[k]);
+    }
+  }
+  for (int count : seen) {
+    EXPECT_EQ(1, count);
+  }
+}
+
+TEST(LINEAR_BVH, ClosestHitMatchesBruteForce) {
+  std::vector<Sphere3df> spheres = random_spheres(2000, 10);
+  Linear_BVH3df bvh(BVH3df(bounds_of(spheres)));
+  std::mt19937 generator(11);
+  std::uniform_real_distribution<float> direction(-1.f, 1.f);
+
+  for (int r = 0; r < 500; r++) {
+    Ray3df ray = { {0.0, 0.0, 0.0}, {direction(generator), direction(generator), direction(generator)} };
+    float expected_t;
+    size_t expected = brute_force_closest(spheres, ray, expected_t);
+
+    size_t closest = spheres.size();
+    bvh.closest_hit(ray, std::numeric_limits<float>::max(), [&](size_t position, float & tmax) {
+      size_t i = bvh.primitive_order()[position];
+      float t = spheres[i].intersects(ray);
+      if (t > 0.f && t < tmax) {
+        tmax = t;
+        closest = i;
+        return true;
+      }
+      return false;
+    });
+    EXPECT_EQ(expected, closest);
+
+    bool occluded = bvh.any_hit(ray, expected_t, [&](size_t position) {
+      float t = spheres[bvh.primitive_order()[position]].intersects(ray);
+      return t > 0.f && t < expected_t;
+    });
+    EXPECT_FALSE(occluded);
+  }
+}
+
+TEST(LINEAR_BVH, OversizedLeavesAreSplit) {
+  // more primitives than a node can count, e.g. --bvh-leaf-size -1
+  std::vector<Sphere3df> spheres = random_spheres(BVH3df::MAX_LEAF_SIZE + 5000, 12);
+  BVH_Build_Options options;
+  options.max_leaf_size = std::numeric_limits<size_t>::max();
+
+  for (BVH_Split split : {BVH_Split::MEDIAN, BVH_Split::BINNED_SAH}) {
+    options.split = split;
+    BVH3df tree(bounds_of(spheres), options);
+    EXPECT_EQ(check_leaves(tree, BVH3df::MAX_LEAF_SIZE), tree.node_count());
+
+    Linear_BVH3df bvh(tree);
+    size_t primitives = 0;
+    for (const Linear_BVH_Node<float, 3u> & node : bvh.node_array()) {
+      primitives += node.count;
+    }
+    EXPECT_EQ(spheres.size(), primitives);
+
+    Ray3df ray = { {0.0, 0.0, 0.0}, {1.0, 0.5, 0.25} };
+    float expected_t;
+    size_t expected = brute_force_closest(spheres, ray, expected_t),
+           closest = spheres.size();
+    bvh.closest_hit(ray, std::numeric_limits<float>::max(), [&](size_t position, float & tmax) {
+      size_t i = bvh.primitive_order()[position];
+      float t = spheres[i].intersects(ray);
+      if (t > 0.f && t < tmax) {
+        tmax = t;
+        closest = i;
+        return true;
+      }
+      return false;
+    });
+    EXPECT_EQ(expected, closest);
+  }
+}
+
+TEST(BVH, AnyHitRespectsTmax) {
+  std::vector<Sphere3df> spheres = { Sphere3df({5.0, 0.0, 0.0}, 1.0), Sphere3df({0.0, 8.0, 0.0}, 1.0) };
+  BVH_Build_Options options;
+  options.max_leaf_size = 1;
+  BVH3df bvh(bounds_of(spheres), options);
+  Ray3df ray = { {0.0, 0.0, 0.0}, {1.0, 0.0, 0.0} };
+  auto occludes = [&](size_t i) {
+    float t = spheres[i].intersects(ray);
+    return t > 0.f && t < 3.f;
+  };
+
+  EXPECT_FALSE(bvh.any_hit(ray, 3.f, occludes));
+  EXPECT_TRUE(bvh.any_hit(ray, 10.f, [&](size_t i) { return spheres[i].intersects(ray) > 0.f; }));
+  EXPECT_FALSE(bvh.any_hit(ray, 3.5f, [&](size_t i) { return spheres[i].intersects(ray) > 0.f; }));
+}
+
+}
@@ -0,0 +1,55 @@
+#include "camera.h"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+Camera::Camera(int width, int height, Vector3df eye, Vector3df target, Vector3df up, float focal_length, float viewport_height)
+  : columns(width), rows(height), origin(eye), pixel00{}, delta_u{}, delta_v{}
+{
+  // orthonormal basis: w points backwards (from the target to the eye), u to the right, v to the top
+  Vector3df w = eye - target;
+  w.normalize();
+  Vector3df u = cross(up, w);
+  u.normalize();
+  Vector3df v = cross(w, u);
+
+  float viewport_width = viewport_height * (static_cast<float>(width) / static_cast<float>(height));
+  Vector3df viewport_u = viewport_width * u,
+            viewport_v = -viewport_height * v;  // the rows go from the top to the bottom
+  delta_u = (1.f / static_cast<float>(width)) * viewport_u;
+  delta_v = (1.f / static_cast<float>(height)) * viewport_v;
+
+  // the directions are relative to the eye
+  Vector3df viewport_upper_left = -focal_length * w - (0.5f * viewport_u) - (0.5f * viewport_v);
+  pixel00 = viewport_upper_left + (0.5f * (delta_u + delta_v));
+}
+
+#if defined(__SSE2__)
+void Camera::rays(int i, int j, size_t count, Ray_Batch & batch) const {
+  Vector3df start = row_start(j);
+  batch.count = count;
+  __m128 column[Ray_Batch::WIDTH / 4u];
+  for (size_t lanes = 0; lanes < Ray_Batch::WIDTH / 4u; lanes++) {
+    int first = i + static_cast<int>(4u * lanes);
+    column[lanes] = _mm_cvtepi32_ps(_mm_setr_epi32(first, first + 1, first + 2, first + 3));
+  }
+  for (size_t k = 0; k < 3u; k++) {
+    __m128 start_k = _mm_set1_ps(start[k]),
+           delta_k = _mm_set1_ps(delta_u[k]);
+    for (size_t lanes = 0; lanes < Ray_Batch::WIDTH / 4u; lanes++) {
+      _mm_store_ps(&batch.direction[k][4u * lanes], _mm_add_ps(start_k, _mm_mul_ps(column[lanes], delta_k)));
+    }
+  }
+}
+#else
+void Camera::rays(int i, int j, size_t count, Ray_Batch & batch) const {
+  Vector3df start = row_start(j);
+  batch.count = count;
+  for (size_t k = 0; k < 3u; k++) {
+    for (size_t lane = 0; lane < Ray_Batch::WIDTH; lane++) {
+      batch.direction[k][lane] = start[k] + static_cast<float>(i + static_cast<int>(lane)) * delta_u[k];
+    }
+  }
+}
+#endif
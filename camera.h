@@ -0,0 +1,63 @@
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include "math.h"
+#include "geometry.h"
+#include <cstddef>
+
+// contains the camera generating the primary rays of an image (the "Kamera" of raytracer.cc)
+
+
+// the directions of up to WIDTH primary rays of consecutive pixels of a row as structure of arrays,
+// all rays start at the camera's eye
+struct alignas(32) Ray_Batch {
+  static constexpr size_t WIDTH = 8u;
+
+  float direction[3][WIDTH];  // direction[axis][ray]
+  size_t count;               // number of valid rays, the directions of the remaining rays are unspecified
+};
+
+// a pinhole camera looking from eye at target for an image of width x height pixels
+// the image plane lies focal_length in front of the eye and is viewport_height high, its width follows from the
+// aspect ratio of the image, up gives the direction of the top of the image (up must not be parallel to the
+// viewing direction)
+// the direction of the ray through the center of pixel (i, j) is row_start(j) + i * pixel_delta_u, so that
+// the directions of a row are generated by one multiplication and addition per pixel
+class Camera {
+public:
+  // the defaults are the camera of cornell_box(): at the origin looking along -z
+  Camera(int width, int height, Vector3df eye = {0.f, 0.f, 0.f}, Vector3df target = {0.f, 0.f, -1.f},
+         Vector3df up = {0.f, 1.f, 0.f}, float focal_length = 5.f, float viewport_height = 9.f);
+
+  int width() const { return columns; }
+
+  int height() const { return rows; }
+
+  const Vector3df & eye() const { return origin; }
+
+  // returns the step of the ray direction from a pixel to its right neighbour
+  const Vector3df & pixel_delta_u() const { return delta_u; }
+
+  // returns the direction of the ray through the center of the left pixel of row j (not normalized)
+  Vector3df row_start(int j) const { return pixel00 + static_cast<float>(j) * delta_v; }
+
+  // returns the direction of the ray through the center of pixel (i, j) (not normalized)
+  Vector3df direction(int i, int j) const { return row_start(j) + static_cast<float>(i) * delta_u; }
+
+  // returns the ray through the center of pixel (i, j), the ray is at the image plane for t = 1
+  Ray3df ray(int i, int j) const { return Ray3df{origin, direction(i, j)}; }
+
+  // sets batch to the directions of the rays through the pixels i, ..., i + count - 1 of row j
+  // count must not exceed Ray_Batch::WIDTH, the directions are the same as the ones of direction()
+  void rays(int i, int j, size_t count, Ray_Batch & batch) const;
+
+private:
+  int columns,
+      rows;
+  Vector3df origin,
+            pixel00,   // direction through the center of pixel (0, 0)
+            delta_u,   // steps of the direction to the next column and row
+            delta_v;
+};
+
+#endif
@@ -0,0 +1,63 @@
+#include "camera.h"
+#include "benchmark/benchmark.h"
+
+namespace {
+
+// generates the primary rays of a 640 x 360 image per iteration, items are rays
+
+// the per pixel vector arithmetic render() used before the camera
+void BM_PrimaryRaysInline(benchmark::State & state) {
+  const int width = 640, height = 360;
+  float viewport_height = 9.f, viewport_width = viewport_height * (static_cast<float>(width) / height);
+  Vector3df camera_center = {0.f, 0.f, 0.f};
+  Vector3df viewport_u = Vector3df{viewport_width, 0.f, 0.f}, viewport_v = Vector3df{0.f, -viewport_height, 0.f};
+  Vector3df pixel_delta_u = (1.f / width) * viewport_u, pixel_delta_v = (1.f / height) * viewport_v;
+  Vector3df viewport_upper_left = camera_center - Vector3df{0.f, 0.f, 5.f} - (0.5f * viewport_u) - (0.5f * viewport_v);
+  Vector3df pixel00_loc = viewport_upper_left + (0.5f * (pixel_delta_u + pixel_delta_v));
+
+  for (auto _ : state) {
+    for (int j = 0; j < height; ++j) {
+      for (int i = 0; i < width; ++i) {
+        Vector3df pixel_center = pixel00_loc + ((float) i * pixel_delta_u) + ((float) j * pixel_delta_v);
+        Ray3df ray = {camera_center, pixel_center + camera_center};
+        benchmark::DoNotOptimize(ray);
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * width * height);
+}
+BENCHMARK(BM_PrimaryRaysInline);
+
+void BM_CameraRays(benchmark::State & state) {
+  Camera camera(640, 360);
+
+  for (auto _ : state) {
+    for (int j = 0; j < camera.height(); ++j) {
+      Vector3df row_start = camera.row_start(j);
+      for (int i = 0; i < camera.width(); ++i) {
+        Ray3df ray = {camera.eye(), row_start + (float) i * camera.pixel_delta_u()};
+        benchmark::DoNotOptimize(ray);
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * camera.width() * camera.height());
+}
+BENCHMARK(BM_CameraRays);
+
+void BM_CameraRayBatches(benchmark::State & state) {
+  Camera camera(640, 360);
+  Ray_Batch batch;
+
+  for (auto _ : state) {
+    for (int j = 0; j < camera.height(); ++j) {
+      for (int i = 0; i < camera.width(); i += static_cast<int>(Ray_Batch::WIDTH)) {
+        camera.rays(i, j, Ray_Batch::WIDTH, batch);
+        benchmark::DoNotOptimize(batch);
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * camera.width() * camera.height());
+}
+BENCHMARK(BM_CameraRayBatches);
+
+}
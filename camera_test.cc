@@ -0,0 +1,66 @@
+#include "camera.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+
+namespace {
+
+TEST(CAMERA, DefaultCameraLooksAlongNegativeZ) {
+  Camera camera(160, 90);
+
+  EXPECT_EQ(160, camera.width());
+  EXPECT_EQ(90, camera.height());
+  EXPECT_EQ(0.f, camera.eye()[0]);
+  // the viewport is 16 x 9 at z = -5, pixel (0, 0) is the top left one
+  Vector3df direction = camera.direction(0, 0);
+  EXPECT_NEAR(-8.f + 0.05f, direction[0], 1e-5f);
+  EXPECT_NEAR(4.5f - 0.05f, direction[1], 1e-5f);
+  EXPECT_NEAR(-5.f, direction[2], 1e-5f);
+  direction = camera.direction(159, 89);
+  EXPECT_NEAR(8.f - 0.05f, direction[0], 1e-5f);
+  EXPECT_NEAR(-4.5f + 0.05f, direction[1], 1e-5f);
+  EXPECT_NEAR(-5.f, direction[2], 1e-5f);
+}
+
+TEST(CAMERA, LookAt) {
+  Vector3df eye = {1.f, 2.f, 3.f},
+            target = {4.f, 2.f, 7.f};
+  Camera camera(100, 100, eye, target, {0.f, 1.f, 0.f}, 5.f, 2.f);
+
+  Ray3df ray = camera.ray(50, 50);  // the pixel just right and below the center
+  for (size_t k = 0; k < 3; k++) {
+    EXPECT_EQ(eye[k], ray.origin[k]);
+  }
+  // the center of the image lies focal_length in front of the eye towards the target
+  Vector3df center = 0.5f * (camera.direction(49, 49) + camera.direction(50, 50));
+  EXPECT_NEAR(3.f, center[0], 1e-5f);
+  EXPECT_NEAR(0.f, center[1], 1e-5f);
+  EXPECT_NEAR(4.f, center[2], 1e-5f);
+  // rows go down, columns go right (looking along +x +z, right is -x +z)
+  Vector3df right = camera.direction(99, 50) - camera.direction(0, 50),
+            down = camera.direction(50, 99) - camera.direction(50, 0);
+  EXPECT_NEAR(0.f, right * center, 1e-4f);
+  EXPECT_LT(right[0], 0.f);
+  EXPECT_GT(right[2], 0.f);
+  EXPECT_NEAR(-1.98f, down[1], 1e-5f);
+}
+
+TEST(CAMERA, BatchesMatchSingleRays) {
+  Camera camera(37, 20, {0.f, 1.f, 5.f}, {0.f, 0.f, -10.f}, {0.f, 1.f, 0.f}, 1.f, 1.f);
+  Ray_Batch batch;
+
+  for (int j = 0; j < camera.height(); j++) {
+    for (int i = 0; i < camera.width(); i += static_cast<int>(Ray_Batch::WIDTH)) {
+      size_t count = std::min<size_t>(Ray_Batch::WIDTH, static_cast<size_t>(camera.width() - i));
+      camera.rays(i, j, count, batch);
+      ASSERT_EQ(count, batch.count);
+      for (size_t lane = 0; lane < count; lane++) {
+        Vector3df direction = camera.direction(i + static_cast<int>(lane), j);
+        for (size_t k = 0; k < 3; k++) {
+          EXPECT_EQ(direction[k], batch.direction[k][lane]);
+        }
+      }
+    }
+  }
+}
+
+}
@@ -0,0 +1,59 @@
+#include "framebuffer.h"
+#include <algorithm>
+#include <fstream>
+
+Framebuffer::Framebuffer(int width, int height)
+  : columns(width), rows(height), channels(3u * static_cast<size_t>(width) * static_cast<size_t>(height), 0.0f)
+{
+}
+
+void Framebuffer::set_pixel(int x, int y, const Vector3df & color) {
+  float * pixel = &channels[3u * (static_cast<size_t>(y) * static_cast<size_t>(columns) + static_cast<size_t>(x))];
+  pixel[0] = color[0];
+  pixel[1] = color[1];
+  pixel[2] = color[2];
+}
+
+Vector3df Framebuffer::get_pixel(int x, int y) const {
+  const float * pixel = &channels[3u * (static_cast<size_t>(y) * static_cast<size_t>(columns) + static_cast<size_t>(x))];
+  return Vector3df{pixel[0], pixel[1], pixel[2]};
+}
+
+namespace {
+
+// quantizes count channels, the loop is branch free, so that the compiler can vectorize it
+// the factor is the double 255.999 as in write_color, so that both produce the same values
+void quantize_channels(const float * channels, size_t count, uint8_t * bytes) {
+  for (size_t i = 0; i < count; i++) {
+    double value = 255.999 * channels[i];
+    value = value < 0.0 ? 0.0 : value;
+    value = value > 255.0 ? 255.0 : value;
+    bytes[i] = static_cast<uint8_t>(value);
+  }
+}
+
+}
+
+std::vector<uint8_t> Framebuffer::quantize() const {
+  std::vector<uint8_t> bytes(channels.size());
+  quantize_channels(channels.data(), channels.size(), bytes.data());
+  return bytes;
+}
+
+void Framebuffer::write_ppm(std::ostream & out) const {
+  std::string header = "P6\n" + std::to_string(columns) + ' ' + std::to_string(rows) + "\n255\n";
+  std::vector<uint8_t> image(header.size() + channels.size());
+  std::copy(header.begin(), header.end(), image.begin());
+  quantize_channels(channels.data(), channels.size(), image.data() + header.size());
+  out.write(reinterpret_cast<const char *>(image.data()), static_cast<std::streamsize>(image.size()));
+}
+
+bool Framebuffer::write_ppm(const std::string & path) const {
+  std::ofstream file(path, std::ios::binary);
+  if (!file) {
+    return false;
+  }
+  write_ppm(file);
+  file.close();
+  return !file.fail();
+}
@@ -0,0 +1,48 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include "math.h"
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// contains the framebuffer the renderer writes into (the "Bildschirm" of raytracer.cc) and its output as PPM image
+
+
+// an image of width x height pixels with rgb colors, each channel from 0 (dark) to 1 (bright)
+// the pixels are stored row by row as consecutive floats r, g, b
+class Framebuffer {
+public:
+  // creates a black image
+  Framebuffer(int width, int height);
+
+  int width() const { return columns; }
+
+  int height() const { return rows; }
+
+  // sets the pixel in column x and row y (row 0 is the top row)
+  // pixels may be set from different threads as long as no pixel is set twice at the same time
+  void set_pixel(int x, int y, const Vector3df & color);
+
+  // returns the color of the pixel in column x and row y
+  Vector3df get_pixel(int x, int y) const;
+
+  // returns all channels of all pixels in row order quantized to 0...255 like write_color in color.h,
+  // values outside of 0...1 are clamped
+  std::vector<uint8_t> quantize() const;
+
+  // writes the image as binary PPM (P6) to out using a single write
+  void write_ppm(std::ostream & out) const;
+
+  // writes the image as binary PPM (P6) into the file with the given path, returns false if that fails
+  bool write_ppm(const std::string & path) const;
+
+private:
+  int columns,
+      rows;
+  std::vector<float> channels;
+};
+
+#endif
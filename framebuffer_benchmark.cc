@@ -0,0 +1,48 @@
+#include "framebuffer.h"
+#include "color.h"
+#include "benchmark/benchmark.h"
+#include <sstream>
+
+namespace {
+
+// a width x width * 9 / 16 frame with a color gradient
+Framebuffer gradient(int width) {
+  Framebuffer framebuffer(width, width * 9 / 16);
+  for (int y = 0; y < framebuffer.height(); y++) {
+    for (int x = 0; x < framebuffer.width(); x++) {
+      framebuffer.set_pixel(x, y, Vector3df{float(x) / framebuffer.width(), float(y) / framebuffer.height(), 0.25f});
+    }
+  }
+  return framebuffer;
+}
+
+// the former output: ascii PPM (P3) written pixel by pixel through write_color
+void BM_WriteP3(benchmark::State & state) {
+  Framebuffer framebuffer = gradient(static_cast<int>(state.range(0)));
+  for (auto _ : state) {
+    std::ostringstream out;
+    out << "P3\n" << framebuffer.width() << ' ' << framebuffer.height() << "\n255\n";
+    for (int y = 0; y < framebuffer.height(); y++) {
+      for (int x = 0; x < framebuffer.width(); x++) {
+        write_color(out, framebuffer.get_pixel(x, y));
+      }
+    }
+    state.counters["bytes"] = static_cast<double>(out.tellp());
+  }
+  state.SetItemsProcessed(state.iterations() * framebuffer.width() * framebuffer.height());
+}
+BENCHMARK(BM_WriteP3)->Arg(640)->Arg(1920)->Unit(benchmark::kMillisecond);
+
+// binary PPM (P6), quantized in bulk and written at once
+void BM_WriteP6(benchmark::State & state) {
+  Framebuffer framebuffer = gradient(static_cast<int>(state.range(0)));
+  for (auto _ : state) {
+    std::ostringstream out;
+    framebuffer.write_ppm(out);
+    state.counters["bytes"] = static_cast<double>(out.tellp());
+  }
+  state.SetItemsProcessed(state.iterations() * framebuffer.width() * framebuffer.height());
+}
+BENCHMARK(BM_WriteP6)->Arg(640)->Arg(1920)->Unit(benchmark::kMillisecond);
+
+}
@@ -0,0 +1,89 @@
+#include "framebuffer.h"
+#include "color.h"
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+namespace {
+
+TEST(FRAMEBUFFER, StartsBlack) {
+  Framebuffer framebuffer(4, 3);
+
+  EXPECT_EQ(4, framebuffer.width());
+  EXPECT_EQ(3, framebuffer.height());
+  for (uint8_t channel : framebuffer.quantize()) {
+    EXPECT_EQ(0, channel);
+  }
+}
+
+TEST(FRAMEBUFFER, SetAndGetPixel) {
+  Framebuffer framebuffer(4, 3);
+  framebuffer.set_pixel(3, 1, Vector3df{0.25f, 0.5f, 1.0f});
+
+  Vector3df pixel = framebuffer.get_pixel(3, 1);
+  EXPECT_EQ(0.25f, pixel[0]);
+  EXPECT_EQ(0.5f, pixel[1]);
+  EXPECT_EQ(1.0f, pixel[2]);
+  EXPECT_EQ(0.f, framebuffer.get_pixel(2, 1)[0]);
+}
+
+TEST(FRAMEBUFFER, QuantizesLikeWriteColor) {
+  Framebuffer framebuffer(256, 1);
+  for (int i = 0; i < 256; i++) {
+    framebuffer.set_pixel(i, 0, Vector3df{i / 255.f, i / 256.f, 0.3f * i / 255.f});
+  }
+  std::vector<uint8_t> bytes = framebuffer.quantize();
+
+  ASSERT_EQ(3u * 256u, bytes.size());
+  for (int i = 0; i < 256; i++) {
+    std::ostringstream expected, actual;
+    write_color(expected, framebuffer.get_pixel(i, 0));
+    actual << int(bytes[3 * i]) << ' ' << int(bytes[3 * i + 1]) << ' ' << int(bytes[3 * i + 2]) << '\n';
+    EXPECT_EQ(expected.str(), actual.str());
+  }
+}
+
+TEST(FRAMEBUFFER, ClampsChannels) {
+  Framebuffer framebuffer(1, 1);
+  framebuffer.set_pixel(0, 0, Vector3df{-0.5f, 1.5f, 1.0f});
+  std::vector<uint8_t> bytes = framebuffer.quantize();
+
+  EXPECT_EQ(0, bytes[0]);
+  EXPECT_EQ(255, bytes[1]);
+  EXPECT_EQ(255, bytes[2]);
+}
+
+TEST(FRAMEBUFFER, WritesBinaryPPM) {
+  Framebuffer framebuffer(2, 2);
+  framebuffer.set_pixel(1, 0, Vector3df{1.f, 0.f, 0.f});
+  framebuffer.set_pixel(0, 1, Vector3df{0.f, 0.f, 1.f});
+  std::ostringstream out;
+  framebuffer.write_ppm(out);
+
+  std::string header = "P6\n2 2\n255\n";
+  std::string image = out.str();
+  ASSERT_EQ(header.size() + 12u, image.size());
+  EXPECT_EQ(header, image.substr(0, header.size()));
+  EXPECT_EQ(std::string("\0\0\0\xff\0\0\0\0\xff\0\0\0", 12), image.substr(header.size()));
+}
+
+TEST(FRAMEBUFFER, WritesFile) {
+  Framebuffer framebuffer(3, 2);
+  framebuffer.set_pixel(2, 1, Vector3df{0.5f, 0.5f, 0.5f});
+  std::string path = testing::TempDir() + "framebuffer_test.ppm";
+
+  ASSERT_TRUE(framebuffer.write_ppm(path));
+  std::ifstream file(path, std::ios::binary);
+  std::string written((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  std::ostringstream expected;
+  framebuffer.write_ppm(expected);
+  EXPECT_EQ(expected.str(), written);
+  std::remove(path.c_str());
+
+  EXPECT_FALSE(framebuffer.write_ppm("/nonexistent/directory/image.ppm"));
+}
+
+}
@@ -4,6 +4,7 @@
 
 #include "math.h"
 #include <iostream>
+#include <limits>
 #include <vector>
 
 // contains geometric shapes and related stuff, like spheres, triangles, intersection algorithms.
@@ -15,6 +16,21 @@ struct Ray {
                   direction;
 };
 
+// a ray together with the interval tmin < t < tmax in which intersections are searched
+// closest hit queries lower tmax to the t of each hit found, so that farther primitives and aabbs are rejected early,
+// tmin > 0 skips the surface a secondary ray starts on (instead of moving its origin away from the surface)
+// the inverse direction and its signs are computed once for the slab tests of all aabbs
+template <class FLOAT, size_t N>
+struct Ray_Query {
+  Ray<FLOAT,N> ray;
+  FLOAT tmin,
+        tmax;
+  Vector<FLOAT,N> inverse_direction;  // 1 / ray.direction[i], +-inf for zero components
+  bool negative[N];                   // inverse_direction[i] < 0
+
+  Ray_Query(const Ray<FLOAT,N> &ray, FLOAT tmin = 0, FLOAT tmax = std::numeric_limits<FLOAT>::max());
+};
+
 // collection of intersection specific values, like intersection point, normal etc
 template <class FLOAT, size_t N>
 struct Intersection_Context {
@@ -61,11 +77,33 @@ protected:
                   half_edge_length;
 public:
   AxisAlignedBoundingBox(Vector<FLOAT,N> center, Vector<FLOAT,N> half_edge_length);
+
+  // creates the aabb spanned by the corners minimum and maximum
+  static AxisAlignedBoundingBox<FLOAT,N> from_corners(Vector<FLOAT,N> minimum, Vector<FLOAT,N> maximum);
+
+  // returns the corner with the smallest coordinates on each axis
+  Vector<FLOAT,N> minimum() const;
+
+  // returns the corner with the largest coordinates on each axis
+  Vector<FLOAT,N> maximum() const;
+
+  Vector<FLOAT,N> get_center() const;
+
+  // returns the smallest aabb containing this and the given aabb
+  AxisAlignedBoundingBox<FLOAT,N> merge(AxisAlignedBoundingBox<FLOAT,N> aabb) const;
+
+  // returns the surface area of this aabb (the perimeter in the two-dimensional case)
+  FLOAT surface_area() const;
+
   bool intersects(AxisAlignedBoundingBox<FLOAT,N> aabb) const;
 
-  // checks if this aabb is intersected by the given ray
+  // checks if this aabb is intersected by the given ray (for any t, also behind the origin)
   bool intersects(Ray<FLOAT,N> ray) const;
 
+  // checks if this aabb is intersected by the ray of the query for some query.tmin <= t <= query.tmax
+  // entry is set to the smallest such t
+  bool intersects(const Ray_Query<FLOAT,N> &query, FLOAT &entry) const;
+
   // checks if an intersection exists with an aabb moving in the given direction
   bool intersects(AxisAlignedBoundingBox<FLOAT,N> aabb, Vector<FLOAT, N> direction) const;
   
@@ -92,13 +130,34 @@ public:
 
   // returns a value t such that ray.origin + t * ray.direction is the intersection point
   // t is zero if no intersection occurred
+  // only t is computed (one square root), finalize computes the intersection point and normal of the closest hit
   FLOAT intersects(const Ray<FLOAT, N> &ray) const;
 
+  // returns true iff the ray of the query intersects this sphere at some query.tmin < t < query.tmax and lowers
+  // query.tmax to the smallest such t (the far intersection if the near one lies before tmin, e.g. inside the sphere)
+  bool intersects(Ray_Query<FLOAT, N> &query) const;
+
+  // sets context like intersects(ray, context) for the intersection at t found by intersects(ray) or
+  // intersects(query) (or by the kernels of SphereSoA), one square root for the normal
+  // the normal is flipped if the ray leaves the sphere at t, i.e. if it runs inside the sphere before t
+  void finalize(const Ray<FLOAT, N> &ray, FLOAT t, Intersection_Context<FLOAT, N> & context) const;
+
   // returns true iff this Sphere intersects with the given sphere
   bool intersects(Sphere<FLOAT, N> sphere) const;
   
   // returns true iff the given point is inside this Sphere or on its surface
   bool inside(const Vector<FLOAT, N> p) const;
+
+  // returns the smallest aabb containing this Sphere
+  AxisAlignedBoundingBox<FLOAT, N> bounding_box() const;
+
+  Vector<FLOAT, N> get_center() const;
+
+  FLOAT get_radius() const;
+
+private:
+  // the test of intersects(query) for the given ray and interval
+  bool intersects(const Ray<FLOAT, N> &ray, FLOAT tmin, FLOAT &tmax) const;
 };
 
 template <class FLOAT, size_t N>
@@ -132,12 +191,97 @@ public:
   //   context.t is set to a value with intersection = ray.origin + t * ray.direction
   //   context.normal points away from the surface (clockwise order of a,b, and c)
   bool intersects(const Ray<FLOAT, N> &ray, Intersection_Context<FLOAT, N> & context) const;
+
+  // returns true iff the ray of the query intersects this Triangle at some query.tmin < t < query.tmax and lowers
+  // query.tmax to t, hits outside of the interval are rejected before the edge tests
+  // neither the intersection point nor u and v are kept (no square roots), see finalize
+  bool intersects(Ray_Query<FLOAT, N> &query) const;
+
+  // sets context like intersects(ray, context) for the intersection at t found by intersects(query)
+  void finalize(const Ray<FLOAT, N> &ray, FLOAT t, Intersection_Context<FLOAT, N> & context) const;
+
+  // returns the smallest aabb containing this Triangle
+  AxisAlignedBoundingBox<FLOAT, N> bounding_box() const;
+
+  Vector<FLOAT, N> get_a() const;
+
+  Vector<FLOAT, N> get_b() const;
+
+  Vector<FLOAT, N> get_c() const;
+};
+
+// an infinite plane, the points p with normal * p == distance
+// e.g. a wall, which as a huge sphere would cost a quadratic solve per ray and an aabb containing the whole scene
+// planes have no bounding box, they are intersected outside of bounding volume hierarchies
+template <class FLOAT, size_t N>
+class Plane {
+protected:
+  Vector<FLOAT,N> normal;  // normalized
+  FLOAT distance;          // the signed distance of the plane from the origin along normal
+public:
+  // creates the plane with the given normal (normalized by the constructor) and distance from the origin
+  Plane(Vector<FLOAT,N> normal, FLOAT distance);
+
+  // returns true iff the given ray intersects this plane
+  // context.normal is set to the plane's normal facing towards the ray origin, context.t and context.intersection
+  // as for spheres
+  bool intersects(const Ray<FLOAT, N> &ray, Intersection_Context<FLOAT, N> & context) const;
+
+  // returns true iff the ray of the query intersects this plane at some query.tmin < t < query.tmax and lowers
+  // query.tmax to t, two dot products and a division (rays parallel to the plane give t = +-inf or NaN, rejected by
+  // the interval test)
+  bool intersects(Ray_Query<FLOAT, N> &query) const;
+
+  // sets context like intersects(ray, context) for the intersection at t found by intersects(query)
+  void finalize(const Ray<FLOAT, N> &ray, FLOAT t, Intersection_Context<FLOAT, N> & context) const;
+
+  Vector<FLOAT, N> get_normal() const;
+
+  FLOAT get_distance() const;
+};
+
+// a parallelogram (a rectangle if the edges are orthogonal), the points corner + alpha * edge_u + beta * edge_v
+// with 0 <= alpha, beta <= 1
+template <class FLOAT, size_t N>
+class Quad {
+protected:
+  Vector<FLOAT,N> corner,
+                  edge_u,
+                  edge_v,
+                  normal,   // normalized, orthogonal to both edges
+                  dual_u,   // dual_u * edge_u == 1, dual_u * edge_v == 0, so alpha = dual_u * (p - corner)
+                  dual_v;   // the same for beta
+  FLOAT distance;           // normal * corner
+public:
+  // creates the quad with the given corner and edges, which must not be parallel
+  Quad(Vector<FLOAT,N> corner, Vector<FLOAT,N> edge_u, Vector<FLOAT,N> edge_v);
+
+  // returns true iff the given ray intersects this quad
+  // context.u and context.v are set to alpha and beta of the intersection, context.normal faces towards the ray
+  // origin, context.t and context.intersection as for spheres
+  bool intersects(const Ray<FLOAT, N> &ray, Intersection_Context<FLOAT, N> & context) const;
+
+  // returns true iff the ray of the query intersects this quad at some query.tmin < t < query.tmax and lowers
+  // query.tmax to t, the plane test plus two dot products for alpha and beta
+  bool intersects(Ray_Query<FLOAT, N> &query) const;
+
+  // sets context like intersects(ray, context) for the intersection at t found by intersects(query)
+  void finalize(const Ray<FLOAT, N> &ray, FLOAT t, Intersection_Context<FLOAT, N> & context) const;
+
+  // returns the smallest aabb containing this Quad
+  AxisAlignedBoundingBox<FLOAT, N> bounding_box() const;
+
+  Vector<FLOAT, N> get_corner() const;
+
+  Vector<FLOAT, N> get_normal() const;
 };
 
 
 typedef Ray<float, 2u> Ray2df;
 typedef Ray<float, 3u> Ray3df;
 
+typedef Ray_Query<float, 3u> Ray_Query3df;
+
 typedef AxisAlignedBoundingBox<float, 2u> AABB2df;
 typedef AxisAlignedBoundingBox<float, 3u> AABB3df;
 
@@ -146,5 +290,10 @@ typedef Sphere<float, 3u> Sphere3df;
 
 typedef Triangle<float, 3u> Triangle3df;
 
+typedef Plane<float, 2u> Plane2df;
+typedef Plane<float, 3u> Plane3df;
+
+typedef Quad<float, 3u> Quad3df;
+
 
 #endif
@@ -1,4 +1,5 @@
 #include "geometry.h"
+#include <algorithm>
 
 template <class FLOAT, size_t N>
 AxisAlignedBoundingBox<FLOAT, N>::AxisAlignedBoundingBox(Vector<FLOAT,N> center, Vector<FLOAT,N> half_edge_length)
@@ -6,6 +7,50 @@ AxisAlignedBoundingBox<FLOAT, N>::AxisAlignedBoundingBox(Vector<FLOAT,N> center,
 {
 }
 
+template <class FLOAT, size_t N>
+AxisAlignedBoundingBox<FLOAT, N> AxisAlignedBoundingBox<FLOAT, N>::from_corners(Vector<FLOAT,N> minimum, Vector<FLOAT,N> maximum) {
+  return AxisAlignedBoundingBox<FLOAT, N>(static_cast<FLOAT>(0.5) * (minimum + maximum), static_cast<FLOAT>(0.5) * (maximum - minimum));
+}
+
+template <class FLOAT, size_t N>
+Vector<FLOAT, N> AxisAlignedBoundingBox<FLOAT, N>::minimum() const {
+  return center - half_edge_length;
+}
+
+template <class FLOAT, size_t N>
+Vector<FLOAT, N> AxisAlignedBoundingBox<FLOAT, N>::maximum() const {
+  return center + half_edge_length;
+}
+
+template <class FLOAT, size_t N>
+Vector<FLOAT, N> AxisAlignedBoundingBox<FLOAT, N>::get_center() const {
+  return center;
+}
+
+template <class FLOAT, size_t N>
+AxisAlignedBoundingBox<FLOAT, N> AxisAlignedBoundingBox<FLOAT, N>::merge(AxisAlignedBoundingBox<FLOAT,N> aabb) const {
+  Vector<FLOAT, N> lower = minimum(),
+                   upper = maximum();
+  for (size_t i = 0; i < N; i++) {
+    lower[i] = std::min(lower[i], aabb.center[i] - aabb.half_edge_length[i]);
+    upper[i] = std::max(upper[i], aabb.center[i] + aabb.half_edge_length[i]);
+  }
+  return from_corners(lower, upper);
+}
+
+template <class FLOAT, size_t N>
+FLOAT AxisAlignedBoundingBox<FLOAT, N>::surface_area() const {
+  // two faces perpendicular to each axis i, spanned by the edges of the remaining axes
+  FLOAT area = 0.0;
+  for (size_t i = 0; i < N; i++) {
+    FLOAT face = 1.0;
+    for (size_t j = 0; j < N; j++) {
+      face *= (j != i) ? static_cast<FLOAT>(2.0) * half_edge_length[j] : static_cast<FLOAT>(1.0);
+    }
+    area += static_cast<FLOAT>(2.0) * face;
+  }
+  return area;
+}
 
 template <class FLOAT, size_t N>
 bool AxisAlignedBoundingBox<FLOAT, N>::intersects(AxisAlignedBoundingBox<FLOAT,N> aabb) const {
@@ -19,18 +64,26 @@ bool AxisAlignedBoundingBox<FLOAT, N>::intersects(AxisAlignedBoundingBox<FLOAT,N
 
 template <class FLOAT, size_t N>
 bool AxisAlignedBoundingBox<FLOAT, N>::intersects(Ray<FLOAT,N> ray) const {
-    FLOAT tmin;
-    FLOAT tmax;
-    FLOAT tminimum = -INFINITY;
-    FLOAT tmaximum = INFINITY;
-    
+    FLOAT entry;
+    return intersects(Ray_Query<FLOAT, N>(ray, -INFINITY, INFINITY), entry);
+}
+
+template <class FLOAT, size_t N>
+bool AxisAlignedBoundingBox<FLOAT, N>::intersects(const Ray_Query<FLOAT,N> &query, FLOAT &entry) const {
+    FLOAT tmin = query.tmin,
+          tmax = query.tmax;
     for (size_t i = 0; i < N; i++) {
-      tmin = (center[i] - ray.origin[i] - half_edge_length[i]) / ray.direction[i];
-      tmax = (center[i] - ray.origin[i] + half_edge_length[i]) / ray.direction[i];
-      tminimum = std::max(tminimum, std::min(tmin, tmax) );
-      tmaximum = std::min(tmaximum, std::max(tmin, tmax) );      
+      // the sign of the direction tells which plane of the slab is entered first
+      FLOAT near = center[i] + (query.negative[i] ? half_edge_length[i] : -half_edge_length[i]),
+            far = center[i] + (query.negative[i] ? -half_edge_length[i] : half_edge_length[i]);
+      FLOAT t0 = (near - query.ray.origin[i]) * query.inverse_direction[i],
+            t1 = (far - query.ray.origin[i]) * query.inverse_direction[i];
+      // NaN distances (0 * inf for rays in the plane of a slab) never narrow the interval
+      tmin = t0 > tmin ? t0 : tmin;
+      tmax = t1 < tmax ? t1 : tmax;
     }
-    return tmaximum >= tminimum;
+    entry = tmin;
+    return tmin <= tmax;
 }
 
 
@@ -67,6 +120,16 @@ Vector<FLOAT, N> AxisAlignedBoundingBox<FLOAT, N>::sweep_intersects(AxisAlignedB
     return normal;
 }
 
+template <class FLOAT, size_t N>
+Ray_Query<FLOAT, N>::Ray_Query(const Ray<FLOAT,N> &ray, FLOAT tmin, FLOAT tmax)
+ : ray(ray), tmin(tmin), tmax(tmax), inverse_direction(ray.direction)
+{
+  for (size_t i = 0; i < N; i++) {
+    inverse_direction[i] = static_cast<FLOAT>(1.0) / ray.direction[i];
+    negative[i] = inverse_direction[i] < 0;
+  }
+}
+
 template <class FLOAT, size_t N>
 Sphere<FLOAT,N>::Sphere(Vector<FLOAT,N> center, FLOAT radius)
  : center(center), radius(radius)
@@ -82,6 +145,22 @@ bool Sphere<FLOAT, N>::inside(const Vector<FLOAT, N> p) const {
     return false;
 }
 
+template<class FLOAT, size_t N>
+AxisAlignedBoundingBox<FLOAT, N> Sphere<FLOAT, N>::bounding_box() const {
+    Vector<FLOAT, N> half_edge_length = {radius};
+    return AxisAlignedBoundingBox<FLOAT, N>(center, half_edge_length);
+}
+
+template<class FLOAT, size_t N>
+Vector<FLOAT, N> Sphere<FLOAT, N>::get_center() const {
+    return center;
+}
+
+template<class FLOAT, size_t N>
+FLOAT Sphere<FLOAT, N>::get_radius() const {
+    return radius;
+}
+
 template<class FLOAT, size_t N>
 bool Sphere<FLOAT, N>::intersects(Sphere<FLOAT, N> sphere) const {
     Vector distanceVector = this->center - sphere.center;
@@ -98,19 +177,34 @@ bool Sphere<FLOAT, N>::intersects(Sphere<FLOAT, N> sphere) const {
 
 template <class FLOAT, size_t N>
 FLOAT Sphere<FLOAT,N>::intersects(const Ray<FLOAT, N> &ray) const {
+  FLOAT t = std::numeric_limits<FLOAT>::max();
+  return intersects(ray, 0, t) ? t : 0;
+}
+
+template <class FLOAT, size_t N>
+bool Sphere<FLOAT,N>::intersects(Ray_Query<FLOAT, N> &query) const {
+  return intersects(query.ray, query.tmin, query.tmax);
+}
+
+template <class FLOAT, size_t N>
+bool Sphere<FLOAT,N>::intersects(const Ray<FLOAT, N> &ray, FLOAT tmin, FLOAT &tmax) const {
   Vector<FLOAT,N> om = ray.origin - center;
   FLOAT  a = ray.direction * ray.direction,
          b = 2.0 * (om * ray.direction),
          c = om * om - radius * radius,
          d = b * b - 4.0 * a * c;
   if (d < 0) {
-   return 0;
+   return false;
   }
   d = sqrt(d);
-  if ( inside( ray.origin ) ) {
-    return 0.5 * std::max(-b + d, -b - d) / a;
+  // the near intersection (-b - d) / 2a, or the far one if the near one lies before tmin (a > 0)
+  FLOAT near = -b - d;
+  FLOAT t = 0.5 * (0.5 * near > tmin * a ? near : -b + d) / a;
+  if ( !(tmin < t && t < tmax) ) {
+    return false;
   }
-  return 0.5 * std::min( std::max<FLOAT>(0.0, (-b + d)) , (-b - d) ) / a; 
+  tmax = t;
+  return true;
 }
 
 template <class FLOAT, size_t N>
@@ -119,14 +213,19 @@ bool Sphere<FLOAT,N>::intersects(const Ray<FLOAT, N> &ray, Intersection_Context<
   if (t <= 0.0) {
     return false;
   }
+  finalize(ray, t, context);
+  return true;
+}
+
+template <class FLOAT, size_t N>
+void Sphere<FLOAT,N>::finalize(const Ray<FLOAT, N> &ray, FLOAT t, Intersection_Context<FLOAT, N> & context) const {
   context.t = t;
   context.intersection = ray.origin + t * ray.direction;
   context.normal = context.intersection - center;
   context.normal.normalize();
-  if ( inside( ray.origin ) ) {
-    context.normal = static_cast<FLOAT>(-1.0) * context.normal; // ray starts inside sphere, normal points to the inside;
+  if ( context.normal * ray.direction > 0 ) {
+    context.normal = static_cast<FLOAT>(-1.0) * context.normal; // ray leaves the sphere, normal points to the inside;
   }
-  return true;
 }
 
 template <class FLOAT, size_t N>
@@ -145,53 +244,217 @@ Triangle<FLOAT, N>::Triangle(Vector<FLOAT, N> a, Vector<FLOAT, N> b, Vector<FLOA
   
 template <class FLOAT, size_t N>
 bool Triangle<FLOAT, N>::intersects(const Ray<FLOAT, N> &ray, Intersection_Context<FLOAT, N> & context) const {
-  return intersects(ray, context.normal, context.intersection, context.u, context.v, context.t);
+  Ray_Query<FLOAT, N> query(ray);
+  if ( !intersects(query) ) {
+    return false;
+  }
+  finalize(ray, query.tmax, context);
+  return true;
 }
 
 
 template <class FLOAT, size_t N>
 bool Triangle<FLOAT, N>::intersects(const Ray<FLOAT, N> &ray, Vector<FLOAT, N> & normal, Vector<FLOAT, N> & p, FLOAT & u, FLOAT & v, FLOAT & t) const {
+    Intersection_Context<FLOAT, N> context;
+    if ( !intersects(ray, context) ) {
+      return false;
+    }
+    t = context.t;
+    normal = context.normal;
+    p = context.intersection;
+    u = context.u;
+    v = context.v;
+    return true;
+}
+
+template <class FLOAT, size_t N>
+bool Triangle<FLOAT, N>::intersects(Ray_Query<FLOAT, N> &query) const {
     const FLOAT EPSILON = 10e-7;
-    normal =  (b-a).cross_product(c-a);  // points away from triangle surface (clockwise order)
+    const Ray<FLOAT, N> &ray = query.ray;
+    Vector<FLOAT, N> normal =  (b-a).cross_product(c-a);  // points away from triangle surface (clockwise order)
 
     FLOAT normalRayProduct =  normal * ray.direction;
-    FLOAT area = normal.length(); // used for u-v-parameter calculation
-
 
     if ( fabs(normalRayProduct) < EPSILON ) { // backface culling off
       return false;
     }
 
     FLOAT d = normal * a;
-    t = (d - normal * ray.origin) / normalRayProduct;
+    FLOAT t = (d - normal * ray.origin) / normalRayProduct;
 
-    if ( t < 0.0 ) {
+    if ( !(query.tmin < t && t < query.tmax) ) {
       return false;
     }
    
-    p = ray.origin + t * ray.direction;
-   
-    Vector<FLOAT, N> vector = (b - a).cross_product(p - a );
-    if ( normal * vector < 0.0 ) { 
-      return false;
-    }
+    Vector<FLOAT, N> p = ray.origin + t * ray.direction;
 
-    
-    vector = (c - b).cross_product(p - b );
-    if ( normal * vector < 0.0 ) { 
+    // p lies inside if it is on the inner side of all three edges
+    if ( normal * (b - a).cross_product(p - a) < 0.0
+         || normal * (c - b).cross_product(p - b) < 0.0
+         || normal * (a - c).cross_product(p - c) < 0.0 ) {
       return false;
     }
+    query.tmax = t;
+    return true;
+}
+
+template <class FLOAT, size_t N>
+void Triangle<FLOAT, N>::finalize(const Ray<FLOAT, N> &ray, FLOAT t, Intersection_Context<FLOAT, N> & context) const {
+    context.t = t;
+    context.normal = (b-a).cross_product(c-a);
+    context.intersection = ray.origin + t * ray.direction;
+
+    FLOAT area = context.normal.length(); // used for u-v-parameter calculation
+    context.u = (c - b).cross_product(context.intersection - b).length() / area;
+    context.v = (a - c).cross_product(context.intersection - c).length() / area;
+}
 
-    u = vector.length()  / area;
+template <class FLOAT, size_t N>
+Vector<FLOAT, N> Triangle<FLOAT, N>::get_a() const {
+  return a;
+}
 
-    vector = (a-c).cross_product(p - c );
-    if (normal * vector < 0.0 ) {
-      return false;
-    }
+template <class FLOAT, size_t N>
+Vector<FLOAT, N> Triangle<FLOAT, N>::get_b() const {
+  return b;
+}
 
-    v = vector.length() / area;
+template <class FLOAT, size_t N>
+Vector<FLOAT, N> Triangle<FLOAT, N>::get_c() const {
+  return c;
+}
 
-    return true;
+template <class FLOAT, size_t N>
+AxisAlignedBoundingBox<FLOAT, N> Triangle<FLOAT, N>::bounding_box() const {
+  Vector<FLOAT, N> lower = a,
+                   upper = a;
+  for (size_t i = 0; i < N; i++) {
+    lower[i] = std::min({a[i], b[i], c[i]});
+    upper[i] = std::max({a[i], b[i], c[i]});
+  }
+  return AxisAlignedBoundingBox<FLOAT, N>::from_corners(lower, upper);
+}
+
+template <class FLOAT, size_t N>
+Plane<FLOAT, N>::Plane(Vector<FLOAT, N> normal, FLOAT distance)
+  : normal(normal), distance(distance) {
+  this->normal.normalize();
+}
+
+template <class FLOAT, size_t N>
+bool Plane<FLOAT, N>::intersects(const Ray<FLOAT, N> &ray, Intersection_Context<FLOAT, N> & context) const {
+  Ray_Query<FLOAT, N> query(ray);
+  if ( !intersects(query) ) {
+    return false;
+  }
+  finalize(ray, query.tmax, context);
+  return true;
+}
+
+template <class FLOAT, size_t N>
+bool Plane<FLOAT, N>::intersects(Ray_Query<FLOAT, N> &query) const {
+  FLOAT t = (distance - normal * query.ray.origin) / (normal * query.ray.direction);
+  if ( !(query.tmin < t && t < query.tmax) ) {
+    return false;
+  }
+  query.tmax = t;
+  return true;
+}
+
+template <class FLOAT, size_t N>
+void Plane<FLOAT, N>::finalize(const Ray<FLOAT, N> &ray, FLOAT t, Intersection_Context<FLOAT, N> & context) const {
+  context.t = t;
+  context.intersection = ray.origin + t * ray.direction;
+  context.normal = normal;
+  if ( normal * ray.direction > 0 ) {
+    context.normal = static_cast<FLOAT>(-1.0) * normal; // the ray hits the back side
+  }
+}
+
+template <class FLOAT, size_t N>
+Vector<FLOAT, N> Plane<FLOAT, N>::get_normal() const {
+  return normal;
+}
+
+template <class FLOAT, size_t N>
+FLOAT Plane<FLOAT, N>::get_distance() const {
+  return distance;
+}
+
+template <class FLOAT, size_t N>
+Quad<FLOAT, N>::Quad(Vector<FLOAT, N> corner, Vector<FLOAT, N> edge_u, Vector<FLOAT, N> edge_v)
+  : corner(corner), edge_u(edge_u), edge_v(edge_v),
+    normal(cross(edge_u, edge_v)),
+    dual_u{}, dual_v{} {
+  normal.normalize();
+  distance = normal * corner;
+  // the inverse of the gram matrix of the edges maps the products with the edges to alpha and beta
+  FLOAT uu = edge_u * edge_u,
+        uv = edge_u * edge_v,
+        vv = edge_v * edge_v;
+  FLOAT inverse_determinant = static_cast<FLOAT>(1.0) / (uu * vv - uv * uv);
+  dual_u = inverse_determinant * (vv * edge_u - uv * edge_v);
+  dual_v = inverse_determinant * (uu * edge_v - uv * edge_u);
+}
+
+template <class FLOAT, size_t N>
+bool Quad<FLOAT, N>::intersects(const Ray<FLOAT, N> &ray, Intersection_Context<FLOAT, N> & context) const {
+  Ray_Query<FLOAT, N> query(ray);
+  if ( !intersects(query) ) {
+    return false;
+  }
+  finalize(ray, query.tmax, context);
+  return true;
+}
+
+template <class FLOAT, size_t N>
+bool Quad<FLOAT, N>::intersects(Ray_Query<FLOAT, N> &query) const {
+  FLOAT t = (distance - normal * query.ray.origin) / (normal * query.ray.direction);
+  if ( !(query.tmin < t && t < query.tmax) ) {
+    return false;
+  }
+  Vector<FLOAT, N> p = query.ray.origin + t * query.ray.direction - corner;
+  FLOAT alpha = dual_u * p,
+        beta = dual_v * p;
+  if ( alpha < 0 || alpha > 1 || beta < 0 || beta > 1 ) {
+    return false;
+  }
+  query.tmax = t;
+  return true;
+}
+
+template <class FLOAT, size_t N>
+void Quad<FLOAT, N>::finalize(const Ray<FLOAT, N> &ray, FLOAT t, Intersection_Context<FLOAT, N> & context) const {
+  context.t = t;
+  context.intersection = ray.origin + t * ray.direction;
+  context.u = dual_u * (context.intersection - corner);
+  context.v = dual_v * (context.intersection - corner);
+  context.normal = normal;
+  if ( normal * ray.direction > 0 ) {
+    context.normal = static_cast<FLOAT>(-1.0) * normal; // the ray hits the back side
+  }
+}
+
+template <class FLOAT, size_t N>
+AxisAlignedBoundingBox<FLOAT, N> Quad<FLOAT, N>::bounding_box() const {
+  Vector<FLOAT, N> opposite = corner + edge_u + edge_v,
+                   lower = corner,
+                   upper = corner;
+  for (size_t i = 0; i < N; i++) {
+    lower[i] = std::min({corner[i], corner[i] + edge_u[i], corner[i] + edge_v[i], opposite[i]});
+    upper[i] = std::max({corner[i], corner[i] + edge_u[i], corner[i] + edge_v[i], opposite[i]});
+  }
+  return AxisAlignedBoundingBox<FLOAT, N>::from_corners(lower, upper);
+}
+
+template <class FLOAT, size_t N>
+Vector<FLOAT, N> Quad<FLOAT, N>::get_corner() const {
+  return corner;
+}
+
+template <class FLOAT, size_t N>
+Vector<FLOAT, N> Quad<FLOAT, N>::get_normal() const {
+  return normal;
 }
 
 template <class FLOAT, size_t N>
@@ -0,0 +1,136 @@
+#include "geometry.h"
+#include "random_spheres.h"
+#include "benchmark/benchmark.h"
+#include <random>
+#include <vector>
+
+namespace {
+
+// 1024 rays from random origins near the coordinate origin in random directions, the same for every run
+std::vector<Ray3df> random_rays(unsigned seed) {
+  std::mt19937 generator(seed);
+  std::uniform_real_distribution<float> origin(-1.f, 1.f), direction(-1.f, 1.f);
+  std::vector<Ray3df> rays;
+  for (int i = 0; i < 1024; i++) {
+    rays.push_back(Ray3df{{origin(generator), origin(generator), origin(generator)},
+                          {direction(generator), direction(generator), direction(generator)}});
+  }
+  return rays;
+}
+
+// 1024 random triangles in planes z = const (Triangle::intersects is exact for those)
+std::vector<Triangle3df> random_triangles(unsigned seed) {
+  std::mt19937 generator(seed);
+  std::uniform_real_distribution<float> coordinate(-5.f, 5.f);
+  std::vector<Triangle3df> triangles;
+  for (int i = 0; i < 1024; i++) {
+    float z = coordinate(generator);
+    triangles.push_back(Triangle3df({coordinate(generator), coordinate(generator), z},
+                                    {coordinate(generator), coordinate(generator), z},
+                                    {coordinate(generator), coordinate(generator), z}));
+  }
+  return triangles;
+}
+
+// every benchmark performs one test per iteration with the next ray and primitive, items are tests
+
+void BM_SphereIntersects(benchmark::State & state) {
+  std::vector<Ray3df> rays = random_rays(1);
+  // around the coordinate origin, roughly half of the random rays hit each of them
+  std::vector<Sphere3df> spheres = random_spheres(1024, 2, 5.f, 1.f, 4.f);
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(spheres[i & 1023u].intersects(rays[i & 1023u]));
+    i++;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SphereIntersects);
+
+// including intersection point and normal
+void BM_SphereIntersectsContext(benchmark::State & state) {
+  std::vector<Ray3df> rays = random_rays(1);
+  std::vector<Sphere3df> spheres = random_spheres(1024, 2, 5.f, 1.f, 4.f);
+  Intersection_Context<float, 3u> context;
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(spheres[i & 1023u].intersects(rays[i & 1023u], context));
+    i++;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SphereIntersectsContext);
+
+void BM_TriangleIntersects(benchmark::State & state) {
+  std::vector<Ray3df> rays = random_rays(1);
+  std::vector<Triangle3df> triangles = random_triangles(3);
+  Intersection_Context<float, 3u> context;
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(triangles[i & 1023u].intersects(rays[i & 1023u], context));
+    i++;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TriangleIntersects);
+
+void BM_AABBIntersects(benchmark::State & state) {
+  std::vector<Ray3df> rays = random_rays(1);
+  std::vector<Sphere3df> spheres = random_spheres(1024, 2, 5.f, 1.f, 4.f);
+  std::vector<AABB3df> boxes;
+  for (const Sphere3df & sphere : spheres) {
+    boxes.push_back(sphere.bounding_box());
+  }
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(boxes[i & 1023u].intersects(rays[i & 1023u]));
+    i++;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_AABBIntersects);
+
+// the slab test used by the bvh traversal, with the inverse direction computed once per ray
+void BM_AABBIntersectsSlab(benchmark::State & state) {
+  std::vector<Ray_Query3df> queries;
+  for (const Ray3df & ray : random_rays(1)) {
+    queries.push_back(Ray_Query3df(ray, 0.f, 1000.f));
+  }
+  std::vector<Sphere3df> spheres = random_spheres(1024, 2, 5.f, 1.f, 4.f);
+  std::vector<AABB3df> boxes;
+  for (const Sphere3df & sphere : spheres) {
+    boxes.push_back(sphere.bounding_box());
+  }
+  float entry;
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(boxes[i & 1023u].intersects(queries[i & 1023u], entry));
+    i++;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_AABBIntersectsSlab);
+
+void BM_Refract(benchmark::State & state) {
+  std::vector<Ray3df> rays = random_rays(1);
+  std::vector<Vector3df> directions, normals;
+  for (const Ray3df & ray : rays) {
+    Vector3df direction = ray.direction,
+              normal = ray.origin;
+    direction.normalize();
+    normal.normalize();
+    directions.push_back(direction);
+    normals.push_back(normal);
+  }
+  Vector3df transmission = {0.f, 0.f, 0.f};
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(refract(0.7f, normals[i & 1023u], directions[i & 1023u], transmission));
+    benchmark::DoNotOptimize(transmission);
+    i++;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Refract);
+
+}
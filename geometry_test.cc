@@ -12,6 +12,35 @@ TEST(RAY, ListInitialization2df) {
   EXPECT_NEAR(0.0, ray.direction[1], 0.00001);
 }
 
+TEST(RAY_QUERY, InverseDirection) {
+  Ray3df ray = { {1.0f, 2.0f, 3.0f}, {2.0f, -4.0f, 0.0f} };
+  Ray_Query3df query(ray, 0.5f, 10.0f);
+
+  EXPECT_EQ(0.5f, query.tmin);
+  EXPECT_EQ(10.0f, query.tmax);
+  EXPECT_EQ(0.5f, query.inverse_direction[0]);
+  EXPECT_EQ(-0.25f, query.inverse_direction[1]);
+  EXPECT_FALSE(query.negative[0]);
+  EXPECT_TRUE(query.negative[1]);
+  EXPECT_FALSE(query.negative[2]);
+  EXPECT_EQ(0.0f, Ray_Query3df(ray).tmin);
+}
+
+TEST(AABB, IntersectsQuery) {
+  AABB3df box = { {0.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 1.0f} };
+  Ray3df ray = { {-3.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f} };
+  float entry;
+
+  EXPECT_TRUE( box.intersects(Ray_Query3df(ray), entry) );
+  EXPECT_NEAR(2.0, entry, 0.00001);
+  // the interval ends before the box or starts behind it
+  EXPECT_FALSE( box.intersects(Ray_Query3df(ray, 0.0f, 1.5f), entry) );
+  EXPECT_FALSE( box.intersects(Ray_Query3df(ray, 4.5f), entry) );
+  // the interval starts inside the box
+  EXPECT_TRUE( box.intersects(Ray_Query3df(ray, 3.0f), entry) );
+  EXPECT_NEAR(3.0, entry, 0.00001);
+}
+
 TEST(AABB, Intersects2df_1) {
   AABB2df box1 = { {0.0, 0.0}, {1.0, 1.0} };
   AABB2df box2 = { {0.5, -0.5}, {0.5, 0.5} };
@@ -265,6 +294,49 @@ TEST(SPHERE, Intersects3dfWithRay_7) {
   EXPECT_TRUE( sphere.intersects(ray, context) );
 }
 
+TEST(SPHERE, FinalizeMatchesIntersects) {
+  Sphere3df sphere = { {3.0f, 3.0f, 0.0f}, 3.0f };
+  // from outside and from inside the sphere
+  for (const Ray3df & ray : { Ray3df{ {-2.0f, 1.0f, 0.5f}, {1.0f, 0.25f, 0.0f} }, Ray3df{ {3.5f, 3.0f, 0.0f}, {1.0f, 0.5f, 0.0f} } }) {
+    Intersection_Context<float,3u> expected, actual;
+    ASSERT_TRUE( sphere.intersects(ray, expected) );
+    sphere.finalize(ray, sphere.intersects(ray), actual);
+
+    EXPECT_EQ( expected.t, actual.t );
+    for (size_t k = 0; k < 3; k++) {
+      EXPECT_EQ( expected.intersection[k], actual.intersection[k] );
+      EXPECT_EQ( expected.normal[k], actual.normal[k] );
+    }
+  }
+  // the normal points to the inside for rays starting inside the sphere
+  Intersection_Context<float,3u> context;
+  sphere.finalize(Ray3df{ {3.0f, 3.0f, 0.0f}, {1.0f, 0.0f, 0.0f} }, 3.0f, context);
+  EXPECT_NEAR(-1.0, context.normal[0], 0.000001 );
+}
+
+TEST(SPHERE, IntersectsQuery) {
+  Sphere3df sphere = { {0.0f, 0.0f, 0.0f}, 1.0f };
+  Ray3df ray = { {-3.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f} };
+
+  Ray_Query3df query(ray);
+  EXPECT_TRUE( sphere.intersects(query) );
+  EXPECT_NEAR(2.0, query.tmax, 0.00001);
+  // the near intersection is skipped if it lies before tmin
+  Ray_Query3df behind(ray, 2.5f);
+  EXPECT_TRUE( sphere.intersects(behind) );
+  EXPECT_NEAR(4.0, behind.tmax, 0.00001);
+  // no intersection within the interval leaves it unchanged
+  Ray_Query3df closer(ray, 0.0f, 1.5f), farther(ray, 4.5f);
+  EXPECT_FALSE( sphere.intersects(closer) );
+  EXPECT_EQ(1.5f, closer.tmax);
+  EXPECT_FALSE( sphere.intersects(farther) );
+
+  // a ray leaving the surface does not hit it again
+  Ray3df reflected = { {-1.0f, 0.0f, 0.0f}, {-1.0f, 0.5f, 0.0f} };
+  Ray_Query3df leaving(reflected, 0.001f);
+  EXPECT_FALSE( sphere.intersects(leaving) );
+}
+
 TEST(SPHERE, Inside_1) {
   Sphere3df sphere = { {3.0f, 3.0f, 0.0f}, 3.0f };
 
@@ -305,6 +377,36 @@ TEST(TRIANGLE, Intersects3dfWithRay_1) {
   EXPECT_NEAR(0.0, context.v, 0.000001 );
 }
 
+TEST(TRIANGLE, IntersectsQuery) {
+  Triangle3df triangle = { {-2.0f, -1.0f, 0.0f}, {0.0f, 2.0f, 0.0f}, { 2.0, 0.0, 0.0} };
+  Ray3df hit{ {-2.0, 0.0, 2.0}, {1.0, 0.0, -1.0} },
+         miss{ {-2.0, 0.0, 2.0}, {-1.0, 0.0, -1.0} };
+
+  Ray_Query3df query(hit);
+  EXPECT_TRUE( triangle.intersects(query) );
+  EXPECT_NEAR(2.0, query.tmax, 0.00001);
+  Ray_Query3df missing(miss);
+  EXPECT_FALSE( triangle.intersects(missing) );
+
+  // hits outside of the interval are rejected and leave it unchanged
+  Ray_Query3df closer(hit, 0.f, 1.5f),
+               farther(hit, 2.5f);
+  EXPECT_FALSE( triangle.intersects(closer) );
+  EXPECT_EQ(1.5f, closer.tmax);
+  EXPECT_FALSE( triangle.intersects(farther) );
+
+  Intersection_Context<float,3u> expected, actual;
+  ASSERT_TRUE( triangle.intersects(hit, expected) );
+  triangle.finalize(hit, query.tmax, actual);
+  EXPECT_EQ( expected.t, actual.t );
+  EXPECT_EQ( expected.u, actual.u );
+  EXPECT_EQ( expected.v, actual.v );
+  for (size_t k = 0; k < 3; k++) {
+    EXPECT_EQ( expected.intersection[k], actual.intersection[k] );
+    EXPECT_EQ( expected.normal[k], actual.normal[k] );
+  }
+}
+
 TEST(TRIANGLE, Intersects3dfWithRay_2) {
   Triangle3df triangle = { {0.0, 0.0, 0.0}, {0.0, 3.0, 0.0},{3.0, 0.0, 0.0}  };
   Ray3df ray{ {1.0, 1.0, 2.0}, {0.0, 0.0, -1.0} };
@@ -439,6 +541,79 @@ TEST(TRIANGLE, Intersects3dfWithRay_10) {
   EXPECT_TRUE(triangle1.intersects(ray, normal, intersection, u, v, t) );
 }
 
+TEST(PLANE, IntersectsQuery) {
+  Plane3df plane = { {0.0f, 0.0f, 2.0f}, -30.0f };
+  Ray3df ray = { {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, -2.0f} };
+
+  EXPECT_EQ(1.0f, plane.get_normal()[2]);
+  Ray_Query3df query(ray);
+  EXPECT_TRUE( plane.intersects(query) );
+  EXPECT_NEAR(15.0, query.tmax, 0.00001);
+  Ray_Query3df closer(ray, 0.0f, 10.0f), farther(ray, 20.0f);
+  EXPECT_FALSE( plane.intersects(closer) );
+  EXPECT_EQ(10.0f, closer.tmax);
+  EXPECT_FALSE( plane.intersects(farther) );
+  // parallel to the plane and pointing away from it
+  Ray_Query3df parallel(Ray3df{ {0.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f} }),
+               away(Ray3df{ {0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 1.0f} });
+  EXPECT_FALSE( plane.intersects(parallel) );
+  EXPECT_FALSE( plane.intersects(away) );
+}
+
+TEST(PLANE, NormalFacesTheRay) {
+  Plane3df plane = { {0.0f, 1.0f, 0.0f}, -12.0f };
+  Intersection_Context<float,3u> above, below;
+
+  ASSERT_TRUE( plane.intersects(Ray3df{ {0.0f, 0.0f, 0.0f}, {1.0f, -1.0f, 0.0f} }, above) );
+  EXPECT_NEAR(12.0, above.t, 0.00001);
+  EXPECT_NEAR(12.0, above.intersection[0], 0.00001);
+  EXPECT_NEAR(-12.0, above.intersection[1], 0.00001);
+  EXPECT_EQ(1.0f, above.normal[1]);
+  ASSERT_TRUE( plane.intersects(Ray3df{ {0.0f, -20.0f, 0.0f}, {0.0f, 1.0f, 0.0f} }, below) );
+  EXPECT_EQ(-1.0f, below.normal[1]);
+}
+
+TEST(QUAD, IntersectsQuery) {
+  Quad3df quad = { {-1.0f, -1.0f, -5.0f}, {2.0f, 0.0f, 0.0f}, {1.0f, 2.0f, 0.0f} };
+
+  for (float x : {-0.5f, 0.0f, 1.25f}) {
+    Ray_Query3df query(Ray3df{ {x, 0.0f, 0.0f}, {0.0f, 0.0f, -1.0f} });
+    EXPECT_TRUE( quad.intersects(query) ) << x;
+    EXPECT_NEAR(5.0, query.tmax, 0.00001);
+  }
+  // outside of the slanted edges and behind the interval
+  for (float x : {-0.75f, 1.75f}) {
+    Ray_Query3df query(Ray3df{ {x, 0.0f, 0.0f}, {0.0f, 0.0f, -1.0f} });
+    EXPECT_FALSE( quad.intersects(query) ) << x;
+  }
+  Ray_Query3df closer(Ray3df{ {0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, -1.0f} }, 0.0f, 4.0f);
+  EXPECT_FALSE( quad.intersects(closer) );
+}
+
+TEST(QUAD, IntersectsWithContext) {
+  Quad3df quad = { {-1.0f, -1.0f, -5.0f}, {2.0f, 0.0f, 0.0f}, {0.0f, 4.0f, 0.0f} };
+  Intersection_Context<float,3u> context;
+
+  ASSERT_TRUE( quad.intersects(Ray3df{ {0.5f, 2.0f, 0.0f}, {0.0f, 0.0f, -1.0f} }, context) );
+  EXPECT_NEAR(5.0, context.t, 0.00001);
+  EXPECT_NEAR(0.75, context.u, 0.00001);
+  EXPECT_NEAR(0.75, context.v, 0.00001);
+  EXPECT_NEAR(1.0, context.normal[2], 0.00001);
+  EXPECT_NEAR(-5.0, context.intersection[2], 0.00001);
+}
+
+TEST(QUAD, BoundingBox) {
+  Quad3df quad = { {-1.0f, -1.0f, -5.0f}, {2.0f, 0.0f, 1.0f}, {1.0f, 2.0f, 0.0f} };
+  AABB3df box = quad.bounding_box();
+
+  for (size_t k = 0; k < 3; k++) {
+    EXPECT_NEAR((Vector3df{-1.0f, -1.0f, -5.0f})[k], box.minimum()[k], 0.00001);
+    EXPECT_NEAR((Vector3df{2.0f, 1.0f, -4.0f})[k], box.maximum()[k], 0.00001);
+  }
+  EXPECT_NEAR(0.0f, quad.get_normal() * Vector3df({2.0f, 0.0f, 1.0f}), 0.00001);
+  EXPECT_NEAR(0.0f, quad.get_normal() * Vector3df({1.0f, 2.0f, 0.0f}), 0.00001);
+}
+
 TEST(FRESNEL, Refract_1) {
   Vector3df eye = {0.0f, 0.0f, 0.0f};
   Vector3df direction = {0.0f, -1.0f, 0.0f};
@@ -7,6 +7,8 @@
 #include <cmath>
 
 // A Vector consisting of N scalar values of type FLOAT_TYPE
+// the arithmetic operators are constexpr and defined in math.tcc, which is included at the end of this file,
+//   so that compound expressions like a + 0.01f * b are inlined into one pass without temporaries
 template<class FLOAT_TYPE, size_t N>
 struct Vector {
   static_assert(N > 0u); // no zero length vectors allowed
@@ -19,29 +21,29 @@ struct Vector {
   // if values is empty, then this->vector is initilized with zeros
   // if less than N values are given, then all remaining values of this->vector
   //   are initialized with the last given value 
-  Vector( std::initializer_list<FLOAT_TYPE> values );
+  constexpr Vector( std::initializer_list<FLOAT_TYPE> values );
   
   // creates a unit vector pointing to the given angle (in radians) in the x/y plane
   // angle = 0 points in the direction of the x-axis
   explicit Vector(FLOAT_TYPE angle);
 
   // adds addend to this Vector and returns the resulting sum
-  Vector & operator+=(const Vector addend);
+  constexpr Vector & operator+=(const Vector addend);
 
   // subtracts minuend from this Vector and returns the resulting difference
-  Vector & operator-=(const Vector minuend);
+  constexpr Vector & operator-=(const Vector minuend);
 
   // multiplies the scalar factor to this vector and returns the result
-  Vector & operator*=(const FLOAT_TYPE factor);
+  constexpr Vector & operator*=(const FLOAT_TYPE factor);
 
   // divides this vector by the given factor and returns the result
-  Vector & operator/=(const FLOAT_TYPE factor);
+  constexpr Vector & operator/=(const FLOAT_TYPE factor);
 
   // returns the reference of the i-th scalar component of this vector      
-  FLOAT_TYPE & operator[](std::size_t i);
+  constexpr FLOAT_TYPE & operator[](std::size_t i);
 
   // returns the i-th scalar component of this Vector
-  FLOAT_TYPE operator[](std::size_t i) const;
+  constexpr FLOAT_TYPE operator[](std::size_t i) const;
 
   // returns the i-th scalar component of this Vector
   // throws an exception if i >= N
@@ -63,28 +65,37 @@ struct Vector {
   
   // returns the scalar product of the given scalar and value
   template <class F, size_t K>    
-  friend Vector<F, K> operator*(F scalar, Vector<F, K> value);
+  friend constexpr Vector<F, K> operator*(F scalar, Vector<F, K> value);
 
   // returns the vector sum of the to given vectors
   template <class F, size_t K>    
-  friend Vector<F, K> operator+(const Vector<F, K> value, const Vector<F, K> addend);
+  friend constexpr Vector<F, K> operator+(const Vector<F, K> value, const Vector<F, K> addend);
 
   // returns the vector difference value - minuend
   template <class F, size_t K>    
-  friend Vector<F, K> operator-(const Vector<F, K> value, const Vector<F, K> minuend);
+  friend constexpr Vector<F, K> operator-(const Vector<F, K> value, const Vector<F, K> minuend);
 
   // returns the (euclidian) length of this Vector
   FLOAT_TYPE length() const;
   
   // returns the square of the this Vector's length
-  FLOAT_TYPE square_of_length() const;
+  constexpr FLOAT_TYPE square_of_length() const;
 
   // returns the scalar (inner) product of two Vectors
   template <class F, size_t K>    
-  friend F operator*(Vector<F, K> vector1, const Vector<F, K> vector2);
+  friend constexpr F operator*(Vector<F, K> vector1, const Vector<F, K> vector2);
 
 };
 
+// returns the cross product a x b of two three-dimensional Vectors
+// Vector::cross_product differs from it in the sign of the y component
+template <class F>
+constexpr Vector<F, 3u> cross(const Vector<F, 3u> a, const Vector<F, 3u> b);
+
+// Vector<float, 3u> and Vector<float, 4u> are specialized for SSE
+#include "math_sse.h"
+#include "math.tcc"
+
 static const long double PI = std::acos(-1.0L);
 
 // shorter comfortable type names
@@ -1,7 +1,7 @@
 #include <cassert>
 
 template <class FLOAT_TYPE, size_t N>
-Vector<FLOAT_TYPE, N>::Vector( std::initializer_list<FLOAT_TYPE> values ) {
+constexpr Vector<FLOAT_TYPE, N>::Vector( std::initializer_list<FLOAT_TYPE> values ) : vector{} {
   auto iterator = values.begin();
   for (size_t i = 0u; i < N; i++) {
     if ( iterator != values.end()) {
@@ -18,7 +18,7 @@ Vector<FLOAT_TYPE, N>::Vector(FLOAT_TYPE angle ) {
 }
 
 template <class FLOAT_TYPE, size_t N>  
-Vector<FLOAT_TYPE, N> & Vector<FLOAT_TYPE, N>::operator+=(const Vector<FLOAT_TYPE, N> addend) {
+constexpr Vector<FLOAT_TYPE, N> & Vector<FLOAT_TYPE, N>::operator+=(const Vector<FLOAT_TYPE, N> addend) {
   for (size_t i = 0u; i < N; i++) {
     vector[i] += addend.vector[i];
   }
@@ -26,7 +26,7 @@ Vector<FLOAT_TYPE, N> & Vector<FLOAT_TYPE, N>::operator+=(const Vector<FLOAT_TYP
 }
 
 template <class FLOAT_TYPE, size_t N>  
-Vector<FLOAT_TYPE, N> & Vector<FLOAT_TYPE, N>::operator-=(const Vector<FLOAT_TYPE, N> minuend) {
+constexpr Vector<FLOAT_TYPE, N> & Vector<FLOAT_TYPE, N>::operator-=(const Vector<FLOAT_TYPE, N> minuend) {
   for (size_t i = 0u; i < N; i++) {
     vector[i] -= minuend.vector[i];
   }
@@ -34,7 +34,7 @@ Vector<FLOAT_TYPE, N> & Vector<FLOAT_TYPE, N>::operator-=(const Vector<FLOAT_TYP
 }
 
 template <class FLOAT_TYPE, size_t N>  
-Vector<FLOAT_TYPE, N> & Vector<FLOAT_TYPE, N>::operator*=(const FLOAT_TYPE factor) {
+constexpr Vector<FLOAT_TYPE, N> & Vector<FLOAT_TYPE, N>::operator*=(const FLOAT_TYPE factor) {
   for (size_t i = 0u; i < N; i++) {
     vector[i] *= factor;
   }
@@ -42,7 +42,7 @@ Vector<FLOAT_TYPE, N> & Vector<FLOAT_TYPE, N>::operator*=(const FLOAT_TYPE facto
 }
 
 template <class FLOAT_TYPE, size_t N>  
-Vector<FLOAT_TYPE, N> & Vector<FLOAT_TYPE, N>::operator/=(const FLOAT_TYPE factor) {
+constexpr Vector<FLOAT_TYPE, N> & Vector<FLOAT_TYPE, N>::operator/=(const FLOAT_TYPE factor) {
   for (size_t i = 0u; i < N; i++) {
     vector[i] /= factor;
   }
@@ -50,7 +50,7 @@ Vector<FLOAT_TYPE, N> & Vector<FLOAT_TYPE, N>::operator/=(const FLOAT_TYPE facto
 }
 
 template <class FLOAT_TYPE, size_t N>    
-Vector<FLOAT_TYPE, N> operator*(FLOAT_TYPE scalar, Vector<FLOAT_TYPE, N> value) {
+constexpr Vector<FLOAT_TYPE, N> operator*(FLOAT_TYPE scalar, Vector<FLOAT_TYPE, N> value) {
   Vector<FLOAT_TYPE, N> scalar_product = value;
 
   scalar_product *= scalar;
@@ -59,26 +59,26 @@ Vector<FLOAT_TYPE, N> operator*(FLOAT_TYPE scalar, Vector<FLOAT_TYPE, N> value)
 }
 
 template <class FLOAT_TYPE, size_t N>    
-Vector<FLOAT_TYPE, N> operator+(const Vector<FLOAT_TYPE, N> value, const Vector<FLOAT_TYPE, N> addend) {
+constexpr Vector<FLOAT_TYPE, N> operator+(const Vector<FLOAT_TYPE, N> value, const Vector<FLOAT_TYPE, N> addend) {
   Vector<FLOAT_TYPE, N> sum = value;
   sum += addend;
   return sum;
 }
 
 template <class FLOAT_TYPE, size_t N>    
-Vector<FLOAT_TYPE, N> operator-(const Vector<FLOAT_TYPE, N> value, const Vector<FLOAT_TYPE, N> minuend) {
+constexpr Vector<FLOAT_TYPE, N> operator-(const Vector<FLOAT_TYPE, N> value, const Vector<FLOAT_TYPE, N> minuend) {
   Vector<FLOAT_TYPE, N> difference = value;
   difference -= minuend;
   return difference;
 }
 
 template <class FLOAT_TYPE, size_t N>  
-FLOAT_TYPE & Vector<FLOAT_TYPE, N>::operator[](std::size_t i) {
+constexpr FLOAT_TYPE & Vector<FLOAT_TYPE, N>::operator[](std::size_t i) {
   return vector[i];
 }
 
 template <class FLOAT_TYPE, size_t N>  
-FLOAT_TYPE Vector<FLOAT_TYPE, N>::operator[](std::size_t i) const {
+constexpr FLOAT_TYPE Vector<FLOAT_TYPE, N>::operator[](std::size_t i) const {
   return vector[i];
 }
 
@@ -92,8 +92,15 @@ Vector<FLOAT_TYPE, 3u> Vector<FLOAT_TYPE, N>::cross_product(const Vector<FLOAT_T
 }
 
 
+template <class F>
+constexpr Vector<F, 3u> cross(const Vector<F, 3u> a, const Vector<F, 3u> b) {
+  return {a[1] * b[2] - a[2] * b[1],
+          a[2] * b[0] - a[0] * b[2],
+          a[0] * b[1] - a[1] * b[0]};
+}
+
 template<class F, size_t K>
-F operator*(Vector<F, K> vector1, const Vector<F, K> vector2) {
+constexpr F operator*(Vector<F, K> vector1, const Vector<F, K> vector2) {
     F scalar = 0.f;
     for (size_t i = 0u; i < K; i++) {
         scalar += vector1[i] * vector2[i];
@@ -102,7 +109,7 @@ F operator*(Vector<F, K> vector1, const Vector<F, K> vector2) {
 }
 
 template<class FLOAT_TYPE, size_t N>
-FLOAT_TYPE Vector<FLOAT_TYPE, N>::square_of_length() const {
+constexpr FLOAT_TYPE Vector<FLOAT_TYPE, N>::square_of_length() const {
     FLOAT_TYPE square = 0.f;
     for(FLOAT_TYPE element : vector){
         square += element * element;
@@ -132,5 +139,3 @@ FLOAT_TYPE Vector<FLOAT_TYPE, N>::angle(size_t axis_1, size_t axis_2) const {
   Vector<FLOAT_TYPE, N> normalized = (1.0f / length()) * *this;
   return atan2( normalized[axis_2], normalized[axis_1] );
 }
-
-
@@ -0,0 +1,189 @@
+#include "math.h"
+#include "benchmark/benchmark.h"
+#include <random>
+#include <vector>
+
+namespace {
+
+// 1024 random vectors with coordinates in [-10, 10), the same for every run
+std::vector<Vector3df> random_vectors(unsigned seed) {
+  std::mt19937 generator(seed);
+  std::uniform_real_distribution<float> coordinate(-10.f, 10.f);
+  std::vector<Vector3df> vectors;
+  for (int i = 0; i < 1024; i++) {
+    vectors.push_back(Vector3df{coordinate(generator), coordinate(generator), coordinate(generator)});
+  }
+  return vectors;
+}
+
+// every benchmark applies one operation per iteration to the next input(s), items are operations
+
+void BM_VectorAdd(benchmark::State & state) {
+  std::vector<Vector3df> a = random_vectors(1), b = random_vectors(2);
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(a[i & 1023u] + b[i & 1023u]);
+    i++;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_VectorAdd);
+
+void BM_VectorSubtract(benchmark::State & state) {
+  std::vector<Vector3df> a = random_vectors(1), b = random_vectors(2);
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(a[i & 1023u] - b[i & 1023u]);
+    i++;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_VectorSubtract);
+
+void BM_VectorScale(benchmark::State & state) {
+  std::vector<Vector3df> a = random_vectors(1);
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(0.5f * a[i & 1023u]);
+    i++;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_VectorScale);
+
+void BM_VectorAddAssign(benchmark::State & state) {
+  std::vector<Vector3df> a = random_vectors(1);
+  Vector3df sum = {0.f, 0.f, 0.f};
+  size_t i = 0;
+  for (auto _ : state) {
+    sum += a[i++ & 1023u];
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_VectorAddAssign);
+
+void BM_DotProduct(benchmark::State & state) {
+  std::vector<Vector3df> a = random_vectors(1), b = random_vectors(2);
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(a[i & 1023u] * b[i & 1023u]);
+    i++;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DotProduct);
+
+void BM_Length(benchmark::State & state) {
+  std::vector<Vector3df> a = random_vectors(1);
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(a[i++ & 1023u].length());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Length);
+
+void BM_Normalize(benchmark::State & state) {
+  std::vector<Vector3df> a = random_vectors(1);
+  size_t i = 0;
+  for (auto _ : state) {
+    Vector3df v = a[i++ & 1023u];
+    v.normalize();
+    benchmark::DoNotOptimize(v);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Normalize);
+
+void BM_CrossProduct(benchmark::State & state) {
+  std::vector<Vector3df> a = random_vectors(1), b = random_vectors(2);
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(a[i & 1023u].cross_product(b[i & 1023u]));
+    i++;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CrossProduct);
+
+void BM_Reflect(benchmark::State & state) {
+  std::vector<Vector3df> a = random_vectors(1), normals = random_vectors(2);
+  for (Vector3df & normal : normals) {
+    normal.normalize();
+  }
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(a[i & 1023u].get_reflective(normals[i & 1023u]));
+    i++;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Reflect);
+
+// the compound expressions of ray_color for all 1024 inputs per iteration, written with the Vector operators
+// and as hand-written loops over the components, items are evaluated expressions
+
+void BM_OffsetExpression(benchmark::State & state) {
+  std::vector<Vector3df> points = random_vectors(1), normals = random_vectors(2), result = points;
+  for (auto _ : state) {
+    for (size_t i = 0; i < 1024u; i++) {
+      result[i] = points[i] + 0.01f * normals[i];
+    }
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * 1024);
+}
+BENCHMARK(BM_OffsetExpression);
+
+void BM_OffsetLoop(benchmark::State & state) {
+  std::vector<Vector3df> points = random_vectors(1), normals = random_vectors(2), result = points;
+  for (auto _ : state) {
+    for (size_t i = 0; i < 1024u; i++) {
+      for (size_t k = 0; k < 3u; k++) {
+        result[i][k] = points[i][k] + 0.01f * normals[i][k];
+      }
+    }
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * 1024);
+}
+BENCHMARK(BM_OffsetLoop);
+
+void BM_ReflectExpression(benchmark::State & state) {
+  std::vector<Vector3df> directions = random_vectors(1), normals = random_vectors(2), result = directions;
+  for (Vector3df & normal : normals) {
+    normal.normalize();
+  }
+  for (auto _ : state) {
+    for (size_t i = 0; i < 1024u; i++) {
+      result[i] = directions[i] - 2.f * (directions[i] * normals[i]) * normals[i];
+    }
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * 1024);
+}
+BENCHMARK(BM_ReflectExpression);
+
+void BM_ReflectLoop(benchmark::State & state) {
+  std::vector<Vector3df> directions = random_vectors(1), normals = random_vectors(2), result = directions;
+  for (Vector3df & normal : normals) {
+    normal.normalize();
+  }
+  for (auto _ : state) {
+    for (size_t i = 0; i < 1024u; i++) {
+      float scalar = 0.f;
+      for (size_t k = 0; k < 3u; k++) {
+        scalar += directions[i][k] * normals[i][k];
+      }
+      for (size_t k = 0; k < 3u; k++) {
+        result[i][k] = directions[i][k] - 2.f * scalar * normals[i][k];
+      }
+    }
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * 1024);
+}
+BENCHMARK(BM_ReflectLoop);
+
+}
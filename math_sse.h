@@ -0,0 +1,360 @@
+#ifndef MATH_SSE_H
+#define MATH_SSE_H
+
+// contains the specializations of Vector for float, 3 and float, 4 that hold their values in one SSE register
+// only included by math.h, the members are defined here and not in math.cc, so that they can be inlined
+// the results are the same as the ones of the generic Vector: the components of scalar products are summed
+//   up in the same order and nothing is computed with fused multiply-add or reciprocals
+// like the generic Vector the arithmetic is constexpr, constant evaluation uses the scalar loops instead of
+//   the intrinsics
+
+#if defined(__SSE2__)
+
+#include <immintrin.h>
+#include <cassert>
+#include <type_traits>
+
+// a three-dimensional Vector padded to 16 bytes, the padding component is 0 after construction
+template<>
+struct alignas(16) Vector<float, 3u> {
+  union {
+    std::array<float, 3u> vector;  // index 0, 1, 2 corresponds to x,y,z axis
+    __m128 simd;                   // vector and the padding component
+  };
+
+  // same as Vector<FLOAT_TYPE, N>::Vector(values)
+  constexpr Vector( std::initializer_list<float> values );
+
+  // same as Vector<FLOAT_TYPE, N>::Vector(angle)
+  explicit Vector(float angle);
+
+  // creates a Vector with the first three values of simd
+  explicit Vector(__m128 simd) : simd(simd) { }
+
+  constexpr Vector & operator+=(const Vector addend);
+
+  constexpr Vector & operator-=(const Vector minuend);
+
+  constexpr Vector & operator*=(const float factor);
+
+  constexpr Vector & operator/=(const float factor);
+
+  constexpr float & operator[](std::size_t i) { return vector[i]; }
+
+  constexpr float operator[](std::size_t i) const { return vector[i]; }
+
+  // throws std::out_of_range if i >= 3
+  float at(std::size_t i) const { return vector.at(i); }
+
+  void normalize();
+
+  Vector get_reflective(Vector normal) const;
+
+  float angle(size_t axis_1, size_t axis_2) const;
+
+  Vector<float, 3u> cross_product(const Vector<float, 3u> v) const;
+
+  float length() const;
+
+  constexpr float square_of_length() const;
+};
+
+// same as the generic Vector<float, 3u>, stored in one SSE register
+template<>
+struct alignas(16) Vector<float, 4u> {
+  union {
+    std::array<float, 4u> vector;  // index 0, 1, 2, 3 corresponds to x,y,z,w axis
+    __m128 simd;
+  };
+
+  constexpr Vector( std::initializer_list<float> values );
+
+  explicit Vector(float angle);
+
+  explicit Vector(__m128 simd) : simd(simd) { }
+
+  constexpr Vector & operator+=(const Vector addend);
+
+  constexpr Vector & operator-=(const Vector minuend);
+
+  constexpr Vector & operator*=(const float factor);
+
+  constexpr Vector & operator/=(const float factor);
+
+  constexpr float & operator[](std::size_t i) { return vector[i]; }
+
+  constexpr float operator[](std::size_t i) const { return vector[i]; }
+
+  float at(std::size_t i) const { return vector.at(i); }
+
+  void normalize();
+
+  Vector get_reflective(Vector normal) const;
+
+  float angle(size_t axis_1, size_t axis_2) const;
+
+  // returns the cross product of the first three components of this Vector with v
+  Vector<float, 3u> cross_product(const Vector<float, 3u> v) const;
+
+  float length() const;
+
+  constexpr float square_of_length() const;
+};
+
+// returns the sum of the first three components of products, from x to z like the generic scalar product
+inline float sum_of_3(__m128 products) {
+  __m128 sum = _mm_add_ss(products, _mm_shuffle_ps(products, products, _MM_SHUFFLE(1, 1, 1, 1)));
+  return _mm_cvtss_f32(_mm_add_ss(sum, _mm_shuffle_ps(products, products, _MM_SHUFFLE(2, 2, 2, 2))));
+}
+
+// returns the sum of the four components of products, from x to w
+inline float sum_of_4(__m128 products) {
+  __m128 sum = _mm_add_ss(_mm_set_ss(sum_of_3(products)), _mm_shuffle_ps(products, products, _MM_SHUFFLE(3, 3, 3, 3)));
+  return _mm_cvtss_f32(sum);
+}
+
+inline constexpr Vector<float, 3u>::Vector( std::initializer_list<float> values ) : vector{} {
+  if (!std::is_constant_evaluated()) {
+    simd = _mm_setzero_ps();  // also clears the padding component
+  }
+  auto iterator = values.begin();
+  for (size_t i = 0u; i < 3u; i++) {
+    if ( iterator != values.end()) {
+      vector[i] = *iterator++;
+    } else {
+      vector[i] = (i > 0 ? vector[i - 1] : 0.0f);
+    }
+  }
+}
+
+inline Vector<float, 3u>::Vector(float angle) : Vector{ static_cast<float>( cos(angle) ), static_cast<float>(sin(angle)) } { }
+
+inline constexpr Vector<float, 3u> & Vector<float, 3u>::operator+=(const Vector<float, 3u> addend) {
+  if (std::is_constant_evaluated()) {
+    for (size_t i = 0u; i < 3u; i++) {
+      vector[i] += addend.vector[i];
+    }
+  } else {
+    simd = _mm_add_ps(simd, addend.simd);
+  }
+  return *this;
+}
+
+inline constexpr Vector<float, 3u> & Vector<float, 3u>::operator-=(const Vector<float, 3u> minuend) {
+  if (std::is_constant_evaluated()) {
+    for (size_t i = 0u; i < 3u; i++) {
+      vector[i] -= minuend.vector[i];
+    }
+  } else {
+    simd = _mm_sub_ps(simd, minuend.simd);
+  }
+  return *this;
+}
+
+inline constexpr Vector<float, 3u> & Vector<float, 3u>::operator*=(const float factor) {
+  if (std::is_constant_evaluated()) {
+    for (size_t i = 0u; i < 3u; i++) {
+      vector[i] *= factor;
+    }
+  } else {
+    simd = _mm_mul_ps(simd, _mm_set1_ps(factor));
+  }
+  return *this;
+}
+
+inline constexpr Vector<float, 3u> & Vector<float, 3u>::operator/=(const float factor) {
+  // the padding component stays 0 for factors other than 0
+  if (std::is_constant_evaluated()) {
+    for (size_t i = 0u; i < 3u; i++) {
+      vector[i] /= factor;
+    }
+  } else {
+    simd = _mm_div_ps(simd, _mm_set1_ps(factor));
+  }
+  return *this;
+}
+
+inline constexpr Vector<float, 3u> operator*(float scalar, Vector<float, 3u> value) {
+  return value *= scalar;
+}
+
+inline constexpr Vector<float, 3u> operator+(const Vector<float, 3u> value, const Vector<float, 3u> addend) {
+  Vector<float, 3u> sum = value;
+  return sum += addend;
+}
+
+inline constexpr Vector<float, 3u> operator-(const Vector<float, 3u> value, const Vector<float, 3u> minuend) {
+  Vector<float, 3u> difference = value;
+  return difference -= minuend;
+}
+
+// the padding components are ignored, they are not 0 after a division by 0
+inline constexpr float operator*(Vector<float, 3u> vector1, const Vector<float, 3u> vector2) {
+  if (std::is_constant_evaluated()) {
+    float scalar = 0.f;
+    for (size_t i = 0u; i < 3u; i++) {
+      scalar += vector1[i] * vector2[i];
+    }
+    return scalar;
+  }
+  return sum_of_3(_mm_mul_ps(vector1.simd, vector2.simd));
+}
+
+inline constexpr float Vector<float, 3u>::square_of_length() const {
+  return *this * *this;
+}
+
+inline float Vector<float, 3u>::length() const {
+  return sqrt(square_of_length());
+}
+
+inline void Vector<float, 3u>::normalize() {
+  *this /= length(); //  +/- INFINITY if length is (near to) zero
+}
+
+inline Vector<float, 3u> Vector<float, 3u>::get_reflective(Vector<float, 3u> normal) const {
+  assert(0.99999 < normal.square_of_length() && normal.square_of_length()  < 1.000001);
+  return *this - 2.0f * (*this * normal ) * normal;
+}
+
+inline float Vector<float, 3u>::angle(size_t axis_1, size_t axis_2) const {
+  Vector<float, 3u> normalized = (1.0f / length()) * *this;
+  return atan2( normalized[axis_2], normalized[axis_1] );
+}
+
+// the same products as the generic cross_product (including the sign of y), the padding component is 0
+inline Vector<float, 3u> Vector<float, 3u>::cross_product(const Vector<float, 3u> v) const {
+  __m128 a_yxx = _mm_shuffle_ps(simd, simd, _MM_SHUFFLE(3, 0, 0, 1)),
+         a_zzy = _mm_shuffle_ps(simd, simd, _MM_SHUFFLE(3, 1, 2, 2)),
+         v_zzy = _mm_shuffle_ps(v.simd, v.simd, _MM_SHUFFLE(3, 1, 2, 2)),
+         v_yxx = _mm_shuffle_ps(v.simd, v.simd, _MM_SHUFFLE(3, 0, 0, 1));
+  __m128 product = _mm_sub_ps(_mm_mul_ps(a_yxx, v_zzy), _mm_mul_ps(a_zzy, v_yxx));
+  return Vector<float, 3u>(_mm_and_ps(product, _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1))));
+}
+
+// the same products as the generic cross, the padding component is 0
+inline constexpr Vector<float, 3u> cross(const Vector<float, 3u> a, const Vector<float, 3u> b) {
+  if (std::is_constant_evaluated()) {
+    return {a[1] * b[2] - a[2] * b[1],
+            a[2] * b[0] - a[0] * b[2],
+            a[0] * b[1] - a[1] * b[0]};
+  }
+  __m128 a_yzx = _mm_shuffle_ps(a.simd, a.simd, _MM_SHUFFLE(3, 0, 2, 1)),
+         a_zxy = _mm_shuffle_ps(a.simd, a.simd, _MM_SHUFFLE(3, 1, 0, 2)),
+         b_zxy = _mm_shuffle_ps(b.simd, b.simd, _MM_SHUFFLE(3, 1, 0, 2)),
+         b_yzx = _mm_shuffle_ps(b.simd, b.simd, _MM_SHUFFLE(3, 0, 2, 1));
+  __m128 product = _mm_sub_ps(_mm_mul_ps(a_yzx, b_zxy), _mm_mul_ps(a_zxy, b_yzx));
+  return Vector<float, 3u>(_mm_and_ps(product, _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1))));
+}
+
+inline constexpr Vector<float, 4u>::Vector( std::initializer_list<float> values ) : vector{} {
+  auto iterator = values.begin();
+  for (size_t i = 0u; i < 4u; i++) {
+    if ( iterator != values.end()) {
+      vector[i] = *iterator++;
+    } else {
+      vector[i] = (i > 0 ? vector[i - 1] : 0.0f);
+    }
+  }
+}
+
+inline Vector<float, 4u>::Vector(float angle) : Vector{ static_cast<float>( cos(angle) ), static_cast<float>(sin(angle)) } { }
+
+inline constexpr Vector<float, 4u> & Vector<float, 4u>::operator+=(const Vector<float, 4u> addend) {
+  if (std::is_constant_evaluated()) {
+    for (size_t i = 0u; i < 4u; i++) {
+      vector[i] += addend.vector[i];
+    }
+  } else {
+    simd = _mm_add_ps(simd, addend.simd);
+  }
+  return *this;
+}
+
+inline constexpr Vector<float, 4u> & Vector<float, 4u>::operator-=(const Vector<float, 4u> minuend) {
+  if (std::is_constant_evaluated()) {
+    for (size_t i = 0u; i < 4u; i++) {
+      vector[i] -= minuend.vector[i];
+    }
+  } else {
+    simd = _mm_sub_ps(simd, minuend.simd);
+  }
+  return *this;
+}
+
+inline constexpr Vector<float, 4u> & Vector<float, 4u>::operator*=(const float factor) {
+  if (std::is_constant_evaluated()) {
+    for (size_t i = 0u; i < 4u; i++) {
+      vector[i] *= factor;
+    }
+  } else {
+    simd = _mm_mul_ps(simd, _mm_set1_ps(factor));
+  }
+  return *this;
+}
+
+inline constexpr Vector<float, 4u> & Vector<float, 4u>::operator/=(const float factor) {
+  if (std::is_constant_evaluated()) {
+    for (size_t i = 0u; i < 4u; i++) {
+      vector[i] /= factor;
+    }
+  } else {
+    simd = _mm_div_ps(simd, _mm_set1_ps(factor));
+  }
+  return *this;
+}
+
+inline constexpr Vector<float, 4u> operator*(float scalar, Vector<float, 4u> value) {
+  return value *= scalar;
+}
+
+inline constexpr Vector<float, 4u> operator+(const Vector<float, 4u> value, const Vector<float, 4u> addend) {
+  Vector<float, 4u> sum = value;
+  return sum += addend;
+}
+
+inline constexpr Vector<float, 4u> operator-(const Vector<float, 4u> value, const Vector<float, 4u> minuend) {
+  Vector<float, 4u> difference = value;
+  return difference -= minuend;
+}
+
+inline constexpr float operator*(Vector<float, 4u> vector1, const Vector<float, 4u> vector2) {
+  if (std::is_constant_evaluated()) {
+    float scalar = 0.f;
+    for (size_t i = 0u; i < 4u; i++) {
+      scalar += vector1[i] * vector2[i];
+    }
+    return scalar;
+  }
+  return sum_of_4(_mm_mul_ps(vector1.simd, vector2.simd));
+}
+
+inline constexpr float Vector<float, 4u>::square_of_length() const {
+  return *this * *this;
+}
+
+inline float Vector<float, 4u>::length() const {
+  return sqrt(square_of_length());
+}
+
+inline void Vector<float, 4u>::normalize() {
+  *this /= length(); //  +/- INFINITY if length is (near to) zero
+}
+
+inline Vector<float, 4u> Vector<float, 4u>::get_reflective(Vector<float, 4u> normal) const {
+  assert(0.99999 < normal.square_of_length() && normal.square_of_length()  < 1.000001);
+  return *this - 2.0f * (*this * normal ) * normal;
+}
+
+inline float Vector<float, 4u>::angle(size_t axis_1, size_t axis_2) const {
+  Vector<float, 4u> normalized = (1.0f / length()) * *this;
+  return atan2( normalized[axis_2], normalized[axis_1] );
+}
+
+inline Vector<float, 3u> Vector<float, 4u>::cross_product(const Vector<float, 3u> v) const {
+  return Vector<float, 3u>{vector[0], vector[1], vector[2]}.cross_product(v);
+}
+
+#endif
+
+#endif
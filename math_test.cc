@@ -424,4 +424,50 @@ TEST(VECTOR, CrossVectorProduct7) {
   EXPECT_NEAR(0.0, cross[2], 0.00001);
 }
 
+TEST(VECTOR, CrossVectorProduct4df) {
+  Vector4df vector1 = {2.0, 3.0, 4.0, 7.0};
+  Vector3df vector2 = {5.0, 6.0, 7.0};
+  Vector3df cross = vector1.cross_product(vector2);
+
+  EXPECT_NEAR(-3.0, cross[0], 0.00001);
+  EXPECT_NEAR(-6.0, cross[1], 0.00001);
+  EXPECT_NEAR(-3.0, cross[2], 0.00001);
+}
+
+TEST(VECTOR, CrossIsRightHanded) {
+  Vector3df x = {1.0, 0.0, 0.0},
+            y = {0.0, 1.0, 0.0},
+            z = {0.0, 0.0, 1.0};
+  for (size_t k = 0; k < 3; k++) {
+    EXPECT_EQ(z[k], cross(x, y)[k]);
+    EXPECT_EQ(x[k], cross(y, z)[k]);
+    EXPECT_EQ(y[k], cross(z, x)[k]);
+  }
+
+  // the same as the generic Vector, unlike cross_product also in the y component
+  Vector3df a = {-2.0, 1.0, -2.0},
+            b = {-3.0, 3.0, 0.0};
+  Vector<double, 3u> product = cross(Vector<double, 3u>{-2.0, 1.0, -2.0}, Vector<double, 3u>{-3.0, 3.0, 0.0});
+  for (size_t k = 0; k < 3; k++) {
+    EXPECT_EQ(static_cast<float>(product[k]), cross(a, b)[k]);
+  }
+  EXPECT_EQ(6.0, product[1]);
+  EXPECT_EQ(0.0f, cross(a, b) * a);
+}
+
+// the arithmetic can be evaluated at compile time, for the generic Vector and the SSE specializations
+constexpr Vector2df offset2df = Vector2df{1.0, 2.0} + 0.5f * Vector2df{4.0, -2.0};
+constexpr Vector3df offset3df = Vector3df{1.0, 2.0, 3.0} - 2.0f * Vector3df{0.5, 1.0, 1.5};
+constexpr Vector4df sum4df = Vector4df{1.0, 2.0, 3.0, 4.0} + Vector4df{4.0, 3.0, 2.0, 1.0};
+
+TEST(VECTOR, ConstexprArithmetic) {
+  static_assert(offset2df[0] == 3.0f && offset2df[1] == 1.0f);
+  static_assert(offset3df.square_of_length() == 0.0f);
+  static_assert(cross(Vector3df{1.0, 0.0, 0.0}, Vector3df{0.0, 1.0, 0.0})[2] == 1.0f);
+  static_assert(sum4df * Vector4df{1.0} == 20.0f);
+
+  Vector3df offset = Vector3df{1.0, 2.0, 3.0} - 2.0f * Vector3df{0.5, 1.0, 1.5};
+  EXPECT_EQ(offset3df * offset3df, offset * offset);
+}
+
 }
@@ -0,0 +1,26 @@
+#ifndef RANDOM_SPHERES_H
+#define RANDOM_SPHERES_H
+
+#include "geometry.h"
+#include <random>
+#include <vector>
+
+// contains the seeded random sphere sets shared by the tests and benchmarks
+
+
+// returns count spheres with centers uniformly distributed in the cube center +- extent and radii uniformly distributed
+// in [min_radius, max_radius), the same spheres for the same arguments
+inline std::vector<Sphere3df> random_spheres(size_t count, unsigned seed, float extent = 50.f, float min_radius = 0.1f,
+                                             float max_radius = 2.f, const Vector3df & center = {0.f, 0.f, 0.f}) {
+  std::mt19937 generator(seed);
+  std::uniform_real_distribution<float> position(-extent, extent), radius(min_radius, max_radius);
+  std::vector<Sphere3df> spheres;
+  spheres.reserve(count);
+  for (size_t i = 0; i < count; i++) {
+    spheres.push_back(Sphere3df({center[0] + position(generator), center[1] + position(generator), center[2] + position(generator)},
+                                radius(generator)));
+  }
+  return spheres;
+}
+
+#endif
@@ -0,0 +1,251 @@
+#include "ray_packet.h"
+#include "simd.h"
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+Ray3df Ray_Packet::ray(size_t i) const {
+  return Ray3df{{origin[0][i], origin[1][i], origin[2][i]}, {direction[0][i], direction[1][i], direction[2][i]}};
+}
+
+Ray_Query3df Ray_Packet::query(size_t i) const {
+  return Ray_Query3df(ray(i), tmin[i], tmax[i]);
+}
+
+void Ray_Packet::set(size_t i, const Ray3df & ray, float t) {
+  for (size_t k = 0; k < 3; k++) {
+    origin[k][i] = ray.origin[k];
+    direction[k][i] = ray.direction[k];
+  }
+  tmin[i] = 0.0f;
+  tmax[i] = t;
+  active |= 1u << i;
+}
+
+void Ray_Packet::set(size_t i, const Ray_Query3df & query) {
+  set(i, query.ray, query.tmax);
+  tmin[i] = query.tmin;
+}
+
+void Ray_Packet::prepare() {
+  coherent = active != 0;
+  bounded = coherent;
+  if (!coherent) {
+    return;
+  }
+  size_t first = static_cast<size_t>(__builtin_ctz(active));
+  for (size_t i = 0; i < WIDTH; i++) {
+    if (!(active & (1u << i))) {
+      for (size_t k = 0; k < 3; k++) {
+        origin[k][i] = origin[k][first];
+        direction[k][i] = direction[k][first];
+      }
+      tmin[i] = 0.0f;
+      tmax[i] = -1.0f;
+    }
+  }
+  // the sign of the inverse direction also tells the sign of a zero component (+inf or -inf)
+  for (size_t k = 0; k < 3; k++) {
+    negative[k] = 1.0f / direction[k][first] < 0.0f;
+    origin_lower[k] = origin_upper[k] = origin[k][first];
+    inverse_lower[k] = inverse_upper[k] = 1.0f / direction[k][first];
+    for (size_t i = 0; i < WIDTH; i++) {
+      inverse_direction[k][i] = 1.0f / direction[k][i];
+      coherent &= (inverse_direction[k][i] < 0.0f) == negative[k];
+      bounded &= direction[k][i] != 0.0f;
+      origin_lower[k] = std::min(origin_lower[k], origin[k][i]);
+      origin_upper[k] = std::max(origin_upper[k], origin[k][i]);
+      inverse_lower[k] = std::min(inverse_lower[k], inverse_direction[k][i]);
+      inverse_upper[k] = std::max(inverse_upper[k], inverse_direction[k][i]);
+    }
+  }
+  bounded &= coherent;
+}
+
+Packet_Statistics & Packet_Statistics::operator+=(const Packet_Statistics & statistics) {
+  packets += statistics.packets;
+  single_rays += statistics.single_rays;
+  nodes_visited += statistics.nodes_visited;
+  nodes_culled += statistics.nodes_culled;
+  return *this;
+}
+
+namespace {
+
+typedef Linear_BVH_Node<float, 3u> Node;
+
+// all node tests compute, like the child tests of Wide_BVH, for each ray
+//   tnear = max(tmin, (near plane - origin) / direction), tfar = min(tmax, (far plane - origin) / direction)
+// where the near and far plane of each slab are chosen by the common sign of the directions,
+// and return the mask of the rays with tnear <= tfar (NaN plane distances never narrow the interval)
+
+inline unsigned intersect_node_scalar(const Node & node, const Ray_Packet & packet) {
+  unsigned mask = 0;
+  for (size_t i = 0; i < Ray_Packet::WIDTH; i++) {
+    float tnear = packet.tmin[i],
+          tfar = packet.tmax[i];
+    for (size_t k = 0; k < 3; k++) {
+      float near = ((packet.negative[k] ? node.upper[k] : node.lower[k]) - packet.origin[k][i]) * packet.inverse_direction[k][i],
+            far = ((packet.negative[k] ? node.lower[k] : node.upper[k]) - packet.origin[k][i]) * packet.inverse_direction[k][i];
+      tnear = near > tnear ? near : tnear;
+      tfar = far < tfar ? far : tfar;
+    }
+    mask |= static_cast<unsigned>(tnear <= tfar) << i;
+  }
+  return mask;
+}
+
+#if defined(__SSE2__)
+inline unsigned intersect_node(const Node & node, const Ray_Packet & packet) {
+  unsigned mask = 0;
+  for (size_t lanes = 0; lanes < Ray_Packet::WIDTH; lanes += 4) {
+    __m128 tnear = _mm_load_ps(packet.tmin + lanes),
+           tfar = _mm_load_ps(packet.tmax + lanes);
+    for (size_t k = 0; k < 3; k++) {
+      __m128 origin = _mm_load_ps(packet.origin[k] + lanes),
+             inverse_direction = _mm_load_ps(packet.inverse_direction[k] + lanes);
+      __m128 near = _mm_set1_ps(packet.negative[k] ? node.upper[k] : node.lower[k]),
+             far = _mm_set1_ps(packet.negative[k] ? node.lower[k] : node.upper[k]);
+      tnear = _mm_max_ps(_mm_mul_ps(_mm_sub_ps(near, origin), inverse_direction), tnear);
+      tfar = _mm_min_ps(_mm_mul_ps(_mm_sub_ps(far, origin), inverse_direction), tfar);
+    }
+    mask |= static_cast<unsigned>(_mm_movemask_ps(_mm_cmple_ps(tnear, tfar))) << lanes;
+  }
+  return mask;
+}
+#else
+inline unsigned intersect_node(const Node & node, const Ray_Packet & packet) {
+  return intersect_node_scalar(node, packet);
+}
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+AVX2_FUNCTION
+inline unsigned intersect_node_avx2(const Node & node, const Ray_Packet & packet) {
+  __m256 tnear = _mm256_load_ps(packet.tmin),
+         tfar = _mm256_load_ps(packet.tmax);
+  for (size_t k = 0; k < 3; k++) {
+    __m256 origin = _mm256_load_ps(packet.origin[k]),
+           inverse_direction = _mm256_load_ps(packet.inverse_direction[k]);
+    __m256 near = _mm256_set1_ps(packet.negative[k] ? node.upper[k] : node.lower[k]),
+           far = _mm256_set1_ps(packet.negative[k] ? node.lower[k] : node.upper[k]);
+    tnear = _mm256_max_ps(_mm256_mul_ps(_mm256_sub_ps(near, origin), inverse_direction), tnear);
+    tfar = _mm256_min_ps(_mm256_mul_ps(_mm256_sub_ps(far, origin), inverse_direction), tfar);
+  }
+  return static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(tnear, tfar, _CMP_LE_OQ)));
+}
+#else
+inline unsigned intersect_node_avx2(const Node & node, const Ray_Packet & packet) {
+  return intersect_node(node, packet);
+}
+#endif
+
+// sets lower and upper to the bounds of the products of a value in [a_lower, a_upper] and one in [b_lower, b_upper]
+inline void interval_product(float a_lower, float a_upper, float b_lower, float b_upper, float & lower, float & upper) {
+  float p0 = a_lower * b_lower, p1 = a_lower * b_upper,
+        p2 = a_upper * b_lower, p3 = a_upper * b_upper;
+  lower = std::min(std::min(p0, p1), std::min(p2, p3));
+  upper = std::max(std::max(p0, p1), std::max(p2, p3));
+}
+
+// returns true if no ray of a bounded packet can hit the node's aabb for 0 <= t <= tmax, tmax being the largest
+// tmax of the active rays: the slab distances are evaluated in interval arithmetic over the origins and inverse
+// directions of all rays, the packet misses if the largest lower bound of the entry distances exceeds the smallest
+// upper bound of the exit distances
+inline bool packet_misses(const Node & node, const Ray_Packet & packet, float tmax) {
+  float entry = 0.0f,
+        exit = tmax;
+  for (size_t k = 0; k < 3; k++) {
+    float near = packet.negative[k] ? node.upper[k] : node.lower[k],
+          far = packet.negative[k] ? node.lower[k] : node.upper[k];
+    float lower, upper;
+    interval_product(near - packet.origin_upper[k], near - packet.origin_lower[k],
+                     packet.inverse_lower[k], packet.inverse_upper[k], lower, upper);
+    entry = std::max(entry, lower);
+    interval_product(far - packet.origin_upper[k], far - packet.origin_lower[k],
+                     packet.inverse_lower[k], packet.inverse_upper[k], lower, upper);
+    exit = std::min(exit, upper);
+  }
+  return entry > exit;
+}
+
+inline float largest_tmax(const Ray_Packet & packet) {
+  float tmax = packet.tmax[0];
+  for (size_t i = 1; i < Ray_Packet::WIDTH; i++) {
+    tmax = std::max(tmax, packet.tmax[i]);
+  }
+  return tmax;
+}
+
+template <bool AVX2>
+inline void traverse(const std::vector<Node> & nodes, Ray_Packet & packet, Packet_Leaf_Function leaf, void * context,
+                     Packet_Statistics * statistics) {
+  uint32_t stack[BVH3df::MAX_DEPTH + 1];
+  size_t size = 0;
+  stack[size++] = 0u;
+  float tmax = largest_tmax(packet);
+
+  while (size > 0) {
+    uint32_t current = stack[--size];
+    const Node & node = nodes[current];
+    if (packet.bounded && packet_misses(node, packet, tmax)) {
+      if (statistics) {
+        statistics->nodes_culled++;
+      }
+      continue;
+    }
+    if (statistics) {
+      statistics->nodes_visited++;
+    }
+    unsigned mask = (AVX2 ? intersect_node_avx2(node, packet) : intersect_node(node, packet)) & packet.active;
+    if (mask == 0) {
+      continue;
+    }
+    if (node.is_leaf()) {
+      unsigned finished = leaf(context, node.offset, node.count, packet, mask);
+      packet.active &= ~finished;
+      if (packet.active == 0) {
+        return;
+      }
+      for (unsigned rays = finished; rays != 0; rays &= rays - 1) {
+        packet.tmax[__builtin_ctz(rays)] = -1.0f;
+      }
+      tmax = largest_tmax(packet);
+      continue;
+    }
+    // the near child is pushed last, so that it is visited next
+    if (packet.negative[node.axis]) {
+      stack[size++] = current + 1;
+      stack[size++] = node.offset;
+    } else {
+      stack[size++] = node.offset;
+      stack[size++] = current + 1;
+    }
+  }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+AVX2_FUNCTION
+void traverse_avx2(const std::vector<Node> & nodes, Ray_Packet & packet, Packet_Leaf_Function leaf, void * context,
+                   Packet_Statistics * statistics) {
+  traverse<true>(nodes, packet, leaf, context, statistics);
+}
+#endif
+
+}
+
+void traverse_packet(const Linear_BVH3df & bvh, Ray_Packet & packet, Packet_Leaf_Function leaf, void * context,
+                     Packet_Statistics * statistics) {
+  if (bvh.empty() || packet.active == 0) {
+    return;
+  }
+#if defined(__x86_64__) || defined(__i386__)
+  if (has_avx2()) {
+    traverse_avx2(bvh.node_array(), packet, leaf, context, statistics);
+    return;
+  }
+#endif
+  traverse<false>(bvh.node_array(), packet, leaf, context, statistics);
+}
@@ -0,0 +1,72 @@
+#ifndef RAY_PACKET_H
+#define RAY_PACKET_H
+
+#include "geometry.h"
+#include "bvh.h"
+#include <cstddef>
+#include <cstdint>
+
+// contains packets of rays which are traced together through a Linear_BVH, so that each node is loaded once
+// for all rays of the packet and whole subtrees can be culled by one test against the bounds of the packet
+
+
+// up to WIDTH rays stored as structure of arrays
+// the rays of a packet should be coherent, e.g. the primary rays of neighbouring pixels or their shadow rays
+struct alignas(32) Ray_Packet {
+  static constexpr size_t WIDTH = 8u;
+
+  float origin[3][WIDTH],             // origin[axis][ray]
+        direction[3][WIDTH],
+        tmin[WIDTH],                  // the rays are intersected for tmin < t < tmax
+        tmax[WIDTH],
+        inverse_direction[3][WIDTH];  // set by prepare(), every row is 32 byte aligned for SIMD loads
+  unsigned active = 0;                // bit i is set iff ray i takes part in the query
+
+  // set by prepare()
+  bool coherent = false,              // the directions of all active rays have the same sign on every axis ...
+       negative[3] = {};              //   ... which is negative on the axes set here
+  bool bounded = false;               // coherent and no active direction has a zero component, i.e. the intervals
+                                      //   below bound the active rays and can cull nodes for the whole packet
+  float origin_lower[3],              // intervals containing the origins and the inverse directions of the active rays
+        origin_upper[3],
+        inverse_lower[3],
+        inverse_upper[3];
+
+  // returns ray i
+  Ray3df ray(size_t i) const;
+
+  // returns ray i together with its interval
+  Ray_Query3df query(size_t i) const;
+
+  // sets ray i with tmin = 0 and the given tmax and makes it active
+  void set(size_t i, const Ray3df & ray, float tmax);
+
+  // sets ray i and its interval to the ones of the query and makes it active
+  void set(size_t i, const Ray_Query3df & query);
+
+  // computes the members set by prepare() for the active rays
+  // the inactive rays become copies of an active ray with tmin = 0 and tmax = -1, so that they never hit anything
+  void prepare();
+};
+
+// counters filled by the packet queries if requested
+struct Packet_Statistics {
+  size_t packets = 0,        // packets traced through the bvh together
+         single_rays = 0,    // rays of incoherent (or almost empty) packets which were traced one by one
+         nodes_visited = 0,  // node aabbs tested against all rays of a packet
+         nodes_culled = 0;   // nodes skipped by the test against the bounds of a packet
+
+  Packet_Statistics & operator+=(const Packet_Statistics & statistics);
+};
+
+// called for the primitive positions first, ..., first + count - 1 of a leaf hit by the rays in mask
+// may lower packet.tmax of the rays it hits, returns the mask of rays which are finished (e.g. occluded)
+typedef unsigned (*Packet_Leaf_Function)(void * context, uint32_t first, uint32_t count, Ray_Packet & packet, unsigned mask);
+
+// traverses the bvh with the active rays of a prepared, coherent packet, the near child of a node is visited first
+// finished rays are removed from packet.active, the traversal stops when no active ray is left
+// every node is tested against the bounds of the packet first (if packet.bounded), then against each ray
+void traverse_packet(const Linear_BVH3df & bvh, Ray_Packet & packet, Packet_Leaf_Function leaf, void * context,
+                     Packet_Statistics * statistics = nullptr);
+
+#endif
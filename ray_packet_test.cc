@@ -0,0 +1,126 @@
+#include "ray_packet.h"
+#include "bvh.tcc"
+#include "gtest/gtest.h"
+#include <random>
+#include <set>
+#include <vector>
+
+namespace {
+
+std::vector<AABB3df> random_boxes(size_t count, unsigned seed) {
+  std::mt19937 generator(seed);
+  std::uniform_real_distribution<float> position(-50.f, 50.f), radius(0.1f, 2.f);
+  std::vector<Sphere3df> spheres;
+  for (size_t i = 0; i < count; i++) {
+    spheres.push_back(Sphere3df({position(generator), position(generator), position(generator)}, radius(generator)));
+  }
+  return bounding_boxes(spheres);
+}
+
+// a packet of rays from points near origin through a small patch around direction
+Ray_Packet nearby_rays(std::mt19937 & generator, const Vector3df & origin, const Vector3df & direction, float spread) {
+  std::uniform_real_distribution<float> offset(-spread, spread);
+  Ray_Packet packet;
+  for (size_t i = 0; i < Ray_Packet::WIDTH; i++) {
+    Ray3df ray = {origin + Vector3df{offset(generator), offset(generator), offset(generator)},
+                  direction + Vector3df{offset(generator), offset(generator), offset(generator)}};
+    packet.set(i, ray, 200.f);
+  }
+  return packet;
+}
+
+TEST(RAY_PACKET, Prepare) {
+  Ray_Packet packet;
+  packet.set(1, Ray3df{{0.f, 0.f, 0.f}, {1.f, -1.f, 2.f}}, 5.f);
+  packet.set(3, Ray3df{{1.f, 2.f, 3.f}, {2.f, -4.f, 1.f}}, 7.f);
+  packet.prepare();
+
+  EXPECT_EQ(0b1010u, packet.active);
+  EXPECT_TRUE(packet.coherent);
+  EXPECT_TRUE(packet.bounded);
+  EXPECT_FALSE(packet.negative[0]);
+  EXPECT_TRUE(packet.negative[1]);
+  EXPECT_FALSE(packet.negative[2]);
+  EXPECT_EQ(0.f, packet.origin_lower[1]);
+  EXPECT_EQ(2.f, packet.origin_upper[1]);
+  EXPECT_EQ(-1.f, packet.inverse_lower[1]);
+  EXPECT_EQ(-0.25f, packet.inverse_upper[1]);
+  EXPECT_EQ(0.5f, packet.inverse_direction[2][1]);
+  // inactive rays never hit anything
+  EXPECT_EQ(-1.f, packet.tmax[0]);
+  EXPECT_EQ(5.f, packet.tmax[1]);
+  EXPECT_EQ(1.f, packet.ray(3).origin[0]);
+
+  packet.set(5, Ray3df{{0.f, 0.f, 0.f}, {1.f, -1.f, 0.f}}, 1.f);
+  packet.prepare();
+  EXPECT_TRUE(packet.coherent);
+  EXPECT_FALSE(packet.bounded);
+  packet.set(6, Ray3df{{0.f, 0.f, 0.f}, {-1.f, -1.f, 1.f}}, 1.f);
+  packet.prepare();
+  EXPECT_FALSE(packet.coherent);
+}
+
+TEST(RAY_PACKET, TraversalFindsTheLeavesOfEveryRay) {
+  BVH3df tree(random_boxes(2000, 1));
+  Linear_BVH3df bvh(tree);
+  std::mt19937 generator(2);
+  std::uniform_real_distribution<float> position(-60.f, 60.f), direction(-1.f, 1.f);
+  Packet_Statistics statistics;
+
+  for (int p = 0; p < 200; p++) {
+    Vector3df origin = {position(generator), position(generator), position(generator)},
+              center = {direction(generator), direction(generator), direction(generator)};
+    Ray_Packet packet = nearby_rays(generator, origin, center, p % 2 == 0 ? 0.01f : 0.2f);
+    packet.prepare();
+    if (!packet.coherent) {
+      continue;
+    }
+
+    // the leaves reported for each ray (by their first primitive)
+    std::vector<std::set<uint32_t>> leaves(Ray_Packet::WIDTH);
+    auto leaf = [&](uint32_t first, uint32_t, Ray_Packet &, unsigned mask) {
+      for (size_t i = 0; i < Ray_Packet::WIDTH; i++) {
+        if (mask & (1u << i)) {
+          leaves[i].insert(first);
+        }
+      }
+      return 0u;
+    };
+    traverse_packet(bvh, packet, [](void * context, uint32_t first, uint32_t count, Ray_Packet & rays, unsigned mask) {
+      return (*static_cast<decltype(leaf) *>(context))(first, count, rays, mask);
+    }, &leaf, &statistics);
+
+    // every leaf a single ray reaches must be reported for it
+    for (size_t i = 0; i < Ray_Packet::WIDTH; i++) {
+      bvh.any_hit_leaves(packet.ray(i), packet.tmax[i], [&](uint32_t first, uint32_t) {
+        EXPECT_TRUE(leaves[i].count(first)) << "ray " << i << " of packet " << p;
+        return false;
+      });
+    }
+  }
+  EXPECT_GT(statistics.nodes_visited, 0u);
+  EXPECT_GT(statistics.nodes_culled, 0u);
+}
+
+TEST(RAY_PACKET, TraversalStopsForFinishedRays) {
+  BVH3df tree(random_boxes(500, 3));
+  Linear_BVH3df bvh(tree);
+  std::mt19937 generator(4);
+  Ray_Packet packet = nearby_rays(generator, {0.f, 0.f, 0.f}, {1.f, 0.5f, 0.25f}, 0.1f);
+  packet.prepare();
+  ASSERT_TRUE(packet.coherent);
+
+  // every ray is finished at its first leaf
+  unsigned reported = 0;
+  auto leaf = [&](uint32_t, uint32_t, Ray_Packet &, unsigned mask) {
+    EXPECT_EQ(0u, reported & mask);
+    reported |= mask;
+    return mask;
+  };
+  traverse_packet(bvh, packet, [](void * context, uint32_t first, uint32_t count, Ray_Packet & rays, unsigned mask) {
+    return (*static_cast<decltype(leaf) *>(context))(first, count, rays, mask);
+  }, &leaf);
+  EXPECT_EQ(reported, 0xffu & ~packet.active);
+}
+
+}
@@ -1,9 +1,15 @@
 #include "math.h"
 #include "geometry.h"
-#include "color.h"
+#include "framebuffer.h"
+#include "camera.h"
+#include "renderer.h"
+#include "scene.h"
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <string>
 
 // Die folgenden Kommentare beschreiben Datenstrukturen und Funktionen
 // Die Datenstrukturen und Funktionen die weiter hinten im Text beschrieben sind,
@@ -15,12 +21,14 @@
 // Der Bildschirm hat eine Auflösung (Breite x Höhe)
 // Kann zur Ausgabe einer PPM-Datei verwendet werden oder
 // mit SDL2 implementiert werden.
+// Der Bildschirm ist in framebuffer.h/cc implementiert (Ausgabe als binäre PPM-Datei, P6).
 
 
 
 // Eine "Kamera", die von einem Augenpunkt aus in eine Richtung senkrecht auf ein Rechteck (das Bild) zeigt.
 // Für das Rechteck muss die Auflösung oder alternativ die Pixelbreite und -höhe bekannt sein.
 // Für ein Pixel mit Bildkoordinate kann ein Sehstrahl erzeugt werden.
+// Die Kamera ist in camera.h/cc implementiert (Augenpunkt, Zielpunkt und Oben-Richtung, Sehstrahlen zeilenweise).
 
 
 
@@ -54,14 +62,7 @@
 // Punktförmige "Lichtquellen" können einfach als Vector3df implementiert werden mit weisser Farbe,
 // bei farbigen Lichtquellen müssen die entsprechenden Daten in Objekt zusammengefaßt werden
 // Bei mehreren Lichtquellen können diese in einen std::vector gespeichert werden.
-class light {
-public:
-    Vector3df center;
-    Vector3df color = {0.f, 0.f, 0.f};
 
-    light(const Vector3df &center)
-    : center(center){}
-};
 // Sie benötigen eine Implementierung von Lambertian-Shading, z.B. als Funktion
 // Benötigte Werte können als Parameter übergeben werden, oder wenn diese Funktion eine Objektmethode eines
 // Szene-Objekts ist, dann kann auf die Werte teilweise direkt zugegriffen werden.
@@ -72,79 +73,98 @@ public:
 // Am besten einen Zeiger auf das Objekt zurückgeben. Wenn dieser nullptr ist, dann gibt es kein sichtbares Objekt.
 
 // Die rekursive raytracing-Methode. Am besten ab einer bestimmten Rekursionstiefe (z.B. als Parameter übergeben) abbrechen.
-class wObject {
-public:
-    Sphere3df  sphere;
-    Vector3df  color;
-    bool reflective;
-
-    wObject(): sphere({0.f, 0.f, 0.f}, 0.f), color({0.f, 0.f, 0.f}), reflective(false) {}
-    wObject(const Sphere3df &s, const Vector3df &c, const bool &r )
-    : sphere(s), color(c), reflective(r) {}
-};
-
-class worldObjects {
-public:
-    std::vector<wObject> objects;
-    std::vector<light> lights;
-    worldObjects();
-    worldObjects(wObject object) { add(object); }
-
-    void add(wObject object) { objects.push_back(object); }
-
-    template<class FLOAT, size_t N>
-    wObject* hit(const Ray<FLOAT, N> &r, Intersection_Context<FLOAT, N> &rec) {
-        wObject nearest;
-        Intersection_Context<FLOAT, N> temp_rec;
-        float closest_so_far = std::numeric_limits<float>::max();
-
-        for (const auto &object: objects) {
-            if (object.sphere.intersects(r, temp_rec)) {
-                if (closest_so_far > temp_rec.t && temp_rec.t > 0) {
-                    closest_so_far = temp_rec.t;
-                    nearest = object;
-                    rec = temp_rec;
-                }
-            }
-        }
 
-        if(closest_so_far == std::numeric_limits<float>::max())
-            return nullptr;
+// Lichtquellen, Objekte, die Szene und die raytracing-Methode sind in scene.h/cc implementiert.
 
-        return new wObject(nearest.sphere, nearest.color, nearest.reflective);
-    }
+// Kommandozeilenoptionen
+struct Program_Options {
+    Render_Options render;
+    BVH_Build_Options bvh;
+    BVH_Layout bvh_layout = BVH_Layout::AUTOMATIC;
+    Path_Termination termination;
+    std::string output = "-";  // "-" = Standardausgabe
 };
-template<class FLOAT, size_t N>
-Vector<FLOAT, N> ray_color(const Ray<FLOAT, N> &r, worldObjects& world, int depth) {
-    Intersection_Context<FLOAT, N> rec;
-    Intersection_Context<FLOAT, N> shader_Rec;
-
-    wObject* object = world.hit(r, rec);
-    if (depth > 0 && world.hit(r, rec) != nullptr ) {
-        Vector3df lambertarian = (world.lights[0].center -  rec.intersection);
-        Ray3df shaderRay = {rec.intersection + 0.01f * rec.normal, lambertarian};
-        world.hit(shaderRay,shader_Rec);
-        float intensety = 0.f;
-        if(shader_Rec.t > 0 && shader_Rec.t < 1){
-            intensety = 0.3f;
-        } else {
-            lambertarian.normalize();
-            intensety = rec.normal * lambertarian;
+
+// setzt order auf die Reihenfolge mit dem gegebenen Namen, false bei unbekannten Namen
+bool parse_order(const char *name, Traversal_Order &order) {
+    const char *names[] = {"scanline", "morton", "hilbert"};
+    for (int i = 0; i < 3; i++) {
+        if (std::strcmp(name, names[i]) == 0) {
+            order = static_cast<Traversal_Order>(i);
+            return true;
         }
-        if ( intensety < 0.3f){
-            intensety = 0.3f;
+    }
+    return false;
+}
+
+// -t/--threads <Anzahl Threads> (0 = alle Kerne), --tile-size <Pixel>,
+// --bvh-split median|sah, --bvh-bins <Anzahl>, --bvh-leaf-size <Anzahl Objekte>,
+// --bvh-layout binary|bvh4|bvh8|auto, -o/--output <Datei> (- = Standardausgabe),
+// --min-throughput <Faktor>, --roulette <Faktor> (Pfadabbruch, 0 = aus),
+// --tile-order scanline|morton|hilbert, --pixel-order scanline|morton|hilbert (Reihenfolge der Kacheln/Pixel),
+// --packets on|off (Sehstrahlen und Schattenstrahlen in Paketen zu 8 Strahlen, auto-Layout wird dann binary),
+// --wavefront on|off (alle Pfade einer Kachel Reflexion für Reflexion in Warteschlangen verfolgen)
+Program_Options parse_options(int argc, char *argv[]) {
+    Program_Options options;
+    for (int i = 1; i < argc; i += 2) {
+        if (i + 1 == argc) {
+            std::cerr << "missing value for option " << argv[i] << "\n";
+            std::exit(EXIT_FAILURE);
         }
-        if(object->reflective) {
-            Vector3df reflective_Vec = r.direction - 2.f * (r.direction * rec.normal) * rec.normal;
-            Ray3df reflective_r = {rec.intersection + 0.1f * rec.normal, reflective_Vec};
-            return intensety * ray_color(reflective_r, world, depth - 1);
+        if (std::strcmp(argv[i], "-t") == 0 || std::strcmp(argv[i], "--threads") == 0) {
+            options.render.threads = static_cast<unsigned>(std::atoi(argv[i + 1]));
+            options.bvh.threads = options.render.threads;
+        } else if (std::strcmp(argv[i], "--tile-size") == 0) {
+            options.render.tile_size = std::atoi(argv[i + 1]);
+            if (options.render.tile_size > MAX_TILE_SIZE) {
+                std::cerr << "tile size " << argv[i + 1] << " exceeds " << MAX_TILE_SIZE << "\n";
+                std::exit(EXIT_FAILURE);
+            }
+        } else if (std::strcmp(argv[i], "--bvh-split") == 0 && std::strcmp(argv[i + 1], "median") == 0) {
+            options.bvh.split = BVH_Split::MEDIAN;
+        } else if (std::strcmp(argv[i], "--bvh-split") == 0 && std::strcmp(argv[i + 1], "sah") == 0) {
+            options.bvh.split = BVH_Split::BINNED_SAH;
+        } else if (std::strcmp(argv[i], "--bvh-bins") == 0) {
+            options.bvh.bins = static_cast<size_t>(std::atoi(argv[i + 1]));
+        } else if (std::strcmp(argv[i], "--bvh-leaf-size") == 0) {
+            options.bvh.max_leaf_size = static_cast<size_t>(std::atoi(argv[i + 1]));
+        } else if (std::strcmp(argv[i], "--tile-order") == 0 && parse_order(argv[i + 1], options.render.tile_order)) {
+            // von parse_order gesetzt
+        } else if (std::strcmp(argv[i], "--pixel-order") == 0 && parse_order(argv[i + 1], options.render.pixel_order)) {
+            // von parse_order gesetzt
+        } else if (std::strcmp(argv[i], "--packets") == 0 && std::strcmp(argv[i + 1], "on") == 0) {
+            options.render.packets = true;
+        } else if (std::strcmp(argv[i], "--packets") == 0 && std::strcmp(argv[i + 1], "off") == 0) {
+            options.render.packets = false;
+        } else if (std::strcmp(argv[i], "--wavefront") == 0 && std::strcmp(argv[i + 1], "on") == 0) {
+            options.render.wavefront = true;
+        } else if (std::strcmp(argv[i], "--wavefront") == 0 && std::strcmp(argv[i + 1], "off") == 0) {
+            options.render.wavefront = false;
+        } else if (std::strcmp(argv[i], "--min-throughput") == 0) {
+            options.termination.min_throughput = static_cast<float>(std::atof(argv[i + 1]));
+        } else if (std::strcmp(argv[i], "--roulette") == 0) {
+            options.termination.roulette_throughput = static_cast<float>(std::atof(argv[i + 1]));
+        } else if (std::strcmp(argv[i], "-o") == 0 || std::strcmp(argv[i], "--output") == 0) {
+            options.output = argv[i + 1];
+        } else if (std::strcmp(argv[i], "--bvh-layout") == 0 && std::strcmp(argv[i + 1], "binary") == 0) {
+            options.bvh_layout = BVH_Layout::BINARY;
+        } else if (std::strcmp(argv[i], "--bvh-layout") == 0 && std::strcmp(argv[i + 1], "bvh4") == 0) {
+            options.bvh_layout = BVH_Layout::WIDE_4;
+        } else if (std::strcmp(argv[i], "--bvh-layout") == 0 && std::strcmp(argv[i + 1], "bvh8") == 0) {
+            options.bvh_layout = BVH_Layout::WIDE_8;
+        } else if (std::strcmp(argv[i], "--bvh-layout") == 0 && std::strcmp(argv[i + 1], "auto") == 0) {
+            options.bvh_layout = BVH_Layout::AUTOMATIC;
+        } else {
+            std::cerr << "unknown option " << argv[i] << ' ' << argv[i + 1] << "\n";
+            std::exit(EXIT_FAILURE);
         }
-        return intensety * object->color;
     }
-    return Vector3df {0.f, 0.f, 0.f};
+    return options;
 }
 
-int main(void) {
+int main(int argc, char *argv[]) {
+    Program_Options options = parse_options(argc, argv);
+
     // Bildschirm erstellen
     // Kamera erstellen
     // Für jede Pixelkoordinate x,y
@@ -159,57 +179,33 @@ int main(void) {
     int image_height = static_cast<int>(image_width / aspect_ratio);
     image_height = (image_height < 1) ? 1 : image_height;
 
-    //rot
-    worldObjects world(wObject(Sphere3df({3.f, -8.f, -13.f}, 2.f), Vector3df({1.f, 0.f, 0.f}), false));
-    //Lila
-    world.add(wObject(Sphere3df({-9.f, -8.f, -17.f}, 3.f), Vector3df({0.5f, 0.f, 0.5f}), true));
-
-    //RechteWand
-    world.add(wObject(Sphere3df({10021.f, 0.0f, 0.f }, 10000.f), Vector3df({0.f, 1.f, 0.f}), false));
-    //Linkewand
-    world.add(wObject(Sphere3df({ -10021.f, 0.0f, 0.f }, 10000.f), Vector3df({1.f, 1.f, 0.f}), false));
-    //Boden
-    world.add(wObject(Sphere3df({0.f, -10012.0f, 0.f}, 10000.f), Vector3df({0.f, 0.f, 1.f}), false));
-    //Decke
-    world.add(wObject(Sphere3df({0.f, 10012.0f, 0.f}, 10000.f), Vector3df({0.5f, 0.5f, 1.f}), false));
-    //Rückwand
-    world.add(wObject(Sphere3df({0.0f, 0.0f, -10030.f}, 10000.f), Vector3df({0.3f, 1.f, 1.f}), false));
-    //Off wand
-    world.add(wObject(Sphere3df({0.0f, 0.0f, 10030.f}, 10000.f), Vector3df({.9f, .2f, 0.f}), false));
-    //world.add(wObject(Sphere3df({-10.f, 12.f, -18.f}, 1.f), Vector3df({0.f, 1.f, 1.f}), false));
-
-    light light(Vector3df {0.f, 11.f, -18.f});
-
-    world.lights.push_back(light);
-
-    float focal_length = 5.f;
-    float viewport_height = 9.f;
-    float viewport_width = viewport_height * (image_width/image_height);
-    Vector3df camera_center = {0.f,0.f,0.f};
-
-    // Calculate the vectors across the horizontal and down the vertical viewport edges.
-    Vector3df viewport_u = Vector3df{viewport_width, 0.f, 0.f};
-    Vector3df viewport_v = Vector3df{0.f, -viewport_height, 0.f};
-
-    // Calculate the horizontal and vertical delta vectors from pixel to pixel.
-    Vector3df pixel_delta_u = (1.f/image_width) * viewport_u;
-    Vector3df pixel_delta_v = (1.f/image_height) * viewport_v;
-
-    Vector3df viewport_upper_left = camera_center - Vector3df{0.f, 0.f, focal_length} - ((1/2.f) * viewport_u ) - ((1/2.f) * viewport_v);
-    Vector3df pixel00_loc = viewport_upper_left + (0.5f * (pixel_delta_u + pixel_delta_v));
+    worldObjects world = cornell_box();
+    // Pakete (auch die der Wavefront-Stufen) werden nur durch die binäre BVH verfolgt
+    if ((options.render.packets || options.render.wavefront) && options.bvh_layout == BVH_Layout::AUTOMATIC) {
+        options.bvh_layout = BVH_Layout::BINARY;
+    }
+    world.build(options.bvh, options.bvh_layout);
+    const BVH_Build_Statistics &bvh_statistics = world.bvh_statistics();
+    const char *layout_names[] = {"binary", "bvh4", "bvh8"};
+    std::clog << "BVH (" << layout_names[static_cast<int>(world.bvh_layout())] << "): " << bvh_statistics.node_count << " nodes, " << bvh_statistics.leaf_count << " leaves, depth "
+              << bvh_statistics.depth << ", SAH cost " << bvh_statistics.sah_cost << ", built in "
+              << 1000.0 * bvh_statistics.build_seconds << " ms\n";
 
     //Render
-    std::cout << "P3\n" << image_width << ' ' << image_height << "\n255\n";
-    for (int j = 0; j < image_height; ++j) {
-        std::clog << "\r Scanline remaining: " << (image_height - j) << ' ' << std::flush;
-        for (int i = 0; i < image_width; ++i) {
-            auto pixel_center = pixel00_loc + ((float) i * pixel_delta_u) + ((float) j * pixel_delta_v);
-            auto ray_dircetion = pixel_center + camera_center;
-
-            Ray3df r = Ray3df({camera_center, ray_dircetion});
-            Vector pixel_color = ray_color(r,world, 5);
-            write_color(std::cout, pixel_color);
-        }
+    Framebuffer framebuffer(static_cast<int>(image_width), image_height);
+    Camera camera(framebuffer.width(), framebuffer.height());
+    std::clog << "Rendering with " << worker_threads(options.render) << " threads\n";
+    Path_Statistics path_statistics;
+    render(world, camera, framebuffer, options.render, 5, options.termination, &path_statistics);
+    std::clog << "Paths: " << path_statistics.bounces << " bounces, " << path_statistics.terminated_by_throughput
+              << " cut off, " << path_statistics.terminated_by_roulette << " terminated by russian roulette, "
+              << path_statistics.bounces_saved << " bounces saved\n";
+
+    if (options.output == "-") {
+        framebuffer.write_ppm(std::cout);
+    } else if (!framebuffer.write_ppm(options.output)) {
+        std::cerr << "could not write " << options.output << "\n";
+        return EXIT_FAILURE;
     }
     std::clog << "\rDone.                \n";
     return 0;
@@ -0,0 +1,200 @@
+#include "renderer.h"
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace {
+
+uint64_t pack(uint64_t begin, uint64_t end) {
+  return (begin << 32u) | end;
+}
+
+uint64_t begin_of(uint64_t range) {
+  return range >> 32u;
+}
+
+uint64_t end_of(uint64_t range) {
+  return range & 0xffffffffu;
+}
+
+}
+
+namespace {
+
+// spreads the lower 32 bits of v to the even bits of the result
+uint64_t spread_bits(uint64_t v) {
+  v &= 0xffffffffu;
+  v = (v | (v << 16u)) & 0x0000ffff0000ffffu;
+  v = (v | (v << 8u)) & 0x00ff00ff00ff00ffu;
+  v = (v | (v << 4u)) & 0x0f0f0f0f0f0f0f0fu;
+  v = (v | (v << 2u)) & 0x3333333333333333u;
+  v = (v | (v << 1u)) & 0x5555555555555555u;
+  return v;
+}
+
+// returns the distance of (x, y) along the hilbert curve through a size x size grid, size is a power of 2
+uint64_t hilbert_distance(uint32_t size, uint32_t x, uint32_t y) {
+  uint64_t distance = 0;
+  for (uint32_t s = size / 2u; s > 0u; s /= 2u) {
+    uint32_t rx = (x & s) > 0u ? 1u : 0u,
+             ry = (y & s) > 0u ? 1u : 0u;
+    distance += static_cast<uint64_t>(s) * s * ((3u * rx) ^ ry);
+    // rotates the quadrant, so that the curve in it starts and ends next to its neighbouring quadrants
+    if (ry == 0u) {
+      if (rx == 1u) {
+        x = size - 1u - x;
+        y = size - 1u - y;
+      }
+      std::swap(x, y);
+    }
+  }
+  return distance;
+}
+
+}
+
+uint64_t traversal_key(Traversal_Order order, uint32_t x, uint32_t y, uint32_t width, uint32_t height) {
+  switch (order) {
+  case Traversal_Order::MORTON:
+    return spread_bits(x) | (spread_bits(y) << 1u);
+  case Traversal_Order::HILBERT: {
+    uint32_t size = 1u;
+    while (size < width || size < height) {
+      size *= 2u;
+    }
+    return hilbert_distance(size, x, y);
+  }
+  default:
+    return static_cast<uint64_t>(y) * width + x;
+  }
+}
+
+std::vector<Pixel_Offset> make_pixel_order(int width, int height, Traversal_Order order) {
+  if (width > MAX_TILE_SIZE || height > MAX_TILE_SIZE) {
+    throw std::invalid_argument("make_pixel_order: tile larger than MAX_TILE_SIZE");
+  }
+  width = std::max(width, 1);
+  height = std::max(height, 1);
+  // the keys of all orders stay below 2^32 for such tiles, so key and offset are packed into one word:
+  // the key in the high, y and x in the low 32 bits
+  std::vector<uint64_t> keyed;
+  keyed.reserve(static_cast<size_t>(width) * static_cast<size_t>(height));
+  for (uint32_t y = 0; y < static_cast<uint32_t>(height); y++) {
+    for (uint32_t x = 0; x < static_cast<uint32_t>(width); x++) {
+      uint64_t key = traversal_key(order, x, y, static_cast<uint32_t>(width), static_cast<uint32_t>(height));
+      keyed.push_back(key << 32u | y << 16u | x);
+    }
+  }
+  std::sort(keyed.begin(), keyed.end());
+
+  std::vector<Pixel_Offset> offsets;
+  offsets.reserve(keyed.size());
+  for (uint64_t key_and_offset : keyed) {
+    offsets.push_back({static_cast<uint16_t>(key_and_offset & 0xffffu), static_cast<uint16_t>(key_and_offset >> 16u & 0xffffu)});
+  }
+  return offsets;
+}
+
+std::vector<Pixel_Offset> make_pixel_order(int tile_size, Traversal_Order order) {
+  return make_pixel_order(tile_size, tile_size, order);
+}
+
+std::vector<Tile> make_tiles(int width, int height, int tile_size, Traversal_Order order) {
+  if (tile_size > MAX_TILE_SIZE) {
+    throw std::invalid_argument("make_tiles: tile_size larger than MAX_TILE_SIZE");
+  }
+  std::vector<Tile> tiles;
+  tile_size = std::max(tile_size, 1);
+  for (int y = 0; y < height; y += tile_size) {
+    for (int x = 0; x < width; x += tile_size) {
+      tiles.push_back({x, y, std::min(x + tile_size, width), std::min(y + tile_size, height)});
+    }
+  }
+  if (order != Traversal_Order::SCANLINE) {
+    uint32_t columns = static_cast<uint32_t>((width + tile_size - 1) / tile_size),
+             rows = static_cast<uint32_t>((height + tile_size - 1) / tile_size);
+    auto key = [&](const Tile & tile) {
+      return traversal_key(order, tile.x0 / tile_size, tile.y0 / tile_size, columns, rows);
+    };
+    std::sort(tiles.begin(), tiles.end(), [&](const Tile & a, const Tile & b) { return key(a) < key(b); });
+  }
+  return tiles;
+}
+
+Tile_Scheduler::Tile_Scheduler(size_t tile_count, unsigned worker_count)
+  : worker_count(std::max(worker_count, 1u)), ranges(new Work_Range[this->worker_count])
+{
+  // every worker starts with an equally sized contiguous block of tiles,
+  // neighbouring tiles are rendered by the same worker as long as nobody steals them
+  for (unsigned w = 0; w < this->worker_count; w++) {
+    size_t begin = tile_count * w / this->worker_count;
+    size_t end = tile_count * (w + 1) / this->worker_count;
+    ranges[w].range.store(pack(begin, end), std::memory_order_relaxed);
+  }
+}
+
+bool Tile_Scheduler::next(unsigned worker, size_t & tile) {
+  std::atomic<uint64_t> & own = ranges[worker].range;
+  uint64_t range = own.load(std::memory_order_acquire);
+  while (begin_of(range) < end_of(range)) {
+    if (own.compare_exchange_weak(range, pack(begin_of(range) + 1, end_of(range)), std::memory_order_acq_rel)) {
+      tile = begin_of(range);
+      return true;
+    }
+  }
+  return steal(worker, tile);
+}
+
+bool Tile_Scheduler::steal(unsigned worker, size_t & tile) {
+  for (unsigned i = 1; i < worker_count; i++) {
+    std::atomic<uint64_t> & victim = ranges[(worker + i) % worker_count].range;
+    uint64_t range = victim.load(std::memory_order_acquire);
+    while (begin_of(range) < end_of(range)) {
+      uint64_t begin = begin_of(range),
+               end = end_of(range),
+               split = end - (end - begin + 1) / 2;
+      if (victim.compare_exchange_weak(range, pack(begin, split), std::memory_order_acq_rel)) {
+        // the own range is empty, so no other worker modifies it concurrently
+        ranges[worker].range.store(pack(split + 1, end), std::memory_order_release);
+        steal_count.fetch_add(1, std::memory_order_relaxed);
+        tile = split;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+size_t Tile_Scheduler::steals() const {
+  return steal_count.load(std::memory_order_relaxed);
+}
+
+unsigned worker_threads(const Render_Options & options) {
+  if (options.threads > 0) {
+    return options.threads;
+  }
+  return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+void render_tiles(int width, int height, const Render_Options & options, const std::function<void(const Tile &)> & render_tile) {
+  std::vector<Tile> tiles = make_tiles(width, height, options.tile_size, options.tile_order);
+  unsigned thread_count = std::min<size_t>(worker_threads(options), std::max<size_t>(tiles.size(), 1));
+  Tile_Scheduler scheduler(tiles.size(), thread_count);
+
+  auto worker = [&](unsigned id) {
+    size_t tile;
+    while (scheduler.next(id, tile)) {
+      render_tile(tiles[tile]);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (unsigned id = 1; id < thread_count; id++) {
+    threads.emplace_back(worker, id);
+  }
+  worker(0);  // the calling thread is worker 0
+  for (std::thread & thread : threads) {
+    thread.join();
+  }
+}
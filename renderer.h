@@ -0,0 +1,106 @@
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// contains the tile based parallel rendering infrastructure, i.e. splitting an image into tiles
+// and distributing the tiles over a pool of worker threads
+
+
+// a rectangular block of pixels covering the columns x0 <= x < x1 and the rows y0 <= y < y1
+struct Tile {
+  int x0, y0,
+      x1, y1;
+};
+
+// the order in which the tiles of an image or the pixels of a tile are visited
+// MORTON (z-order) and HILBERT visit the cells of a grid along a space filling curve, so that cells close in the
+// order are close in the image, too (HILBERT never jumps, MORTON is cheaper to compute)
+enum class Traversal_Order {
+  SCANLINE,  // row by row, from left to right
+  MORTON,
+  HILBERT
+};
+
+// returns the position of cell (x, y) along the given order on a grid with width x height cells
+uint64_t traversal_key(Traversal_Order order, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+
+// a pixel relative to the top left corner of its tile
+struct Pixel_Offset {
+  uint16_t x, y;
+};
+
+// the largest edge length of a tile, the offsets of its pixels have to fit into a Pixel_Offset
+const int MAX_TILE_SIZE = UINT16_MAX;
+
+// returns the offsets of all pixels of a width x height tile in the given order
+// tiles at the right and bottom border of an image skip the offsets outside of them
+// throws std::invalid_argument if width or height exceeds MAX_TILE_SIZE
+std::vector<Pixel_Offset> make_pixel_order(int width, int height, Traversal_Order order);
+
+// the same for a tile_size x tile_size tile
+std::vector<Pixel_Offset> make_pixel_order(int tile_size, Traversal_Order order);
+
+// splits an image with the given width and height into tiles of at most tile_size x tile_size pixels
+// the tiles are ordered by order (by default row by row), tiles at the right and bottom border may be smaller
+// throws std::invalid_argument if tile_size exceeds MAX_TILE_SIZE
+std::vector<Tile> make_tiles(int width, int height, int tile_size, Traversal_Order order = Traversal_Order::SCANLINE);
+
+
+// distributes the indices 0 <= i < tile_count over worker_count workers (work stealing)
+// every worker owns a contiguous range of tile indices and takes tiles from the front of it,
+// a worker without tiles left steals the back half of the range of another worker
+// the ranges are single atomic words, so neither taking nor stealing a tile needs a lock
+class Tile_Scheduler {
+public:
+  Tile_Scheduler(size_t tile_count, unsigned worker_count);
+
+  // returns true and sets tile to the next tile index for the given worker,
+  // returns false if no tiles are left for any worker
+  bool next(unsigned worker, size_t & tile);
+
+  // returns the number of successful steals so far
+  size_t steals() const;
+
+private:
+  // [begin, end) packed into one word (begin in the high, end in the low 32 bits),
+  // aligned to a cache line to avoid false sharing between the workers
+  struct alignas(64) Work_Range {
+    std::atomic<uint64_t> range{0};
+  };
+
+  bool steal(unsigned worker, size_t & tile);
+
+  unsigned worker_count;
+  std::unique_ptr<Work_Range[]> ranges;
+  std::atomic<size_t> steal_count{0};
+};
+
+
+struct Render_Options {
+  unsigned threads = 0;  // number of worker threads, 0 selects std::thread::hardware_concurrency()
+  int tile_size = 32;    // edge length of the (square) tiles in pixels, at most MAX_TILE_SIZE
+  Traversal_Order tile_order = Traversal_Order::SCANLINE,   // order of the tiles (contiguous ranges of which
+                                                            //   are assigned to the workers)
+                  pixel_order = Traversal_Order::SCANLINE;  // order of the pixels within a tile
+  bool packets = false;  // trace the rays of up to 8 neighbouring pixels of a row together (only with SCANLINE
+                         //   pixel_order)
+  bool wavefront = false;  // follow the paths of all pixels of a tile bounce by bounce in queues (see wavefront.h),
+                           //   pixel_order and packets are ignored then
+};
+
+// returns the number of worker threads used for the given options
+unsigned worker_threads(const Render_Options & options);
+
+// calls render_tile for every tile of a width x height image on a pool of worker threads
+// the tiles are distributed in options.tile_order, options.pixel_order is left to render_tile
+// render_tile is called concurrently for different tiles and must only write pixels of its own tile
+// returns after all tiles are rendered
+void render_tiles(int width, int height, const Render_Options & options, const std::function<void(const Tile &)> & render_tile);
+
+#endif
@@ -0,0 +1,156 @@
+#include "renderer.h"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+TEST(TILES, MakeTilesCoversImage) {
+  std::vector<Tile> tiles = make_tiles(100, 70, 32);
+
+  ASSERT_EQ(12u, tiles.size());
+  EXPECT_EQ(0, tiles[0].x0);
+  EXPECT_EQ(0, tiles[0].y0);
+  EXPECT_EQ(32, tiles[0].x1);
+  EXPECT_EQ(32, tiles[0].y1);
+  EXPECT_EQ(96, tiles[11].x0);
+  EXPECT_EQ(64, tiles[11].y0);
+  EXPECT_EQ(100, tiles[11].x1);
+  EXPECT_EQ(70, tiles[11].y1);
+}
+
+TEST(TILES, MakeTilesEmptyImage) {
+  EXPECT_TRUE(make_tiles(0, 10, 32).empty());
+  EXPECT_TRUE(make_tiles(10, 0, 32).empty());
+}
+
+TEST(TILES, TileSizeIsLimited) {
+  std::vector<Tile> tiles = make_tiles(100, 70, MAX_TILE_SIZE);
+  ASSERT_EQ(1u, tiles.size());
+  EXPECT_EQ(100, tiles[0].x1);
+  EXPECT_EQ(70, tiles[0].y1);
+  EXPECT_THROW(make_tiles(100, 70, MAX_TILE_SIZE + 1), std::invalid_argument);
+  EXPECT_THROW(make_pixel_order(MAX_TILE_SIZE + 1, Traversal_Order::MORTON), std::invalid_argument);
+  EXPECT_THROW(make_pixel_order(4, MAX_TILE_SIZE + 1, Traversal_Order::MORTON), std::invalid_argument);
+}
+
+TEST(TILE_SCHEDULER, SingleWorkerGetsTilesInOrder) {
+  Tile_Scheduler scheduler(5, 1);
+  size_t tile;
+
+  for (size_t i = 0; i < 5; i++) {
+    ASSERT_TRUE(scheduler.next(0, tile));
+    EXPECT_EQ(i, tile);
+  }
+  EXPECT_FALSE(scheduler.next(0, tile));
+  EXPECT_EQ(0u, scheduler.steals());
+}
+
+TEST(TILE_SCHEDULER, IdleWorkerStealsAllTiles) {
+  Tile_Scheduler scheduler(100, 4);
+  std::vector<int> taken(100, 0);
+  size_t tile;
+
+  while (scheduler.next(3, tile)) {
+    taken[tile]++;
+  }
+  for (int count : taken) {
+    EXPECT_EQ(1, count);
+  }
+  EXPECT_GT(scheduler.steals(), 0u);
+}
+
+TEST(RENDER_TILES, EveryPixelRenderedOnce) {
+  const int width = 203, height = 97;
+  std::vector<std::atomic<int>> pixels(width * height);
+  Render_Options options;
+  options.threads = 8;
+  options.tile_size = 16;
+
+  render_tiles(width, height, options, [&](const Tile & tile) {
+    for (int y = tile.y0; y < tile.y1; y++) {
+      for (int x = tile.x0; x < tile.x1; x++) {
+        pixels[y * width + x]++;
+      }
+    }
+  });
+
+  for (const std::atomic<int> & count : pixels) {
+    EXPECT_EQ(1, count.load());
+  }
+}
+
+TEST(TILES, TraversalKeys) {
+  EXPECT_EQ(5u, traversal_key(Traversal_Order::SCANLINE, 1, 1, 4, 4));
+  EXPECT_EQ(1u, traversal_key(Traversal_Order::MORTON, 1, 0, 4, 4));
+  EXPECT_EQ(2u, traversal_key(Traversal_Order::MORTON, 0, 1, 4, 4));
+  EXPECT_EQ(4u, traversal_key(Traversal_Order::MORTON, 2, 0, 4, 4));
+  EXPECT_EQ(0u, traversal_key(Traversal_Order::HILBERT, 0, 0, 2, 2));
+  EXPECT_EQ(1u, traversal_key(Traversal_Order::HILBERT, 0, 1, 2, 2));
+  EXPECT_EQ(2u, traversal_key(Traversal_Order::HILBERT, 1, 1, 2, 2));
+  EXPECT_EQ(3u, traversal_key(Traversal_Order::HILBERT, 1, 0, 2, 2));
+}
+
+TEST(TILES, PixelOrderVisitsEveryPixelOnce) {
+  for (Traversal_Order order : {Traversal_Order::SCANLINE, Traversal_Order::MORTON, Traversal_Order::HILBERT}) {
+    std::vector<Pixel_Offset> offsets = make_pixel_order(6, order);
+    std::vector<int> visits(36, 0);
+    ASSERT_EQ(36u, offsets.size());
+    for (Pixel_Offset offset : offsets) {
+      ASSERT_LT(offset.x, 6);
+      ASSERT_LT(offset.y, 6);
+      visits[offset.y * 6 + offset.x]++;
+    }
+    for (int count : visits) {
+      EXPECT_EQ(1, count);
+    }
+  }
+}
+
+TEST(TILES, RectangularPixelOrderVisitsEveryPixelOnce) {
+  for (Traversal_Order order : {Traversal_Order::SCANLINE, Traversal_Order::MORTON, Traversal_Order::HILBERT}) {
+    std::vector<Pixel_Offset> offsets = make_pixel_order(7, 3, order);
+    std::vector<int> visits(21, 0);
+    ASSERT_EQ(21u, offsets.size());
+    for (Pixel_Offset offset : offsets) {
+      ASSERT_LT(offset.x, 7);
+      ASSERT_LT(offset.y, 3);
+      visits[offset.y * 7 + offset.x]++;
+    }
+    for (int count : visits) {
+      EXPECT_EQ(1, count);
+    }
+  }
+}
+
+TEST(TILES, HilbertOrderVisitsNeighbours) {
+  std::vector<Pixel_Offset> offsets = make_pixel_order(16, Traversal_Order::HILBERT);
+
+  for (size_t i = 1; i < offsets.size(); i++) {
+    EXPECT_EQ(1, std::abs(offsets[i].x - offsets[i - 1].x) + std::abs(offsets[i].y - offsets[i - 1].y));
+  }
+}
+
+TEST(TILES, OrderedTilesCoverImage) {
+  for (Traversal_Order order : {Traversal_Order::MORTON, Traversal_Order::HILBERT}) {
+    std::vector<Tile> tiles = make_tiles(100, 70, 16, order);
+    std::vector<int> pixels(100 * 70, 0);
+    ASSERT_EQ(35u, tiles.size());
+    EXPECT_EQ(0, tiles[0].x0);
+    EXPECT_EQ(0, tiles[0].y0);
+    for (const Tile & tile : tiles) {
+      for (int y = tile.y0; y < tile.y1; y++) {
+        for (int x = tile.x0; x < tile.x1; x++) {
+          pixels[y * 100 + x]++;
+        }
+      }
+    }
+    for (int count : pixels) {
+      EXPECT_EQ(1, count);
+    }
+  }
+}
+
+}
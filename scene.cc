@@ -0,0 +1,662 @@
+#include "scene.h"
+#include "wavefront.h"
+#include "bvh.tcc"
+#include "wide_bvh.tcc"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <random>
+
+void Scene_BVH::build(const BVH3df &tree, BVH_Layout layout) {
+    binary = layout == BVH_Layout::BINARY ? Linear_BVH3df(tree) : Linear_BVH3df();
+    wide4 = layout == BVH_Layout::WIDE_4 ? BVH4(tree) : BVH4();
+    wide8 = layout == BVH_Layout::WIDE_8 ? BVH8(tree) : BVH8();
+}
+
+void Scene_BVH::clear() {
+    binary = Linear_BVH3df();
+    wide4 = BVH4();
+    wide8 = BVH8();
+}
+
+namespace {
+
+// calls traverse with the tree of bvh which covers count primitives and returns its result,
+// returns linear() if no tree is up to date
+template <class TRAVERSE, class LINEAR>
+bool with_tree(const Scene_BVH &bvh, size_t count, TRAVERSE traverse, LINEAR linear) {
+    if (!bvh.wide8.empty() && bvh.wide8.primitive_count() == count) {
+        return traverse(bvh.wide8);
+    }
+    if (!bvh.wide4.empty() && bvh.wide4.primitive_count() == count) {
+        return traverse(bvh.wide4);
+    }
+    if (!bvh.binary.empty() && bvh.binary.primitive_count() == count) {
+        return traverse(bvh.binary);
+    }
+    return linear();
+}
+
+// stores the elements of values in the given order
+template <class T>
+void reorder(std::vector<T> &values, const std::vector<size_t> &order) {
+    std::vector<T> ordered;
+    ordered.reserve(values.size());
+    for (size_t i : order) {
+        ordered.push_back(values[i]);
+    }
+    values = std::move(ordered);
+}
+
+// returns the bvh over the given primitives and stores them and their materials in its leaf order
+template <class PRIMITIVE>
+BVH3df build_tree(std::vector<PRIMITIVE> &primitives, std::vector<Material> &materials, const BVH_Build_Options &options) {
+    BVH3df tree(bounding_boxes(primitives), options);
+
+    // the primitives of a leaf are then adjacent in memory
+    reorder(primitives, tree.primitive_order());
+    reorder(materials, tree.primitive_order());
+    return tree;
+}
+
+}
+
+void worldObjects::add(wObject object) {
+    spheres.push_back(object.sphere);
+    sphere_materials.push_back(Material{object.color, object.reflective});
+    object_bvh.clear();
+    sphere_arrays.clear();
+}
+
+void worldObjects::add(wTriangle triangle) {
+    triangles.push_back(triangle.triangle);
+    triangle_materials.push_back(Material{triangle.color, triangle.reflective});
+    triangle_arrays.push_back(triangle.triangle);
+    triangle_bvh.clear();
+}
+
+void worldObjects::add(wPlane plane) {
+    planes.push_back(plane.plane);
+    plane_materials.push_back(Material{plane.color, plane.reflective});
+}
+
+const Material &worldObjects::material(const Hit_Record3df &hit) const {
+    switch (hit.shape) {
+    case Shape::TRIANGLE:
+        return triangle_materials[hit.index];
+    case Shape::PLANE:
+        return plane_materials[hit.index];
+    default:
+        return sphere_materials[hit.index];
+    }
+}
+
+void worldObjects::build(const BVH_Build_Options &options, BVH_Layout layout) {
+    BVH3df object_tree = build_tree(spheres, sphere_materials, options),
+           triangle_tree = build_tree(triangles, triangle_materials, options);
+    sphere_arrays.clear();
+    for (const Sphere3df &sphere : spheres) {
+        sphere_arrays.push_back(sphere);
+    }
+    triangle_arrays.clear();
+    for (const Triangle3df &triangle : triangles) {
+        triangle_arrays.push_back(triangle);
+    }
+    statistics = object_tree.build_statistics();
+    const BVH_Build_Statistics &triangle_statistics = triangle_tree.build_statistics();
+    statistics.build_seconds += triangle_statistics.build_seconds;
+    statistics.node_count += triangle_statistics.node_count;
+    statistics.leaf_count += triangle_statistics.leaf_count;
+    statistics.depth = std::max(statistics.depth, triangle_statistics.depth);
+    statistics.sah_cost += triangle_statistics.sah_cost;
+
+    SIMD_Level simd = simd_level();
+    if (layout == BVH_Layout::AUTOMATIC) {
+        layout = BVH_Layout::WIDE_8;
+    }
+    if (layout == BVH_Layout::WIDE_8 && simd < BVH8::required_simd_level()) {
+        layout = BVH_Layout::WIDE_4;
+    }
+    if (layout == BVH_Layout::WIDE_4 && simd < BVH4::required_simd_level()) {
+        layout = BVH_Layout::BINARY;
+    }
+    this->layout = layout;
+    object_bvh.build(object_tree, layout);
+    triangle_bvh.build(triangle_tree, layout);
+}
+
+bool worldObjects::closest_object(Ray_Query3df &query, Hit_Record3df &hit) const {
+    return with_tree(object_bvh, spheres.size(), [&](const auto &tree) {
+        return tree.closest_hit_leaves(query, [&](uint32_t first, uint32_t count, float &t) {
+            if (!sphere_arrays.closest_hit(query.ray, first, count, query.tmin, t, hit.index)) {
+                return false;
+            }
+            hit.shape = Shape::SPHERE;
+            query.tmax = t;
+            return true;
+        });
+    }, [&] {
+        // every sphere lowers the interval of the query it is hit in
+        bool found = false;
+        for (size_t i = 0; i < spheres.size(); i++) {
+            if (spheres[i].intersects(query)) {
+                hit.shape = Shape::SPHERE;
+                hit.index = i;
+                found = true;
+            }
+        }
+        return found;
+    });
+}
+
+bool worldObjects::closest_triangle(Ray_Query3df &query, Hit_Record3df &hit) const {
+    if (triangle_arrays.empty()) {
+        return false;
+    }
+    auto leaf = [&](uint32_t first, uint32_t count, float &t) {
+        if (!triangle_arrays.closest_hit(query.ray, first, count, query.tmin, t, hit.index)) {
+            return false;
+        }
+        hit.shape = Shape::TRIANGLE;
+        query.tmax = t;
+        return true;
+    };
+    return with_tree(triangle_bvh, triangle_arrays.size(), [&](const auto &tree) {
+        return tree.closest_hit_leaves(query, leaf);
+    }, [&] {
+        float t = query.tmax;
+        return leaf(0, static_cast<uint32_t>(triangle_arrays.size()), t);
+    });
+}
+
+void worldObjects::finalize(const Ray3df &ray, float t, Hit_Record3df &hit) const {
+    // the kernels only find the closest surface and its t, intersection point and normal are computed once for it
+    switch (hit.shape) {
+    case Shape::SPHERE:
+        spheres[hit.index].finalize(ray, t, hit.context);
+        break;
+    case Shape::TRIANGLE:
+        triangle_arrays.finalize(ray, hit.index, t, hit.context);
+        break;
+    case Shape::PLANE:
+        planes[hit.index].finalize(ray, t, hit.context);
+        break;
+    }
+}
+
+bool worldObjects::closest_hit(const Ray_Query3df &query, Hit_Record3df &hit) const {
+    Ray_Query3df closest = query;
+    bool found = false;
+    for (size_t i = 0; i < planes.size(); i++) {
+        if (planes[i].intersects(closest)) {
+            hit.shape = Shape::PLANE;
+            hit.index = i;
+            found = true;
+        }
+    }
+    found |= closest_object(closest, hit);
+    found |= closest_triangle(closest, hit);
+    if (found) {
+        finalize(query.ray, closest.tmax, hit);
+    }
+    return found;
+}
+
+bool worldObjects::object_occludes(const Ray_Query3df &query) const {
+    return with_tree(object_bvh, spheres.size(), [&](const auto &tree) {
+        return tree.any_hit_leaves(query, [&](uint32_t first, uint32_t count) {
+            return sphere_arrays.any_hit(query.ray, first, count, query.tmin, query.tmax);
+        });
+    }, [&] {
+        for (const Sphere3df &sphere : spheres) {
+            Ray_Query3df candidate = query;
+            if (sphere.intersects(candidate)) {
+                return true;
+            }
+        }
+        return false;
+    });
+}
+
+bool worldObjects::triangle_occludes(const Ray_Query3df &query) const {
+    if (triangle_arrays.empty()) {
+        return false;
+    }
+    auto leaf = [&](uint32_t first, uint32_t count) {
+        return triangle_arrays.any_hit(query.ray, first, count, query.tmin, query.tmax);
+    };
+    return with_tree(triangle_bvh, triangle_arrays.size(), [&](const auto &tree) {
+        return tree.any_hit_leaves(query, leaf);
+    }, [&] {
+        return leaf(0, static_cast<uint32_t>(triangle_arrays.size()));
+    });
+}
+
+bool worldObjects::occluded(const Ray_Query3df &query) const {
+    for (const Plane3df &plane : planes) {
+        Ray_Query3df candidate = query;
+        if (plane.intersects(candidate)) {
+            return true;
+        }
+    }
+    return object_occludes(query) || triangle_occludes(query);
+}
+
+bool worldObjects::occluded(const Ray3df &r, float tmax) const {
+    return occluded(Ray_Query3df(r, 0.f, tmax));
+}
+
+bool worldObjects::prepare_packet(Ray_Packet &packet, Packet_Statistics *statistics) const {
+    packet.prepare();
+    // a single ray is traced faster on its own
+    int rays = __builtin_popcount(packet.active);
+    bool together = packet.coherent && rays > 1 && !object_bvh.binary.empty()
+                    && object_bvh.binary.primitive_count() == spheres.size();
+    if (statistics) {
+        if (together) {
+            statistics->packets++;
+        } else {
+            statistics->single_rays += static_cast<size_t>(rays);
+        }
+    }
+    return together;
+}
+
+unsigned worldObjects::closest_hit(Ray_Packet &packet, Hit_Record3df hits[], Packet_Statistics *statistics) const {
+    for (size_t i = 0; i < Ray_Packet::WIDTH; i++) {
+        packet.tmax[i] = std::numeric_limits<float>::max();
+    }
+    unsigned mask = 0;
+    if (!prepare_packet(packet, statistics)) {
+        for (unsigned rays = packet.active; rays != 0; rays &= rays - 1) {
+            unsigned i = static_cast<unsigned>(__builtin_ctz(rays));
+            if (closest_hit(packet.query(i), hits[i])) {
+                mask |= 1u << i;
+            }
+        }
+        return mask;
+    }
+
+    // the closest plane of each ray bounds its traversal, as for single rays
+    for (unsigned rays = packet.active; rays != 0; rays &= rays - 1) {
+        unsigned i = static_cast<unsigned>(__builtin_ctz(rays));
+        Ray_Query3df query = packet.query(i);
+        for (size_t p = 0; p < planes.size(); p++) {
+            if (planes[p].intersects(query)) {
+                hits[i].shape = Shape::PLANE;
+                hits[i].index = p;
+                mask |= 1u << i;
+            }
+        }
+        packet.tmax[i] = query.tmax;
+    }
+
+    size_t index[Ray_Packet::WIDTH];
+    unsigned hit = 0;
+    auto leaf = [&](uint32_t first, uint32_t count, Ray_Packet &rays, unsigned active) {
+        hit |= sphere_arrays.closest_hit(rays, first, count, active, index);
+        return 0u;
+    };
+    traverse_packet(object_bvh.binary, packet, [](void *context, uint32_t first, uint32_t count, Ray_Packet &rays, unsigned active) {
+        return (*static_cast<decltype(leaf) *>(context))(first, count, rays, active);
+    }, &leaf, statistics);
+    for (unsigned rays = hit; rays != 0; rays &= rays - 1) {
+        unsigned i = static_cast<unsigned>(__builtin_ctz(rays));
+        hits[i].shape = Shape::SPHERE;
+        hits[i].index = index[i];
+    }
+    mask |= hit;
+
+    // the triangles of each ray within the interval left by planes and spheres
+    for (unsigned rays = triangle_arrays.empty() ? 0u : packet.active; rays != 0; rays &= rays - 1) {
+        unsigned i = static_cast<unsigned>(__builtin_ctz(rays));
+        Ray_Query3df query = packet.query(i);
+        if (closest_triangle(query, hits[i])) {
+            packet.tmax[i] = query.tmax;
+            mask |= 1u << i;
+        }
+    }
+
+    for (unsigned rays = mask; rays != 0; rays &= rays - 1) {
+        unsigned i = static_cast<unsigned>(__builtin_ctz(rays));
+        finalize(packet.ray(i), packet.tmax[i], hits[i]);
+    }
+    return mask;
+}
+
+unsigned worldObjects::occluded(Ray_Packet &packet, Packet_Statistics *statistics) const {
+    unsigned active = packet.active,
+             mask = 0;
+    if (!prepare_packet(packet, statistics)) {
+        for (unsigned rays = active; rays != 0; rays &= rays - 1) {
+            unsigned i = static_cast<unsigned>(__builtin_ctz(rays));
+            if (occluded(packet.query(i))) {
+                mask |= 1u << i;
+            }
+        }
+        return mask;
+    }
+
+    // the occluded rays are finished and removed from the packet, the rays occluded by a plane before the traversal,
+    // the rays occluded by a triangle after it
+    for (unsigned rays = active; rays != 0; rays &= rays - 1) {
+        unsigned i = static_cast<unsigned>(__builtin_ctz(rays));
+        Ray_Query3df query = packet.query(i);
+        for (const Plane3df &plane : planes) {
+            Ray_Query3df candidate = query;
+            if (plane.intersects(candidate)) {
+                packet.active &= ~(1u << i);
+                break;
+            }
+        }
+    }
+    auto leaf = [&](uint32_t first, uint32_t count, Ray_Packet &rays, unsigned remaining) {
+        return sphere_arrays.any_hit(rays, first, count, remaining);
+    };
+    traverse_packet(object_bvh.binary, packet, [](void *context, uint32_t first, uint32_t count, Ray_Packet &rays, unsigned remaining) {
+        return (*static_cast<decltype(leaf) *>(context))(first, count, rays, remaining);
+    }, &leaf, statistics);
+    for (unsigned rays = triangle_arrays.empty() ? 0u : packet.active; rays != 0; rays &= rays - 1) {
+        unsigned i = static_cast<unsigned>(__builtin_ctz(rays));
+        if (triangle_occludes(packet.query(i))) {
+            packet.active &= ~(1u << i);
+        }
+    }
+    return active & ~packet.active;
+}
+
+Path_Statistics &Path_Statistics::operator+=(const Path_Statistics &statistics) {
+    bounces += statistics.bounces;
+    terminated_by_throughput += statistics.terminated_by_throughput;
+    terminated_by_roulette += statistics.terminated_by_roulette;
+    bounces_saved += statistics.bounces_saved;
+    return *this;
+}
+
+namespace {
+
+// returns a uniformly distributed random number in [0, 1) and advances state (xorshift32, state != 0)
+float random_float(uint32_t &state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return static_cast<float>(state >> 8) * (1.f / 16777216.f);
+}
+
+}
+
+uint32_t pixel_random_state(int i, int j) {
+    // the finalizer of murmur3
+    uint32_t state = static_cast<uint32_t>(j) * 0x9e3779b9u ^ static_cast<uint32_t>(i);
+    state ^= state >> 16;
+    state *= 0x85ebca6bu;
+    state ^= state >> 13;
+    state *= 0xc2b2ae35u;
+    state ^= state >> 16;
+    return state != 0 ? state : 1u;
+}
+
+bool continue_path(float &throughput, int depth, const Path_Termination &termination, uint32_t &random_state,
+                   Path_Statistics &path) {
+    if (throughput < termination.min_throughput) {
+        path.terminated_by_throughput++;
+        path.bounces_saved += depth;
+        return false;
+    }
+    if (throughput < termination.roulette_throughput) {
+        float survival = throughput / termination.roulette_throughput;
+        if (random_float(random_state) >= survival) {
+            path.terminated_by_roulette++;
+            path.bounces_saved += depth;
+            return false;
+        }
+        throughput /= survival;
+    }
+    return true;
+}
+
+namespace {
+
+// returns the ray starting at a hit point with the interval skipping SELF_HIT_DISTANCE
+Ray_Query3df secondary_ray(const Vector3df &origin, const Vector3df &direction, float tmax) {
+    return Ray_Query3df({origin, direction}, SELF_HIT_DISTANCE / direction.length(), tmax);
+}
+
+}
+
+Ray_Query3df shadow_ray(const worldObjects &world, const Intersection_Context<float, 3u> &rec) {
+    return secondary_ray(rec.intersection, world.lights[0].center - rec.intersection, 1.f);
+}
+
+float light_intensity(const Intersection_Context<float, 3u> &rec, const Ray3df &shadow, bool occluded) {
+    float intensety = 0.f;
+    if(occluded){
+        intensety = 0.3f;
+    } else {
+        Vector3df lambertarian = shadow.direction;
+        lambertarian.normalize();
+        intensety = rec.normal * lambertarian;
+    }
+    if ( intensety < 0.3f){
+        intensety = 0.3f;
+    }
+    return intensety;
+}
+
+Ray_Query3df reflected_ray(const Ray3df &ray, const Intersection_Context<float, 3u> &rec) {
+    Vector3df reflective_Vec = ray.direction - 2.f * (ray.direction * rec.normal) * rec.normal;
+    return secondary_ray(rec.intersection, reflective_Vec, std::numeric_limits<float>::max());
+}
+
+namespace {
+
+// the results of the first closest hit query of a path and of its shadow ray, e.g. traced in a packet
+struct First_Hit {
+    const Hit_Record3df *hit;  // nullptr if the ray hits nothing
+    bool occluded;
+};
+
+// follows the path of r like ray_color, the first closest hit and shadow ray are taken from first if it is given
+Vector3df trace_path(const Ray3df &r, const worldObjects &world, int depth, const Path_Termination &termination,
+                     uint32_t &random_state, Path_Statistics *statistics, const First_Hit *first) {
+    // reflections are followed in a loop, throughput is the product of the intensities of the reflective
+    // surfaces hit so far
+    Ray_Query3df ray(r);
+    float throughput = 1.f;
+    Path_Statistics path;
+
+    for (; depth > 0 && continue_path(throughput, depth, termination, random_state, path); depth--) {
+        Hit_Record3df hit;
+        path.bounces++;
+        if (first) {
+            if (!first->hit) {
+                break;
+            }
+            hit = *first->hit;
+        } else if (!world.closest_hit(ray, hit)) {
+            break;
+        }
+        const Intersection_Context<float, 3u> &rec = hit.context;
+
+        Ray_Query3df shaderRay = shadow_ray(world, rec);
+        float intensety = light_intensity(rec, shaderRay.ray, first ? first->occluded : world.occluded(shaderRay));
+        first = nullptr;
+        if(!world.reflective(hit)) {
+            if (statistics) {
+                *statistics += path;
+            }
+            return (throughput * intensety) * world.color(hit);
+        }
+        ray = reflected_ray(ray.ray, rec);
+        throughput *= intensety;
+    }
+    if (statistics) {
+        *statistics += path;
+    }
+    return Vector3df {0.f, 0.f, 0.f};
+}
+
+}
+
+Vector3df ray_color(const Ray3df &r, const worldObjects &world, int depth) {
+    uint32_t random_state = 1u;  // unused without russian roulette
+    return ray_color(r, world, depth, Path_Termination(), random_state);
+}
+
+Vector3df ray_color(const Ray3df &r, const worldObjects &world, int depth, const Path_Termination &termination,
+                    uint32_t &random_state, Path_Statistics *statistics) {
+    return trace_path(r, world, depth, termination, random_state, statistics, nullptr);
+}
+
+void render(const worldObjects &world, Framebuffer &framebuffer, const Render_Options &options, int depth,
+            const Path_Termination &termination, Path_Statistics *statistics) {
+    render(world, Camera(framebuffer.width(), framebuffer.height()), framebuffer, options, depth, termination, statistics);
+}
+
+void render(const worldObjects &world, const Camera &camera, Framebuffer &framebuffer, const Render_Options &options,
+            int depth, const Path_Termination &termination, Path_Statistics *statistics) {
+    assert(camera.width() == framebuffer.width() && camera.height() == framebuffer.height());
+    std::mutex statistics_mutex;
+    std::vector<Pixel_Offset> pixel_order;
+    if (options.pixel_order != Traversal_Order::SCANLINE) {
+        // no tile is larger than the image, so a tile size beyond it needs no larger order
+        pixel_order = make_pixel_order(std::min(options.tile_size, framebuffer.width()),
+                                       std::min(options.tile_size, framebuffer.height()), options.pixel_order);
+    }
+    render_tiles(framebuffer.width(), framebuffer.height(), options, [&](const Tile &tile) {
+        Path_Statistics tile_statistics;
+        auto trace = [&](int i, int j, const Vector3df &direction, const First_Hit *first) {
+            Ray3df r = {camera.eye(), direction};
+            uint32_t state = pixel_random_state(i, j);
+            framebuffer.set_pixel(i, j, trace_path(r, world, depth, termination, state, statistics ? &tile_statistics : nullptr, first));
+        };
+        if (options.wavefront) {
+            render_tile_wavefront(world, camera, tile, framebuffer, depth, termination, statistics ? &tile_statistics : nullptr);
+        } else if (pixel_order.empty() && options.packets) {
+            // the primary rays of up to 8 pixels of a row and then their shadow rays are traced as packets
+            Ray_Batch batch;
+            Ray_Packet primary, shadow;
+            Hit_Record3df hits[Ray_Packet::WIDTH];
+            for (int j = tile.y0; j < tile.y1; ++j) {
+                for (int i = tile.x0; i < tile.x1; i += static_cast<int>(Ray_Packet::WIDTH)) {
+                    size_t count = std::min(Ray_Packet::WIDTH, static_cast<size_t>(tile.x1 - i));
+                    camera.rays(i, j, count, batch);
+                    primary.active = 0;
+                    for (size_t lane = 0; lane < count; lane++) {
+                        primary.set(lane, {camera.eye(), {batch.direction[0][lane], batch.direction[1][lane], batch.direction[2][lane]}}, 0.f);
+                    }
+                    unsigned hit = world.closest_hit(primary, hits);
+                    shadow.active = 0;
+                    for (unsigned rays = hit; rays != 0; rays &= rays - 1) {
+                        unsigned lane = static_cast<unsigned>(__builtin_ctz(rays));
+                        shadow.set(lane, shadow_ray(world, hits[lane].context));
+                    }
+                    unsigned occluded = world.occluded(shadow);
+                    for (size_t lane = 0; lane < count; lane++) {
+                        First_Hit first = {(hit >> lane) & 1u ? &hits[lane] : nullptr, ((occluded >> lane) & 1u) != 0};
+                        trace(i + static_cast<int>(lane), j, primary.ray(lane).direction, &first);
+                    }
+                }
+            }
+        } else if (pixel_order.empty()) {
+            for (int j = tile.y0; j < tile.y1; ++j) {
+                Vector3df row_start = camera.row_start(j);
+                for (int i = tile.x0; i < tile.x1; ++i) {
+                    trace(i, j, row_start + (float) i * camera.pixel_delta_u(), nullptr);
+                }
+            }
+        } else {
+            for (Pixel_Offset offset : pixel_order) {
+                int i = tile.x0 + offset.x,
+                    j = tile.y0 + offset.y;
+                if (i < tile.x1 && j < tile.y1) {
+                    trace(i, j, camera.direction(i, j), nullptr);
+                }
+            }
+        }
+        if (statistics) {
+            std::lock_guard<std::mutex> lock(statistics_mutex);
+            *statistics += tile_statistics;
+        }
+    });
+}
+
+worldObjects cornell_box() {
+    //rot
+    worldObjects world(wObject(Sphere3df({3.f, -8.f, -13.f}, 2.f), Vector3df({1.f, 0.f, 0.f}), false));
+    //Lila
+    world.add(wObject(Sphere3df({-9.f, -8.f, -17.f}, 3.f), Vector3df({0.5f, 0.f, 0.5f}), true));
+
+    //RechteWand
+    world.add(wPlane(Plane3df({1.f, 0.f, 0.f}, 21.f), Vector3df({0.f, 1.f, 0.f}), false));
+    //Linkewand
+    world.add(wPlane(Plane3df({1.f, 0.f, 0.f}, -21.f), Vector3df({1.f, 1.f, 0.f}), false));
+    //Boden
+    world.add(wPlane(Plane3df({0.f, 1.f, 0.f}, -12.f), Vector3df({0.f, 0.f, 1.f}), false));
+    //Decke
+    world.add(wPlane(Plane3df({0.f, 1.f, 0.f}, 12.f), Vector3df({0.5f, 0.5f, 1.f}), false));
+    //Rückwand
+    world.add(wPlane(Plane3df({0.f, 0.f, 1.f}, -30.f), Vector3df({0.3f, 1.f, 1.f}), false));
+    //Off wand
+    world.add(wPlane(Plane3df({0.f, 0.f, 1.f}, 30.f), Vector3df({.9f, .2f, 0.f}), false));
+    //world.add(wObject(Sphere3df({-10.f, 12.f, -18.f}, 1.f), Vector3df({0.f, 1.f, 1.f}), false));
+
+    world.lights.push_back(light(Vector3df {0.f, 11.f, -18.f}));
+    world.build();
+    return world;
+}
+
+namespace {
+
+// the spheres of sphere_field followed by triangles of the same sizes, drawn from the same random numbers
+worldObjects primitive_field(size_t sphere_count, size_t triangle_count, unsigned seed, float reflective_fraction) {
+    // the primitives fill a box in front of the camera, their size shrinks with their number,
+    // so that the fraction of the box they fill stays the same
+    const float width = 40.f, height = 24.f, depth = 60.f;
+    float spacing = std::cbrt(width * height * depth / static_cast<float>(sphere_count + triangle_count));
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<float> x(-width / 2, width / 2), y(-height / 2, height / 2), z(-15.f - depth, -15.f),
+                                          radius(0.1f * spacing, 0.4f * spacing), channel(0.2f, 1.f), unit(0.f, 1.f),
+                                          offset(-2.f, 2.f);
+    worldObjects world;
+    world.spheres.reserve(sphere_count);
+    world.sphere_materials.reserve(sphere_count);
+    for (size_t i = 0; i < sphere_count; i++) {
+        Sphere3df sphere({x(generator), y(generator), z(generator)}, radius(generator));
+        Vector3df color = {channel(generator), channel(generator), channel(generator)};
+        world.add(wObject(sphere, color, unit(generator) < reflective_fraction));
+    }
+    world.triangles.reserve(triangle_count);
+    world.triangle_materials.reserve(triangle_count);
+    for (size_t i = 0; i < triangle_count; i++) {
+        Vector3df center = {x(generator), y(generator), z(generator)};
+        float r = radius(generator);
+        Vector3df a = center + r * Vector3df{offset(generator), offset(generator), offset(generator)},
+                  b = center + r * Vector3df{offset(generator), offset(generator), offset(generator)},
+                  c = center + r * Vector3df{offset(generator), offset(generator), offset(generator)};
+        Vector3df color = {channel(generator), channel(generator), channel(generator)};
+        world.add(wTriangle(Triangle3df(a, b, c), color, unit(generator) < reflective_fraction));
+    }
+    //Boden
+    world.add(wPlane(Plane3df({0.f, 1.f, 0.f}, -height / 2), Vector3df({0.8f, 0.8f, 0.8f}), false));
+
+    world.lights.push_back(light(Vector3df {0.f, height, -15.f}));
+    world.build();
+    return world;
+}
+
+}
+
+worldObjects sphere_field(size_t count, unsigned seed, float reflective_fraction) {
+    return primitive_field(count, 0, seed, reflective_fraction);
+}
+
+worldObjects triangle_field(size_t count, unsigned seed, float reflective_fraction) {
+    return primitive_field(0, count, seed, reflective_fraction);
+}
+
+worldObjects mixed_field(size_t count, unsigned seed, float reflective_fraction) {
+    return primitive_field(count / 2, count - count / 2, seed, reflective_fraction);
+}
@@ -0,0 +1,289 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include "math.h"
+#include "geometry.h"
+#include "bvh.h"
+#include "wide_bvh.h"
+#include "sphere_soa.h"
+#include "triangle_soa.h"
+#include "ray_packet.h"
+#include "renderer.h"
+#include "framebuffer.h"
+#include "camera.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// contains the scene description (objects with their surface, light sources) and the
+// ray casting functions working on a scene
+
+
+// a point light source
+class light {
+public:
+    Vector3df center;
+    Vector3df color = {0.f, 0.f, 0.f};
+
+    light(const Vector3df &center)
+    : center(center){}
+};
+
+// the surface of a primitive, only read for the closest hit of a ray
+// reflective surfaces take their color from the reflected ray
+struct Material {
+    Vector3df  color;
+    bool reflective;
+};
+
+// a sphere together with the color of its surface, the input of worldObjects::add
+class wObject {
+public:
+    Sphere3df  sphere;
+    Vector3df  color;
+    bool reflective;
+
+    wObject(): sphere({0.f, 0.f, 0.f}, 0.f), color({0.f, 0.f, 0.f}), reflective(false) {}
+    wObject(const Sphere3df &s, const Vector3df &c, const bool &r )
+    : sphere(s), color(c), reflective(r) {}
+};
+
+// a triangle together with the color of its surface (both sides)
+class wTriangle {
+public:
+    Triangle3df triangle;
+    Vector3df  color;
+    bool reflective;
+
+    wTriangle(const Triangle3df &t, const Vector3df &c, const bool &r)
+    : triangle(t), color(c), reflective(r) {}
+};
+
+// an infinite plane together with the color of its surface, e.g. a wall
+class wPlane {
+public:
+    Plane3df   plane;
+    Vector3df  color;
+    bool reflective;
+
+    wPlane(const Plane3df &p, const Vector3df &c, const bool &r)
+    : plane(p), color(c), reflective(r) {}
+};
+
+// the kind of surface hit by a ray
+enum class Shape {
+    SPHERE,    // a sphere of worldObjects::spheres
+    TRIANGLE,  // a triangle of worldObjects::triangles
+    PLANE      // a plane of worldObjects::planes
+};
+
+// the result of a closest hit query
+template <class FLOAT, size_t N>
+struct Hit_Record {
+    Shape shape;
+    size_t index;  // index of the hit surface in worldObjects::spheres, triangles or planes, depending on shape
+    Intersection_Context<FLOAT, N> context;  // context.t, intersection point and normal of the hit
+};
+
+typedef Hit_Record<float, 3u> Hit_Record3df;
+
+// the bvh layout traversed by worldObjects
+// AUTOMATIC chooses the widest layout the cpu's SIMD instruction set supports
+enum class BVH_Layout {
+    BINARY,
+    WIDE_4,
+    WIDE_8,
+    AUTOMATIC
+};
+
+// the bvh over the primitives of one type, only the tree of the layout chosen by worldObjects::build is built
+struct Scene_BVH {
+    Linear_BVH3df binary;
+    BVH4 wide4;
+    BVH8 wide8;
+
+    // builds the tree of the given layout (not AUTOMATIC) from tree, the others become empty
+    void build(const BVH3df &tree, BVH_Layout layout);
+
+    void clear();
+};
+
+class worldObjects {
+public:
+    // the geometry of the surfaces in one array per type, so that every query intersects primitives of one type at a
+    // time and the intersection loops read nothing but geometry
+    std::vector<Sphere3df> spheres;
+    std::vector<Triangle3df> triangles;
+    std::vector<Plane3df> planes;        // unbounded, so they are tested by every query instead of being part of a bvh
+    // the materials of the surfaces, apart from their geometry in the same order, only read for the closest hit
+    std::vector<Material> sphere_materials,
+                          triangle_materials,
+                          plane_materials;
+    std::vector<light> lights;
+    worldObjects() = default;
+    worldObjects(wObject object) { add(object); }
+
+    // adds an object, the bvh has to be rebuilt afterwards
+    void add(wObject object);
+
+    // adds a triangle, the bvh has to be rebuilt afterwards
+    // (triangles appended to the vectors directly are only intersected after the next build)
+    void add(wTriangle triangle);
+
+    // adds a plane, the bvh stays valid
+    void add(wPlane plane);
+
+    // returns the number of spheres, triangles and planes
+    size_t primitive_count() const { return spheres.size() + triangles.size() + planes.size(); }
+
+    // returns the material of the surface hit
+    const Material &material(const Hit_Record3df &hit) const;
+
+    // returns the color of the surface hit
+    const Vector3df &color(const Hit_Record3df &hit) const { return material(hit).color; }
+
+    // returns true iff the surface hit is reflective
+    bool reflective(const Hit_Record3df &hit) const { return material(hit).reflective; }
+
+    // builds one bvh over the spheres and one over the triangles, queries without an up to date bvh test every
+    // primitive of its type
+    // spheres and triangles are reordered (with their materials) to the leaf order of their bvh, so previous indices
+    // become invalid
+    // a layout the cpu does not support is replaced by the next narrower one
+    void build(const BVH_Build_Options &options = {}, BVH_Layout layout = BVH_Layout::AUTOMATIC);
+
+    // returns build time, size and sah cost of the (binary) bvhs, summed over both, depth is the larger one
+    const BVH_Build_Statistics &bvh_statistics() const { return statistics; }
+
+    // returns the layout of the current bvhs, never AUTOMATIC
+    BVH_Layout bvh_layout() const { return layout; }
+
+    // finds the surface closest to the ray origin which is hit by the ray of the query at
+    // query.tmin < t < query.tmax (a ray converts to the query with tmin = 0 and no upper bound)
+    // the planes are tested first, then the spheres and the triangles, each closer hit bounds the following traversals
+    // returns false if nothing is hit, otherwise hit holds the shape and index of the surface and the intersection,
+    // its material is found by material(hit)
+    // neither allocates memory nor copies any primitive
+    bool closest_hit(const Ray_Query3df &query, Hit_Record3df &hit) const;
+
+    // returns true iff some surface is hit by the ray of the query at query.tmin < t < query.tmax,
+    // e.g. for shadow rays
+    // stops at the first such surface and computes neither intersection point nor normal
+    bool occluded(const Ray_Query3df &query) const;
+
+    // the same for the given ray at 0 < t < tmax
+    bool occluded(const Ray3df &r, float tmax) const;
+
+    // the same for the active rays of a packet: sets hits[i] for every ray i which hits a surface and returns the
+    // mask of these rays, every ray gets the same hit as closest_hit(Ray_Query3df(packet.ray(i), packet.tmin[i]), hits[i]),
+    // packet.tmax is overwritten
+    // coherent packets are traced together through the binary bvh of the spheres (BVH_Layout::BINARY), the rays of
+    // other packets, the rays of all packets with other layouts and the triangles are traced one by one
+    unsigned closest_hit(Ray_Packet &packet, Hit_Record3df hits[], Packet_Statistics *statistics = nullptr) const;
+
+    // returns the mask of the active rays of the packet which hit some surface at packet.tmin[i] < t < packet.tmax[i]
+    unsigned occluded(Ray_Packet &packet, Packet_Statistics *statistics = nullptr) const;
+
+private:
+    // prepares the packet and returns true if it is traced through the bvh together
+    bool prepare_packet(Ray_Packet &packet, Packet_Statistics *statistics) const;
+
+    // find the closest sphere (triangle) like closest_hit, but only lower query.tmax to its t and set hit.shape
+    // and hit.index if it is closer than query.tmax
+    bool closest_object(Ray_Query3df &query, Hit_Record3df &hit) const;
+    bool closest_triangle(Ray_Query3df &query, Hit_Record3df &hit) const;
+
+    // return true iff a sphere (triangle) is hit within the interval of the query
+    bool object_occludes(const Ray_Query3df &query) const;
+    bool triangle_occludes(const Ray_Query3df &query) const;
+
+    // sets hit.context for the hit of the surface given by hit.shape and hit.index at t
+    void finalize(const Ray3df &ray, float t, Hit_Record3df &hit) const;
+
+    BVH_Layout layout = BVH_Layout::BINARY;
+    Scene_BVH object_bvh,
+              triangle_bvh;
+    SphereSoA sphere_arrays;      // the spheres in the same order, intersected a leaf at a time
+    TriangleSoA triangle_arrays;  // the same for the triangles, also used without an up to date bvh
+    BVH_Build_Statistics statistics;
+};
+
+// decides when ray_color stops following reflections before depth bounces are reached
+// the throughput of a path is the product of the intensities of the reflective surfaces hit so far,
+//   i.e. the factor by which everything seen after the next reflection is scaled
+// a threshold of 0 disables the corresponding termination
+struct Path_Termination {
+    float min_throughput = 0.f;       // paths with a smaller throughput are cut off (and become black)
+    float roulette_throughput = 0.f;  // paths with a smaller throughput survive with probability throughput / roulette_throughput
+                                      //   and are weighted by the inverse of that probability (russian roulette, unbiased)
+};
+
+// counts the bounces of the paths traced by ray_color and the paths terminated before depth was reached
+struct Path_Statistics {
+    size_t bounces = 0,                    // closest hit queries of the paths (without shadow rays)
+           terminated_by_throughput = 0,
+           terminated_by_roulette = 0,
+           bounces_saved = 0;              // bounces the terminated paths had left until depth was reached
+
+    Path_Statistics &operator+=(const Path_Statistics &statistics);
+};
+
+// the steps of following a path, shared by ray_color and the stages of the wavefront renderer (wavefront.h)
+
+// returns the random state of russian roulette for the path through pixel (i, j), never 0
+uint32_t pixel_random_state(int i, int j);
+
+// returns false if termination cuts off a path with the given throughput and depth bounces left, which is counted
+// in path then, the throughput of a path surviving russian roulette is divided by its probability to survive
+bool continue_path(float &throughput, int depth, const Path_Termination &termination, uint32_t &random_state,
+                   Path_Statistics &path);
+
+// the secondary rays start at the hit point, their tmin skips the first SELF_HIT_DISTANCE along the ray, so that
+// they do not hit the surface they start on because of rounding errors
+const float SELF_HIT_DISTANCE = 0.01f;
+
+// returns the ray from a hit point to the first light with tmax = 1, the light lies at t = 1
+Ray_Query3df shadow_ray(const worldObjects &world, const Intersection_Context<float, 3u> &rec);
+
+// returns the intensity of the light at a hit point with the given shadow ray (lambert), at least 0.3 (ambient)
+float light_intensity(const Intersection_Context<float, 3u> &rec, const Ray3df &shadow, bool occluded);
+
+// returns the reflection of ray at a hit point
+Ray_Query3df reflected_ray(const Ray3df &ray, const Intersection_Context<float, 3u> &rec);
+
+// returns the color seen along the given ray, reflective surfaces are followed up to depth bounces
+// the bounces are followed in a loop, so any depth runs in constant stack space
+Vector3df ray_color(const Ray3df &r, const worldObjects &world, int depth);
+
+// the same, but paths are terminated early according to termination
+// random_state is the state of the random numbers of russian roulette, it must not be 0 and is advanced
+// the bounces and terminations are added to statistics if it is given
+Vector3df ray_color(const Ray3df &r, const worldObjects &world, int depth, const Path_Termination &termination,
+                    uint32_t &random_state, Path_Statistics *statistics = nullptr);
+
+// renders the world into the framebuffer as seen by the camera, which must have the size of the framebuffer
+// the tiles of the image are distributed over the threads of options, reflective surfaces are followed up to
+// depth bounces
+// the random numbers of russian roulette only depend on the pixel, so the image does not depend on the threads
+// the bounces and terminations of the frame are added to statistics if it is given
+void render(const worldObjects &world, const Camera &camera, Framebuffer &framebuffer, const Render_Options &options,
+            int depth, const Path_Termination &termination = {}, Path_Statistics *statistics = nullptr);
+
+// the same with the default camera (at the origin looking along -z)
+void render(const worldObjects &world, Framebuffer &framebuffer, const Render_Options &options, int depth,
+            const Path_Termination &termination = {}, Path_Statistics *statistics = nullptr);
+
+// the cornell box (six planes) with a red and a reflective purple sphere, lit by one point light
+worldObjects cornell_box();
+
+// count random spheres above a floor (a plane) in front of the camera, lit by one point light
+// the given fraction of the spheres is reflective, the same seed gives the same scene
+worldObjects sphere_field(size_t count, unsigned seed = 42, float reflective_fraction = 0.1f);
+
+// the same with count random triangles (a triangle soup) of the size of the spheres
+worldObjects triangle_field(size_t count, unsigned seed = 42, float reflective_fraction = 0.1f);
+
+// the same with count / 2 spheres and the remaining primitives triangles
+worldObjects mixed_field(size_t count, unsigned seed = 42, float reflective_fraction = 0.1f);
+
+#endif
@@ -0,0 +1,340 @@
+#include "scene.h"
+#include "benchmark/benchmark.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// counts every call of the global allocation functions of this executable
+static std::atomic<size_t> allocation_count{0};
+
+void * operator new(std::size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  if (void * memory = std::malloc(size == 0 ? 1 : size)) {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+void * operator new[](std::size_t size) {
+  return ::operator new(size);
+}
+
+// the over-aligned versions, used e.g. by Aligned_Allocator (aligned_alloc needs a multiple of the alignment as size)
+void * operator new(std::size_t size, std::align_val_t alignment) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  std::size_t bytes = static_cast<std::size_t>(alignment),
+              rounded = ((size == 0 ? 1 : size) + bytes - 1) / bytes * bytes;
+  if (void * memory = std::aligned_alloc(bytes, rounded)) {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+void * operator new[](std::size_t size, std::align_val_t alignment) {
+  return ::operator new(size, alignment);
+}
+
+// the operator new versions above allocate with malloc and aligned_alloc, which gcc does not see when it inlines a
+// delete expression
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+void operator delete(void * memory) noexcept {
+  std::free(memory);
+}
+
+void operator delete[](void * memory) noexcept {
+  std::free(memory);
+}
+
+void operator delete(void * memory, std::size_t) noexcept {
+  std::free(memory);
+}
+
+void operator delete[](void * memory, std::size_t) noexcept {
+  std::free(memory);
+}
+
+void operator delete(void * memory, std::align_val_t) noexcept {
+  std::free(memory);
+}
+
+void operator delete[](void * memory, std::align_val_t) noexcept {
+  std::free(memory);
+}
+
+void operator delete(void * memory, std::size_t, std::align_val_t) noexcept {
+  std::free(memory);
+}
+
+void operator delete[](void * memory, std::size_t, std::align_val_t) noexcept {
+  std::free(memory);
+}
+
+namespace {
+
+// renders a width x height frame of the cornell box through ray_color and
+// reports the number of allocator calls per frame
+void BM_CornellBoxFrame(benchmark::State & state) {
+  const int width = static_cast<int>(state.range(0)),
+            height = width * 9 / 16;
+  worldObjects world = cornell_box();
+  size_t allocations = 0;
+
+  for (auto _ : state) {
+    size_t before = allocation_count.load(std::memory_order_relaxed);
+    for (int j = 0; j < height; ++j) {
+      for (int i = 0; i < width; ++i) {
+        Vector3df direction = {16.f * (i + 0.5f) / width - 8.f, 4.5f - 9.f * (j + 0.5f) / height, -5.f};
+        Ray3df ray = {{0.f, 0.f, 0.f}, direction};
+        benchmark::DoNotOptimize(ray_color(ray, world, 5));
+      }
+    }
+    allocations += allocation_count.load(std::memory_order_relaxed) - before;
+  }
+  state.counters["allocations_per_frame"] = benchmark::Counter(static_cast<double>(allocations) / state.iterations());
+  state.counters["primary_rays"] = benchmark::Counter(static_cast<double>(width) * height * state.iterations(), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_CornellBoxFrame)->Arg(160)->Arg(640)->Unit(benchmark::kMillisecond);
+
+// a single closest hit query, the path taken by every primary and shadow ray
+void BM_ClosestHit(benchmark::State & state) {
+  worldObjects world = cornell_box();
+  Ray3df ray = {{0.f, 0.f, 0.f}, {0.2f, -0.5f, -1.f}};
+  Hit_Record3df hit;
+  size_t before = allocation_count.load(std::memory_order_relaxed);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(world.closest_hit(ray, hit));
+  }
+  state.counters["allocations_per_query"] = benchmark::Counter(
+      static_cast<double>(allocation_count.load(std::memory_order_relaxed) - before) / state.iterations());
+}
+BENCHMARK(BM_ClosestHit);
+
+// shadow rays from the visible surface points to the light, answered by a closest hit query (range(0) == 0)
+// or by the occlusion query (range(0) == 1)
+void BM_ShadowRays(benchmark::State & state) {
+  worldObjects world = cornell_box();
+  std::vector<Ray3df> rays;
+  for (int j = 0; j < 18; ++j) {
+    for (int i = 0; i < 32; ++i) {
+      Ray3df ray = {{0.f, 0.f, 0.f}, {16.f * (i + 0.5f) / 32 - 8.f, 4.5f - 9.f * (j + 0.5f) / 18, -5.f}};
+      Hit_Record3df hit;
+      if (world.closest_hit(ray, hit)) {
+        Vector3df origin = hit.context.intersection + 0.01f * hit.context.normal;
+        rays.push_back(Ray3df{origin, world.lights[0].center - origin});
+      }
+    }
+  }
+
+  size_t r = 0,
+         blocked = 0;
+  for (auto _ : state) {
+    const Ray3df & ray = rays[r++ % rays.size()];
+    if (state.range(0) == 0) {
+      Hit_Record3df hit;
+      blocked += world.closest_hit(ray, hit) && hit.context.t < 1.f;
+    } else {
+      blocked += world.occluded(ray, 1.f);
+    }
+  }
+  benchmark::DoNotOptimize(blocked);
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ShadowRays)->Arg(0)->Arg(1);
+
+// a frame of 1000 spheres, 90 percent of them mirrors, with up to 16 bounces and no path termination (range(0) == 0),
+// paths cut off below a throughput of 1/256 (range(0) == 1) or russian roulette below 1/16 (range(0) == 2)
+void BM_PathTermination(benchmark::State & state) {
+  worldObjects world = sphere_field(1000, 42, 0.9f);
+  Framebuffer framebuffer(160, 90);
+  Render_Options options;
+  options.threads = 1;
+  Path_Termination termination;
+  if (state.range(0) == 1) {
+    termination.min_throughput = 1.f / 256.f;
+  } else if (state.range(0) == 2) {
+    termination.roulette_throughput = 1.f / 16.f;
+  }
+  Path_Statistics statistics;
+
+  for (auto _ : state) {
+    render(world, framebuffer, options, 16, termination, &statistics);
+  }
+  double frames = static_cast<double>(state.iterations());
+  state.counters["bounces_per_frame"] = benchmark::Counter(statistics.bounces / frames);
+  state.counters["bounces_saved_per_frame"] = benchmark::Counter(statistics.bounces_saved / frames);
+}
+BENCHMARK(BM_PathTermination)->Arg(0)->Arg(1)->Arg(2)->Unit(benchmark::kMillisecond);
+
+// counts the hardware cache misses of the calling thread, if the kernel and the cpu allow it
+class Cache_Miss_Counter {
+public:
+  Cache_Miss_Counter() {
+#if defined(__linux__)
+    perf_event_attr attributes = {};
+    attributes.size = sizeof(attributes);
+    attributes.type = PERF_TYPE_HARDWARE;
+    attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+    attributes.disabled = 1;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    descriptor = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+#endif
+  }
+
+  ~Cache_Miss_Counter() {
+#if defined(__linux__)
+    if (descriptor >= 0) {
+      close(descriptor);
+    }
+#endif
+  }
+
+  bool available() const { return descriptor >= 0; }
+
+  void start() {
+#if defined(__linux__)
+    if (available()) {
+      ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+  }
+
+  void stop() {
+#if defined(__linux__)
+    if (available()) {
+      ioctl(descriptor, PERF_EVENT_IOC_DISABLE, 0);
+    }
+#endif
+  }
+
+  // returns the misses counted between all start() and stop() calls so far
+  uint64_t misses() const {
+    uint64_t count = 0;
+#if defined(__linux__)
+    if (available() && read(descriptor, &count, sizeof(count)) != sizeof(count)) {
+      count = 0;
+    }
+#endif
+    return count;
+  }
+
+private:
+  int descriptor = -1;
+};
+
+// a 640 x 360 frame of 100000 spheres on one thread with tiles and pixels in scanline (range(0) == 0), morton (1)
+// or hilbert (2) order and tiles of range(1) x range(1) pixels (640: the whole width, like the loop over rows
+// before the tiles), cache_misses_per_ray is only reported where hardware counters can be read
+void BM_TraversalOrder(benchmark::State & state) {
+  static worldObjects world = sphere_field(100000);
+  Framebuffer framebuffer(640, 360);
+  Render_Options options;
+  options.threads = 1;
+  options.tile_order = options.pixel_order = static_cast<Traversal_Order>(state.range(0));
+  options.tile_size = static_cast<int>(state.range(1));
+  Cache_Miss_Counter counter;
+
+  for (auto _ : state) {
+    counter.start();
+    render(world, framebuffer, options, 5);
+    counter.stop();
+  }
+  double rays = static_cast<double>(framebuffer.width()) * framebuffer.height() * state.iterations();
+  state.counters["primary_rays"] = benchmark::Counter(rays, benchmark::Counter::kIsRate);
+  if (counter.available()) {
+    state.counters["cache_misses_per_ray"] = benchmark::Counter(static_cast<double>(counter.misses()) / rays);
+  }
+}
+BENCHMARK(BM_TraversalOrder)->ArgsProduct({{0, 1, 2}, {32, 640}})->Unit(benchmark::kMillisecond);
+
+// the closest hits of the primary rays of a 320 x 180 image of range(1) spheres, traced as single rays through the
+// bvh8 (range(0) == 0) or the binary bvh (1), or as packets of the rays of 8 pixels of a row through the binary bvh (2)
+void BM_PrimaryVisibility(benchmark::State & state) {
+  worldObjects world = sphere_field(static_cast<size_t>(state.range(1)));
+  world.build({}, state.range(0) == 0 ? BVH_Layout::WIDE_8 : BVH_Layout::BINARY);
+  Camera camera(320, 180);
+  Hit_Record3df hits[Ray_Packet::WIDTH];
+  Packet_Statistics statistics;
+  size_t hit_count = 0;
+
+  for (auto _ : state) {
+    for (int j = 0; j < camera.height(); ++j) {
+      for (int i = 0; i < camera.width(); i += static_cast<int>(Ray_Packet::WIDTH)) {
+        if (state.range(0) == 2) {
+          Ray_Packet packet;
+          for (size_t lane = 0; lane < Ray_Packet::WIDTH; lane++) {
+            packet.set(lane, camera.ray(i + static_cast<int>(lane), j), 0.f);
+          }
+          hit_count += static_cast<size_t>(__builtin_popcount(world.closest_hit(packet, hits, &statistics)));
+        } else {
+          for (size_t lane = 0; lane < Ray_Packet::WIDTH; lane++) {
+            hit_count += world.closest_hit(camera.ray(i + static_cast<int>(lane), j), hits[lane]);
+          }
+        }
+      }
+    }
+  }
+  benchmark::DoNotOptimize(hit_count);
+  state.SetItemsProcessed(state.iterations() * camera.width() * camera.height());
+  if (state.range(0) == 2) {
+    double packets = static_cast<double>(statistics.packets);
+    state.counters["nodes_per_packet"] = benchmark::Counter(statistics.nodes_visited / packets);
+    state.counters["culled_per_packet"] = benchmark::Counter(statistics.nodes_culled / packets);
+    state.counters["single_rays"] = benchmark::Counter(static_cast<double>(statistics.single_rays));
+  }
+}
+BENCHMARK(BM_PrimaryVisibility)->ArgsProduct({{0, 1, 2}, {1000, 100000}});
+
+// a 320 x 180 frame of 1000 spheres, half of them mirrors, with up to 8 bounces on one thread, the paths followed
+// one after the other (range(0) == 0), the primary and shadow rays traced as packets (1) or all paths of a tile
+// followed bounce by bounce in the wavefront stages (2), always with the binary bvh the packets need
+void BM_Wavefront(benchmark::State & state) {
+  worldObjects world = sphere_field(1000, 42, 0.5f);
+  world.build({}, BVH_Layout::BINARY);
+  Framebuffer framebuffer(320, 180);
+  Render_Options options;
+  options.threads = 1;
+  options.tile_size = 64;
+  options.packets = state.range(0) == 1;
+  options.wavefront = state.range(0) == 2;
+  Path_Statistics statistics;
+
+  for (auto _ : state) {
+    render(world, framebuffer, options, 8, {}, &statistics);
+  }
+  state.counters["bounces"] = benchmark::Counter(static_cast<double>(statistics.bounces), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_Wavefront)->Arg(0)->Arg(1)->Arg(2)->Unit(benchmark::kMillisecond);
+
+// the closest hits of the primary rays of a 320 x 180 image of range(1) spheres (range(0) == 0), triangles (1) or
+// half spheres and half triangles (2) through the bvh8, items are rays, the mixed scene should lie between the others
+void BM_MixedPrimitives(benchmark::State & state) {
+  size_t count = static_cast<size_t>(state.range(1));
+  worldObjects world = state.range(0) == 0 ? sphere_field(count) : state.range(0) == 1 ? triangle_field(count) : mixed_field(count);
+  Camera camera(320, 180);
+  Hit_Record3df hit;
+  size_t hit_count = 0;
+
+  for (auto _ : state) {
+    for (int j = 0; j < camera.height(); ++j) {
+      for (int i = 0; i < camera.width(); ++i) {
+        hit_count += world.closest_hit(camera.ray(i, j), hit);
+      }
+    }
+  }
+  benchmark::DoNotOptimize(hit_count);
+  state.SetItemsProcessed(state.iterations() * camera.width() * camera.height());
+}
+BENCHMARK(BM_MixedPrimitives)->ArgsProduct({{0, 1, 2}, {1000, 100000}})->Unit(benchmark::kMillisecond);
+
+}
@@ -0,0 +1,176 @@
+#include "scene.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// renders every combination of scene, image width, thread count and recursion depth through render()
+// and ray_color, the same path as raytracer, and prints one JSON object with a record per render:
+//   {"runs": [{"scene": "cornell", "primitives": 8, "width": 640, "height": 360, "threads": 1, "depth": 5,
+//              "scene_seconds": ..., "build_seconds": ..., "render_seconds": ..., "primary_rays": ...,
+//              "primary_mrays_per_second": ..., "peak_rss_kb": ...}, ...]}
+// every render runs in a child process of its own, so that peak_rss_kb is the peak of that render alone
+//
+// options (lists are comma separated):
+//   --scenes cornell,spheres_<count>,triangles_<count>,mixed_<count>,...
+//                                         (default cornell,spheres_1000,spheres_100000,triangles_100000,mixed_100000)
+//   --widths <pixels>,...                 (default 320,640, the height is width * 9 / 16)
+//   --threads <count>,...                 (default 1,0, 0 = all cores)
+//   --depths <bounces>,...                (default 1,5)
+//   -o/--output <file>                    (default standard output)
+
+namespace {
+
+struct Sweep_Options {
+  std::vector<std::string> scenes = {"cornell", "spheres_1000", "spheres_100000", "triangles_100000", "mixed_100000"};
+  std::vector<int> widths = {320, 640},
+                   threads = {1, 0},
+                   depths = {1, 5};
+  std::string output = "-";
+};
+
+std::vector<std::string> split(const char * list) {
+  std::vector<std::string> items;
+  std::string item;
+  for (const char * c = list; ; c++) {
+    if (*c == ',' || *c == '\0') {
+      if (!item.empty()) {
+        items.push_back(item);
+      }
+      item.clear();
+      if (*c == '\0') {
+        return items;
+      }
+    } else {
+      item += *c;
+    }
+  }
+}
+
+std::vector<int> split_numbers(const char * list) {
+  std::vector<int> numbers;
+  for (const std::string & item : split(list)) {
+    numbers.push_back(std::atoi(item.c_str()));
+  }
+  return numbers;
+}
+
+Sweep_Options parse_options(int argc, char * argv[]) {
+  Sweep_Options options;
+  for (int i = 1; i < argc; i += 2) {
+    if (i + 1 == argc) {
+      std::fprintf(stderr, "missing value for option %s\n", argv[i]);
+      std::exit(EXIT_FAILURE);
+    }
+    if (std::strcmp(argv[i], "--scenes") == 0) {
+      options.scenes = split(argv[i + 1]);
+    } else if (std::strcmp(argv[i], "--widths") == 0) {
+      options.widths = split_numbers(argv[i + 1]);
+    } else if (std::strcmp(argv[i], "--threads") == 0) {
+      options.threads = split_numbers(argv[i + 1]);
+    } else if (std::strcmp(argv[i], "--depths") == 0) {
+      options.depths = split_numbers(argv[i + 1]);
+    } else if (std::strcmp(argv[i], "-o") == 0 || std::strcmp(argv[i], "--output") == 0) {
+      options.output = argv[i + 1];
+    } else {
+      std::fprintf(stderr, "unknown option %s %s\n", argv[i], argv[i + 1]);
+      std::exit(EXIT_FAILURE);
+    }
+  }
+  return options;
+}
+
+// returns false if the name is not one of cornell, spheres_<count>, triangles_<count>, mixed_<count>
+bool make_scene(const std::string & name, worldObjects & world) {
+  if (name == "cornell") {
+    world = cornell_box();
+    return true;
+  }
+  if (name.rfind("spheres_", 0) == 0) {
+    world = sphere_field(std::strtoull(name.c_str() + 8, nullptr, 10));
+    return true;
+  }
+  if (name.rfind("triangles_", 0) == 0) {
+    world = triangle_field(std::strtoull(name.c_str() + 10, nullptr, 10));
+    return true;
+  }
+  if (name.rfind("mixed_", 0) == 0) {
+    world = mixed_field(std::strtoull(name.c_str() + 6, nullptr, 10));
+    return true;
+  }
+  return false;
+}
+
+// renders one configuration and writes its JSON record to out, returns false for unknown scenes
+bool run(const std::string & scene, int width, int threads, int depth, FILE * out) {
+  typedef std::chrono::steady_clock Clock;
+  Clock::time_point start = Clock::now();
+  worldObjects world;
+  if (!make_scene(scene, world)) {
+    return false;
+  }
+  double scene_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+  Render_Options options;
+  options.threads = static_cast<unsigned>(threads);
+  Framebuffer framebuffer(width, width * 9 / 16);
+  start = Clock::now();
+  render(world, framebuffer, options, depth);
+  double render_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  double primary_rays = static_cast<double>(framebuffer.width()) * framebuffer.height();
+  std::fprintf(out, "    {\"scene\": \"%s\", \"primitives\": %zu, \"width\": %d, \"height\": %d, \"threads\": %u, \"depth\": %d, "
+                    "\"scene_seconds\": %.6f, \"build_seconds\": %.6f, \"render_seconds\": %.6f, \"primary_rays\": %.0f, "
+                    "\"primary_mrays_per_second\": %.3f, \"peak_rss_kb\": %ld}",
+               scene.c_str(), world.primitive_count(), framebuffer.width(), framebuffer.height(), worker_threads(options), depth,
+               scene_seconds, world.bvh_statistics().build_seconds, render_seconds, primary_rays,
+               primary_rays / render_seconds / 1e6, usage.ru_maxrss);
+  return true;
+}
+
+}
+
+int main(int argc, char * argv[]) {
+  Sweep_Options options = parse_options(argc, argv);
+  FILE * out = options.output == "-" ? stdout : std::fopen(options.output.c_str(), "w");
+  if (!out) {
+    std::fprintf(stderr, "could not write %s\n", options.output.c_str());
+    return EXIT_FAILURE;
+  }
+
+  std::fprintf(out, "{\n  \"runs\": [\n");
+  bool first = true;
+  for (const std::string & scene : options.scenes) {
+    for (int width : options.widths) {
+      for (int threads : options.threads) {
+        for (int depth : options.depths) {
+          std::fprintf(out, first ? "" : ",\n");
+          first = false;
+          std::fflush(out);
+          std::fprintf(stderr, "%s, width %d, %d threads, depth %d\n", scene.c_str(), width, threads, depth);
+
+          pid_t child = fork();
+          if (child == 0) {
+            bool known = run(scene, width, threads, depth, out);
+            std::fflush(out);
+            _exit(known ? EXIT_SUCCESS : EXIT_FAILURE);
+          }
+          int status = 0;
+          if (child < 0 || waitpid(child, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+            std::fprintf(stderr, "render of %s failed (unknown scene?)\n", scene.c_str());
+            return EXIT_FAILURE;
+          }
+        }
+      }
+    }
+  }
+  std::fprintf(out, "\n  ]\n}\n");
+  return out == stdout || std::fclose(out) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,375 @@
+#include "scene.h"
+#include "gtest/gtest.h"
+#include <random>
+#include <vector>
+
+namespace {
+
+// rays from the points inside the cornell box towards the light, like the shadow rays of ray_color
+std::vector<Ray3df> shadow_rays(const worldObjects & world, unsigned seed) {
+  std::mt19937 generator(seed);
+  std::uniform_real_distribution<float> x(-20.f, 20.f), y(-11.f, 11.f), z(-29.f, 0.f);
+  std::vector<Ray3df> rays;
+  for (int r = 0; r < 1000; r++) {
+    Vector3df origin = {x(generator), y(generator), z(generator)};
+    rays.push_back(Ray3df{origin, world.lights[0].center - origin});
+  }
+  return rays;
+}
+
+TEST(SCENE, OccludedMatchesClosestHit) {
+  worldObjects world = cornell_box();
+  size_t blocked = 0;
+
+  for (BVH_Layout layout : {BVH_Layout::BINARY, BVH_Layout::WIDE_4, BVH_Layout::AUTOMATIC}) {
+    world.build({}, layout);
+    for (const Ray3df & ray : shadow_rays(world, 1)) {
+      Hit_Record3df hit;
+      bool expected = world.closest_hit(ray, hit) && hit.context.t < 1.f;
+      EXPECT_EQ(expected, world.occluded(ray, 1.f));
+      blocked += expected;
+    }
+  }
+  EXPECT_GT(blocked, 0u);
+}
+
+TEST(SCENE, OccludedWithoutBVH) {
+  worldObjects world(wObject(Sphere3df({0.f, 0.f, -5.f}, 1.f), Vector3df({1.f, 0.f, 0.f}), false));
+  Ray3df ray = {{0.f, 0.f, 0.f}, {0.f, 0.f, -1.f}};
+
+  EXPECT_TRUE(world.occluded(ray, 10.f));
+  EXPECT_FALSE(world.occluded(ray, 3.f));
+  EXPECT_FALSE(world.occluded(Ray3df{{0.f, 0.f, 0.f}, {0.f, 0.f, 1.f}}, 10.f));
+  world.build();
+  EXPECT_TRUE(world.occluded(ray, 10.f));
+  EXPECT_FALSE(world.occluded(ray, 3.f));
+}
+
+TEST(SCENE, CornellBoxWallsArePlanes) {
+  worldObjects world = cornell_box();
+  ASSERT_EQ(6u, world.planes.size());
+
+  Hit_Record3df hit;
+  ASSERT_TRUE(world.closest_hit(Ray3df{{0.f, 0.f, 0.f}, {0.f, 0.f, -1.f}}, hit));
+  EXPECT_EQ(Shape::PLANE, hit.shape);
+  EXPECT_EQ(30.f, hit.context.t);
+  EXPECT_EQ(1.f, hit.context.normal[2]);
+  EXPECT_EQ(0.3f, world.color(hit)[0]);
+  // the red sphere in front of the floor
+  ASSERT_TRUE(world.closest_hit(Ray3df{{0.f, 0.f, 0.f}, {3.f, -8.f, -13.f}}, hit));
+  EXPECT_EQ(Shape::SPHERE, hit.shape);
+  EXPECT_EQ(1.f, world.color(hit)[0]);
+  EXPECT_FALSE(world.reflective(hit));
+
+  // the walls occlude, the light inside the box is not
+  EXPECT_TRUE(world.occluded(Ray3df{{0.f, 0.f, 0.f}, {0.f, 40.f, 0.f}}, 1.f));
+  EXPECT_FALSE(world.occluded(Ray3df{{0.f, 0.f, 0.f}, world.lights[0].center}, 1.f));
+}
+
+TEST(SCENE, MixedSceneMatchesLinearSearch) {
+  worldObjects world = mixed_field(400, 3);
+  ASSERT_EQ(200u, world.spheres.size());
+  ASSERT_EQ(200u, world.triangles.size());
+  ASSERT_EQ(world.spheres.size(), world.sphere_materials.size());
+  ASSERT_EQ(world.triangles.size(), world.triangle_materials.size());
+  EXPECT_EQ(401u, world.primitive_count());
+
+  // the same surfaces in the same order, added without building a bvh
+  worldObjects linear;
+  for (size_t i = 0; i < world.spheres.size(); i++) {
+    linear.add(wObject(world.spheres[i], world.sphere_materials[i].color, world.sphere_materials[i].reflective));
+  }
+  for (size_t i = 0; i < world.triangles.size(); i++) {
+    linear.add(wTriangle(world.triangles[i], world.triangle_materials[i].color, world.triangle_materials[i].reflective));
+  }
+  for (size_t i = 0; i < world.planes.size(); i++) {
+    linear.add(wPlane(world.planes[i], world.plane_materials[i].color, world.plane_materials[i].reflective));
+  }
+  linear.lights = world.lights;
+
+  Camera camera(64, 36);
+  size_t shapes[3] = {};
+  for (BVH_Layout layout : {BVH_Layout::BINARY, BVH_Layout::AUTOMATIC}) {
+    world.build({}, layout);
+    for (int j = 0; j < camera.height(); j++) {
+      for (int i = 0; i < camera.width(); i++) {
+        Ray3df ray = camera.ray(i, j);
+        Hit_Record3df expected, hit;
+        bool found = world.closest_hit(ray, hit);
+        ASSERT_EQ(linear.closest_hit(ray, expected), found);
+        if (!found) {
+          continue;
+        }
+        EXPECT_EQ(expected.shape, hit.shape);
+        EXPECT_EQ(expected.index, hit.index);
+        EXPECT_EQ(linear.color(expected)[0], world.color(hit)[0]);
+        EXPECT_EQ(linear.reflective(expected), world.reflective(hit));
+        EXPECT_NEAR(expected.context.t, hit.context.t, 0.0001f * hit.context.t);
+        EXPECT_NEAR(1.f, hit.context.normal.length(), 0.0001f);
+        EXPECT_LE(hit.context.normal * ray.direction, 0.f);
+        shapes[static_cast<int>(hit.shape)]++;
+
+        Ray_Query3df shadow = shadow_ray(world, hit.context);
+        EXPECT_EQ(linear.occluded(shadow), world.occluded(shadow));
+      }
+    }
+  }
+  EXPECT_GT(shapes[static_cast<int>(Shape::SPHERE)], 0u);
+  EXPECT_GT(shapes[static_cast<int>(Shape::TRIANGLE)], 0u);
+  EXPECT_GT(shapes[static_cast<int>(Shape::PLANE)], 0u);
+}
+
+TEST(SCENE, SecondaryRaysSkipTheirOwnSurface) {
+  worldObjects world(wObject(Sphere3df({0.f, 0.f, -5.f}, 1.f), Vector3df({1.f, 0.f, 0.f}), true));
+  world.lights.push_back(light(Vector3df{0.f, 0.f, 0.f}));
+  world.build();
+
+  // rays hitting the sphere far from its center, where the hit point is least accurate
+  size_t hits = 0;
+  for (int i = 0; i < 100; i++) {
+    Ray3df ray = {{0.f, 0.f, 0.f}, {0.00999f * static_cast<float>(i) - 0.49f, 0.003f * static_cast<float>(i) - 0.15f, -5.f}};
+    Hit_Record3df hit;
+    if (!world.closest_hit(ray, hit)) {
+      continue;
+    }
+    hits++;
+    EXPECT_FALSE(world.occluded(shadow_ray(world, hit.context)));
+    Hit_Record3df reflected;
+    EXPECT_FALSE(world.closest_hit(reflected_ray(ray, hit.context), reflected));
+  }
+  EXPECT_GT(hits, 50u);
+}
+
+TEST(SCENE, SphereFieldIsDeterministic) {
+  worldObjects first = sphere_field(200, 7),
+               second = sphere_field(200, 7);
+
+  ASSERT_EQ(200u, first.spheres.size());
+  ASSERT_EQ(1u, first.planes.size());
+  ASSERT_EQ(first.spheres.size(), second.spheres.size());
+  ASSERT_EQ(1u, first.lights.size());
+  for (size_t i = 0; i < first.spheres.size(); i++) {
+    for (size_t k = 0; k < 3; k++) {
+      EXPECT_EQ(first.spheres[i].get_center()[k], second.spheres[i].get_center()[k]);
+      EXPECT_EQ(first.sphere_materials[i].color[k], second.sphere_materials[i].color[k]);
+    }
+    EXPECT_EQ(first.spheres[i].get_radius(), second.spheres[i].get_radius());
+  }
+  EXPECT_GT(first.bvh_statistics().node_count, 0u);
+}
+
+TEST(SCENE, BuildKeepsMaterialsWithTheirGeometry) {
+  worldObjects world;
+  for (int i = 0; i < 300; i++) {
+    float x = static_cast<float>((i * 37) % 300);
+    world.add(wObject(Sphere3df({x, 0.f, -10.f}, 0.4f), Vector3df({x, 0.f, 0.f}), i % 3 == 0));
+  }
+  world.build();
+
+  ASSERT_EQ(300u, world.sphere_materials.size());
+  for (size_t i = 0; i < world.spheres.size(); i++) {
+    float x = world.spheres[i].get_center()[0];
+    EXPECT_EQ(x, world.sphere_materials[i].color[0]);
+  }
+  Hit_Record3df hit;
+  ASSERT_TRUE(world.closest_hit(Ray3df{{42.f, 0.f, 0.f}, {0.f, 0.f, -1.f}}, hit));
+  EXPECT_EQ(42.f, world.color(hit)[0]);
+}
+
+TEST(SCENE, RenderIsIndependentOfTiling) {
+  worldObjects world = sphere_field(100);
+  Framebuffer single(32, 18),
+              tiled(32, 18);
+  Render_Options options;
+  options.threads = 1;
+  render(world, single, options, 3);
+  options.threads = 3;
+  options.tile_size = 5;
+  render(world, tiled, options, 3);
+
+  for (int y = 0; y < single.height(); y++) {
+    for (int x = 0; x < single.width(); x++) {
+      for (size_t k = 0; k < 3; k++) {
+        EXPECT_EQ(single.get_pixel(x, y)[k], tiled.get_pixel(x, y)[k]);
+      }
+    }
+  }
+}
+
+// a ray bouncing between two mirrors until depth is exhausted, deeper than a recursive ray_color's stack allowed
+TEST(SCENE, DeepReflections) {
+  worldObjects world;
+  world.add(wObject(Sphere3df({0.f, 0.f, -10.f}, 5.f), Vector3df({1.f, 0.f, 0.f}), true));
+  world.add(wObject(Sphere3df({0.f, 0.f, 10.f}, 5.f), Vector3df({0.f, 1.f, 0.f}), true));
+  world.lights.push_back(light(Vector3df {0.f, 20.f, 0.f}));
+  world.build();
+  Ray3df ray = {{0.f, 0.f, 0.f}, {0.f, 0.f, -1.f}};
+
+  Vector3df color = ray_color(ray, world, 1000000);
+  for (size_t k = 0; k < 3; k++) {
+    EXPECT_EQ(0.f, color[k]);
+  }
+}
+
+// a mirror in front of the camera and a white diffuse sphere behind it, every surface has an intensity of 0.3
+worldObjects mirror_and_sphere() {
+  worldObjects world;
+  world.add(wObject(Sphere3df({0.f, 0.f, -10.f}, 5.f), Vector3df({1.f, 0.f, 0.f}), true));
+  world.add(wObject(Sphere3df({0.f, 0.f, 10.f}, 5.f), Vector3df({1.f, 1.f, 1.f}), false));
+  world.lights.push_back(light(Vector3df {0.f, 20.f, 0.f}));
+  world.build();
+  return world;
+}
+
+TEST(SCENE, MinThroughputCutsOffPaths) {
+  worldObjects world = mirror_and_sphere();
+  for (Material & material : world.sphere_materials) {
+    material.reflective = true;  // two mirrors
+  }
+  Ray3df ray = {{0.f, 0.f, 0.f}, {0.f, 0.f, -1.f}};
+  Path_Termination termination;
+  termination.min_throughput = 1e-3f;
+  uint32_t random_state = 1u;
+  Path_Statistics statistics;
+
+  Vector3df color = ray_color(ray, world, 100, termination, random_state, &statistics);
+  EXPECT_EQ(0.f, color[0]);
+  EXPECT_EQ(6u, statistics.bounces);  // 0.3^6 < 1e-3 < 0.3^5
+  EXPECT_EQ(1u, statistics.terminated_by_throughput);
+  EXPECT_EQ(94u, statistics.bounces_saved);
+  EXPECT_EQ(0u, statistics.terminated_by_roulette);
+}
+
+TEST(SCENE, RussianRouletteIsUnbiased) {
+  worldObjects world = mirror_and_sphere();
+  Ray3df ray = {{0.f, 0.f, 0.f}, {0.f, 0.f, -1.f}};
+  Vector3df expected = ray_color(ray, world, 5);
+  EXPECT_NEAR(0.09f, expected[0], 1e-6f);
+
+  Path_Termination termination;
+  termination.roulette_throughput = 1.f;  // the path survives the mirror with probability 0.3
+  uint32_t random_state = 1u;
+  Path_Statistics statistics;
+  const int samples = 100000;
+  double sum = 0.0;
+  for (int i = 0; i < samples; i++) {
+    sum += ray_color(ray, world, 5, termination, random_state, &statistics)[0];
+  }
+  EXPECT_NEAR(expected[0], sum / samples, 0.003);
+  EXPECT_NEAR(0.7, static_cast<double>(statistics.terminated_by_roulette) / samples, 0.01);
+  EXPECT_EQ(4 * statistics.terminated_by_roulette, statistics.bounces_saved);
+}
+
+TEST(SCENE, RenderIsIndependentOfTraversalOrder) {
+  worldObjects world = sphere_field(100);
+  Render_Options options;
+  options.threads = 2;
+  options.tile_size = 8;
+  Framebuffer scanline(40, 22);
+  render(world, scanline, options, 3);
+
+  for (Traversal_Order order : {Traversal_Order::MORTON, Traversal_Order::HILBERT}) {
+    options.tile_order = order;
+    options.pixel_order = order;
+    // hilbert with one tile far larger than the image, its pixel order is only built over the image
+    options.tile_size = order == Traversal_Order::MORTON ? 8 : MAX_TILE_SIZE;
+    Framebuffer ordered(40, 22);
+    render(world, ordered, options, 3);
+    for (int y = 0; y < scanline.height(); y++) {
+      for (int x = 0; x < scanline.width(); x++) {
+        for (size_t k = 0; k < 3; k++) {
+          EXPECT_EQ(scanline.get_pixel(x, y)[k], ordered.get_pixel(x, y)[k]);
+        }
+      }
+    }
+  }
+}
+
+// checks that the packet queries give the same results as single rays for the given packet
+void expect_packet_matches_single_rays(const worldObjects & world, const Ray_Packet & packet) {
+  Hit_Record3df hits[Ray_Packet::WIDTH];
+  Ray_Packet traced = packet;
+  unsigned hit = world.closest_hit(traced, hits);
+  for (size_t i = 0; i < Ray_Packet::WIDTH; i++) {
+    if (!(packet.active & (1u << i))) {
+      continue;
+    }
+    Hit_Record3df expected;
+    ASSERT_EQ(world.closest_hit(Ray_Query3df(packet.ray(i), packet.tmin[i]), expected), (hit & (1u << i)) != 0);
+    if (hit & (1u << i)) {
+      EXPECT_EQ(expected.index, hits[i].index);
+      EXPECT_EQ(expected.context.t, hits[i].context.t);
+      for (size_t k = 0; k < 3; k++) {
+        EXPECT_EQ(expected.context.normal[k], hits[i].context.normal[k]);
+      }
+    }
+  }
+
+  traced = packet;
+  unsigned occluded = world.occluded(traced);
+  for (size_t i = 0; i < Ray_Packet::WIDTH; i++) {
+    if (packet.active & (1u << i)) {
+      EXPECT_EQ(world.occluded(packet.query(i)), (occluded & (1u << i)) != 0);
+    }
+  }
+}
+
+TEST(SCENE, PacketsMatchSingleRays) {
+  Packet_Statistics statistics;
+  for (worldObjects world : {cornell_box(), sphere_field(500), mixed_field(500)}) {
+    world.build({}, BVH_Layout::BINARY);
+    Camera camera(45, 20);
+
+    // primary rays of rows of pixels and shadow rays from random points towards the light
+    for (int j = 0; j < camera.height(); j++) {
+      for (int i = 0; i < camera.width(); i += static_cast<int>(Ray_Packet::WIDTH)) {
+        Ray_Packet packet;
+        for (int lane = 0; lane < static_cast<int>(Ray_Packet::WIDTH) && i + lane < camera.width(); lane++) {
+          packet.set(static_cast<size_t>(lane), camera.ray(i + lane, j), 0.f);
+        }
+        expect_packet_matches_single_rays(world, packet);
+      }
+    }
+    std::vector<Ray3df> rays = shadow_rays(world, 2);
+    for (size_t r = 0; r + Ray_Packet::WIDTH <= rays.size(); r += Ray_Packet::WIDTH) {
+      Ray_Packet packet;
+      for (size_t lane = 0; lane < Ray_Packet::WIDTH; lane++) {
+        packet.set(lane, rays[r + lane], 1.f);
+      }
+      expect_packet_matches_single_rays(world, packet);
+    }
+
+    // the layouts without packet traversal trace the rays one by one
+    world.build({}, BVH_Layout::WIDE_4);
+    Ray_Packet packet;
+    packet.set(0, camera.ray(3, 4), 0.f);
+    packet.set(1, camera.ray(4, 4), 0.f);
+    expect_packet_matches_single_rays(world, packet);
+  }
+}
+
+TEST(SCENE, RenderWithPacketsMatchesSingleRays) {
+  Render_Options options;
+  options.threads = 2;
+  options.tile_size = 12;  // rows of tiles are not a multiple of the packet width
+  for (worldObjects world : {cornell_box(), sphere_field(300)}) {
+    world.build({}, BVH_Layout::BINARY);
+    Framebuffer single(50, 28), packets(50, 28);
+    Path_Statistics single_statistics, packet_statistics;
+    render(world, single, options, 3, {}, &single_statistics);
+    options.packets = true;
+    render(world, packets, options, 3, {}, &packet_statistics);
+    options.packets = false;
+
+    EXPECT_EQ(single_statistics.bounces, packet_statistics.bounces);
+    for (int y = 0; y < single.height(); y++) {
+      for (int x = 0; x < single.width(); x++) {
+        for (size_t k = 0; k < 3; k++) {
+          EXPECT_EQ(single.get_pixel(x, y)[k], packets.get_pixel(x, y)[k]);
+        }
+      }
+    }
+  }
+}
+
+}
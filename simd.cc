@@ -0,0 +1,19 @@
+#include "simd.h"
+
+SIMD_Level simd_level() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return SIMD_Level::AVX2;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return SIMD_Level::SSE;
+  }
+#endif
+  return SIMD_Level::SCALAR;
+}
+
+bool has_avx2() {
+  static const bool avx2 = simd_level() == SIMD_Level::AVX2;
+  return avx2;
+}
@@ -0,0 +1,52 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <cstddef>
+#include <new>
+
+// contains the runtime detection of SIMD instruction sets and helpers for code using SIMD intrinsics
+
+
+// the widest SIMD instruction set that can be used
+enum class SIMD_Level {
+  SCALAR,
+  SSE,
+  AVX2
+};
+
+// returns the widest SIMD instruction set supported by the executing cpu
+SIMD_Level simd_level();
+
+// returns whether simd_level() is SIMD_Level::AVX2, detected once on the first call
+bool has_avx2();
+
+#if defined(__x86_64__) || defined(__i386__)
+// compiles a function (and everything inlined into it) for cpus supporting AVX2,
+// it must only be called if has_avx2() returns true
+#define AVX2_FUNCTION __attribute__((target("avx2"), flatten))
+#else
+#define AVX2_FUNCTION
+#endif
+
+// an allocator returning memory aligned to ALIGNMENT bytes, e.g. for std::vector<float> used with aligned SIMD loads
+template <class T, size_t ALIGNMENT>
+struct Aligned_Allocator {
+  typedef T value_type;
+
+  template <class U>
+  struct rebind { typedef Aligned_Allocator<U, ALIGNMENT> other; };
+
+  Aligned_Allocator() = default;
+
+  template <class U>
+  Aligned_Allocator(const Aligned_Allocator<U, ALIGNMENT> &) { }
+
+  T * allocate(size_t n) { return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(ALIGNMENT))); }
+
+  void deallocate(T * p, size_t) { ::operator delete(p, std::align_val_t(ALIGNMENT)); }
+
+  template <class U>
+  bool operator==(const Aligned_Allocator<U, ALIGNMENT> &) const { return true; }
+};
+
+#endif
@@ -0,0 +1,372 @@
+#include "sphere_soa.h"
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// pointers to the arrays of a SphereSoA
+struct Sphere_Arrays {
+  const float * x,
+              * y,
+              * z,
+              * radius_squared;
+};
+
+// visits the lanes set in mask in ascending order and keeps the smallest t below tmax
+inline bool closest_lane(unsigned mask, const float t[], size_t i, float & tmax, size_t & index) {
+  bool hit = false;
+  while (mask != 0) {
+    unsigned lane = static_cast<unsigned>(__builtin_ctz(mask));
+    mask &= mask - 1;
+    if (t[lane] < tmax) {
+      tmax = t[lane];
+      index = i + lane;
+      hit = true;
+    }
+  }
+  return hit;
+}
+
+// the mask of the lanes i, ..., i + width - 1 which lie before end
+inline unsigned lanes_before(size_t i, size_t end, size_t width) {
+  return end - i >= width ? (1u << width) - 1u : (1u << (end - i)) - 1u;
+}
+
+// all kernels compute, like Sphere::intersects(query),
+//   om = origin - center, a = direction * direction, b = 2 (om * direction), c = om * om - radius^2,
+//   d = b^2 - 4ac and t = (-b +- sqrt(d)) / 2a, '-' unless the near intersection lies before tmin, i.e. unless
+//   (-b - sqrt(d)) / 2 <= tmin * a (e.g. if the origin lies inside the sphere and tmin = 0)
+// and return the lanes with d >= 0 and tmin < t < tmax
+
+#if !defined(__SSE2__)
+bool closest_hit_scalar(const Sphere_Arrays & spheres, const Ray3df & ray, size_t first, size_t end, float tmin, float & tmax, size_t & index) {
+  float a = ray.direction[0] * ray.direction[0] + ray.direction[1] * ray.direction[1] + ray.direction[2] * ray.direction[2];
+  bool hit = false;
+  for (size_t i = first; i < end; i++) {
+    float omx = ray.origin[0] - spheres.x[i],
+          omy = ray.origin[1] - spheres.y[i],
+          omz = ray.origin[2] - spheres.z[i];
+    float b = 2.0f * (omx * ray.direction[0] + omy * ray.direction[1] + omz * ray.direction[2]),
+          c = omx * omx + omy * omy + omz * omz - spheres.radius_squared[i],
+          d = b * b - 4.0f * a * c;
+    if (d < 0.0f) {
+      continue;
+    }
+    float root = std::sqrt(d),
+          near = -b - root,
+          t = 0.5f * (0.5f * near > tmin * a ? near : -b + root) / a;
+    if (t > tmin && t < tmax) {
+      tmax = t;
+      index = i;
+      hit = true;
+    }
+  }
+  return hit;
+}
+#endif
+
+#if defined(__SSE2__)
+bool closest_hit_sse(const Sphere_Arrays & spheres, const Ray3df & ray, size_t first, size_t end, float tmin, float & tmax, size_t & index) {
+  const __m128 zero = _mm_setzero_ps(),
+               half = _mm_set1_ps(0.5f),
+               two = _mm_set1_ps(2.0f),
+               four = _mm_set1_ps(4.0f);
+  const __m128 ox = _mm_set1_ps(ray.origin[0]), oy = _mm_set1_ps(ray.origin[1]), oz = _mm_set1_ps(ray.origin[2]),
+               dx = _mm_set1_ps(ray.direction[0]), dy = _mm_set1_ps(ray.direction[1]), dz = _mm_set1_ps(ray.direction[2]);
+  const __m128 a = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)),
+               t_min = _mm_set1_ps(tmin),
+               tmin_a = _mm_mul_ps(t_min, a);
+  alignas(16) float t[4];
+  bool hit = false;
+
+  for (size_t i = first; i < end; i += 4) {
+    __m128 omx = _mm_sub_ps(ox, _mm_loadu_ps(spheres.x + i)),
+           omy = _mm_sub_ps(oy, _mm_loadu_ps(spheres.y + i)),
+           omz = _mm_sub_ps(oz, _mm_loadu_ps(spheres.z + i));
+    __m128 b = _mm_mul_ps(two, _mm_add_ps(_mm_add_ps(_mm_mul_ps(omx, dx), _mm_mul_ps(omy, dy)), _mm_mul_ps(omz, dz))),
+           c = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(omx, omx), _mm_mul_ps(omy, omy)), _mm_mul_ps(omz, omz)),
+                          _mm_loadu_ps(spheres.radius_squared + i)),
+           d = _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(four, _mm_mul_ps(a, c)));
+    __m128 root = _mm_sqrt_ps(_mm_max_ps(d, zero)),
+           far = _mm_sub_ps(root, b),
+           near = _mm_sub_ps(_mm_xor_ps(root, _mm_set1_ps(-0.0f)), b);
+    // -b - root, or -b + root in the lanes where the near intersection lies before tmin
+    __m128 use_near = _mm_cmpgt_ps(_mm_mul_ps(half, near), tmin_a);
+    __m128 tv = _mm_div_ps(_mm_mul_ps(half, _mm_or_ps(_mm_and_ps(use_near, near), _mm_andnot_ps(use_near, far))), a);
+    __m128 valid = _mm_and_ps(_mm_cmpge_ps(d, zero), _mm_and_ps(_mm_cmpgt_ps(tv, t_min), _mm_cmplt_ps(tv, _mm_set1_ps(tmax))));
+    unsigned mask = static_cast<unsigned>(_mm_movemask_ps(valid)) & lanes_before(i, end, 4u);
+    if (mask != 0) {
+      _mm_store_ps(t, tv);
+      hit |= closest_lane(mask, t, i, tmax, index);
+    }
+  }
+  return hit;
+}
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+AVX2_FUNCTION
+bool closest_hit_avx2(const Sphere_Arrays & spheres, const Ray3df & ray, size_t first, size_t end, float tmin, float & tmax, size_t & index) {
+  const __m256 zero = _mm256_setzero_ps(),
+               half = _mm256_set1_ps(0.5f),
+               two = _mm256_set1_ps(2.0f),
+               four = _mm256_set1_ps(4.0f);
+  const __m256 ox = _mm256_set1_ps(ray.origin[0]), oy = _mm256_set1_ps(ray.origin[1]), oz = _mm256_set1_ps(ray.origin[2]),
+               dx = _mm256_set1_ps(ray.direction[0]), dy = _mm256_set1_ps(ray.direction[1]), dz = _mm256_set1_ps(ray.direction[2]);
+  const __m256 a = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz)),
+               t_min = _mm256_set1_ps(tmin),
+               tmin_a = _mm256_mul_ps(t_min, a);
+  alignas(32) float t[8];
+  bool hit = false;
+
+  for (size_t i = first; i < end; i += 8) {
+    __m256 omx = _mm256_sub_ps(ox, _mm256_loadu_ps(spheres.x + i)),
+           omy = _mm256_sub_ps(oy, _mm256_loadu_ps(spheres.y + i)),
+           omz = _mm256_sub_ps(oz, _mm256_loadu_ps(spheres.z + i));
+    __m256 b = _mm256_mul_ps(two, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(omx, dx), _mm256_mul_ps(omy, dy)), _mm256_mul_ps(omz, dz))),
+           c = _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(omx, omx), _mm256_mul_ps(omy, omy)), _mm256_mul_ps(omz, omz)),
+                             _mm256_loadu_ps(spheres.radius_squared + i)),
+           d = _mm256_sub_ps(_mm256_mul_ps(b, b), _mm256_mul_ps(four, _mm256_mul_ps(a, c)));
+    __m256 root = _mm256_sqrt_ps(_mm256_max_ps(d, zero)),
+           far = _mm256_sub_ps(root, b),
+           near = _mm256_sub_ps(_mm256_xor_ps(root, _mm256_set1_ps(-0.0f)), b);
+    __m256 use_near = _mm256_cmp_ps(_mm256_mul_ps(half, near), tmin_a, _CMP_GT_OQ);
+    __m256 tv = _mm256_div_ps(_mm256_mul_ps(half, _mm256_blendv_ps(far, near, use_near)), a);
+    __m256 valid = _mm256_and_ps(_mm256_cmp_ps(d, zero, _CMP_GE_OQ),
+                                 _mm256_and_ps(_mm256_cmp_ps(tv, t_min, _CMP_GT_OQ), _mm256_cmp_ps(tv, _mm256_set1_ps(tmax), _CMP_LT_OQ)));
+    unsigned mask = static_cast<unsigned>(_mm256_movemask_ps(valid)) & lanes_before(i, end, 8u);
+    if (mask != 0) {
+      _mm256_store_ps(t, tv);
+      hit |= closest_lane(mask, t, i, tmax, index);
+    }
+  }
+  return hit;
+}
+#endif
+
+// the packet kernels test one sphere against 4 (SSE) or 8 (AVX2) rays, their arithmetic is the one of the kernels
+// above, so that each ray gets the same t as a single ray
+// closest hit queries write the lowered tmax of the rays to tmax and set index for the rays hit, any hit queries
+// (index == nullptr) stop as soon as all rays in mask are hit, both return the mask of the rays hit
+// the rays outside of mask are neither tested nor changed
+
+#if defined(__SSE2__)
+unsigned packet_hit_sse(const Sphere_Arrays & spheres, const Ray_Packet & packet, size_t first, size_t end, unsigned mask,
+                        size_t index[], float tmax_out[]) {
+  const __m128 zero = _mm_setzero_ps(),
+               half = _mm_set1_ps(0.5f),
+               two = _mm_set1_ps(2.0f),
+               four = _mm_set1_ps(4.0f);
+  unsigned hit = 0;
+  bool any = index == nullptr;
+
+  for (size_t lanes = 0; lanes < Ray_Packet::WIDTH; lanes += 4) {
+    unsigned lane_mask = (mask >> lanes) & 15u;
+    if (lane_mask == 0) {
+      continue;
+    }
+    const __m128 ox = _mm_load_ps(packet.origin[0] + lanes), oy = _mm_load_ps(packet.origin[1] + lanes), oz = _mm_load_ps(packet.origin[2] + lanes),
+                 dx = _mm_load_ps(packet.direction[0] + lanes), dy = _mm_load_ps(packet.direction[1] + lanes), dz = _mm_load_ps(packet.direction[2] + lanes);
+    const __m128 a = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)),
+                 t_min = _mm_load_ps(packet.tmin + lanes),
+                 tmin_a = _mm_mul_ps(t_min, a);
+    const __m128i bits = _mm_setr_epi32(1, 2, 4, 8);
+    const __m128 in_mask = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(static_cast<int>(lane_mask)), bits), bits));
+    __m128 tmax = _mm_load_ps(packet.tmax + lanes);
+    unsigned lane_hit = 0;
+
+    for (size_t i = first; i < end && !(any && lane_hit == lane_mask); i++) {
+      __m128 omx = _mm_sub_ps(ox, _mm_set1_ps(spheres.x[i])),
+             omy = _mm_sub_ps(oy, _mm_set1_ps(spheres.y[i])),
+             omz = _mm_sub_ps(oz, _mm_set1_ps(spheres.z[i]));
+      __m128 b = _mm_mul_ps(two, _mm_add_ps(_mm_add_ps(_mm_mul_ps(omx, dx), _mm_mul_ps(omy, dy)), _mm_mul_ps(omz, dz))),
+             c = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(omx, omx), _mm_mul_ps(omy, omy)), _mm_mul_ps(omz, omz)),
+                            _mm_set1_ps(spheres.radius_squared[i])),
+             d = _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(four, _mm_mul_ps(a, c)));
+      __m128 root = _mm_sqrt_ps(_mm_max_ps(d, zero)),
+             far = _mm_sub_ps(root, b),
+             near = _mm_sub_ps(_mm_xor_ps(root, _mm_set1_ps(-0.0f)), b);
+      __m128 use_near = _mm_cmpgt_ps(_mm_mul_ps(half, near), tmin_a);
+      __m128 tv = _mm_div_ps(_mm_mul_ps(half, _mm_or_ps(_mm_and_ps(use_near, near), _mm_andnot_ps(use_near, far))), a);
+      __m128 valid = _mm_and_ps(_mm_and_ps(in_mask, _mm_cmpge_ps(d, zero)), _mm_and_ps(_mm_cmpgt_ps(tv, t_min), _mm_cmplt_ps(tv, tmax)));
+      unsigned valid_mask = static_cast<unsigned>(_mm_movemask_ps(valid));
+      if (valid_mask == 0) {
+        continue;
+      }
+      lane_hit |= valid_mask;
+      if (!any) {
+        tmax = _mm_or_ps(_mm_and_ps(valid, tv), _mm_andnot_ps(valid, tmax));
+        for (unsigned rays = valid_mask; rays != 0; rays &= rays - 1) {
+          index[lanes + static_cast<unsigned>(__builtin_ctz(rays))] = i;
+        }
+      }
+    }
+    if (!any) {
+      _mm_storeu_ps(tmax_out + lanes, tmax);
+    }
+    hit |= lane_hit << lanes;
+  }
+  return hit;
+}
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+AVX2_FUNCTION
+unsigned packet_hit_avx2(const Sphere_Arrays & spheres, const Ray_Packet & packet, size_t first, size_t end, unsigned mask,
+                         size_t index[], float tmax_out[]) {
+  const __m256 zero = _mm256_setzero_ps(),
+               half = _mm256_set1_ps(0.5f),
+               two = _mm256_set1_ps(2.0f),
+               four = _mm256_set1_ps(4.0f);
+  const __m256 ox = _mm256_load_ps(packet.origin[0]), oy = _mm256_load_ps(packet.origin[1]), oz = _mm256_load_ps(packet.origin[2]),
+               dx = _mm256_load_ps(packet.direction[0]), dy = _mm256_load_ps(packet.direction[1]), dz = _mm256_load_ps(packet.direction[2]);
+  const __m256 a = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz)),
+               t_min = _mm256_load_ps(packet.tmin),
+               tmin_a = _mm256_mul_ps(t_min, a);
+  const __m256i bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+  const __m256 in_mask = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(static_cast<int>(mask)), bits), bits));
+  __m256 tmax = _mm256_load_ps(packet.tmax);
+  unsigned hit = 0;
+  bool any = index == nullptr;
+
+  for (size_t i = first; i < end && !(any && hit == mask); i++) {
+    __m256 omx = _mm256_sub_ps(ox, _mm256_set1_ps(spheres.x[i])),
+           omy = _mm256_sub_ps(oy, _mm256_set1_ps(spheres.y[i])),
+           omz = _mm256_sub_ps(oz, _mm256_set1_ps(spheres.z[i]));
+    __m256 b = _mm256_mul_ps(two, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(omx, dx), _mm256_mul_ps(omy, dy)), _mm256_mul_ps(omz, dz))),
+           c = _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(omx, omx), _mm256_mul_ps(omy, omy)), _mm256_mul_ps(omz, omz)),
+                             _mm256_set1_ps(spheres.radius_squared[i])),
+           d = _mm256_sub_ps(_mm256_mul_ps(b, b), _mm256_mul_ps(four, _mm256_mul_ps(a, c)));
+    __m256 root = _mm256_sqrt_ps(_mm256_max_ps(d, zero)),
+           far = _mm256_sub_ps(root, b),
+           near = _mm256_sub_ps(_mm256_xor_ps(root, _mm256_set1_ps(-0.0f)), b);
+    __m256 use_near = _mm256_cmp_ps(_mm256_mul_ps(half, near), tmin_a, _CMP_GT_OQ);
+    __m256 tv = _mm256_div_ps(_mm256_mul_ps(half, _mm256_blendv_ps(far, near, use_near)), a);
+    __m256 valid = _mm256_and_ps(_mm256_and_ps(in_mask, _mm256_cmp_ps(d, zero, _CMP_GE_OQ)),
+                                 _mm256_and_ps(_mm256_cmp_ps(tv, t_min, _CMP_GT_OQ), _mm256_cmp_ps(tv, tmax, _CMP_LT_OQ)));
+    unsigned valid_mask = static_cast<unsigned>(_mm256_movemask_ps(valid));
+    if (valid_mask == 0) {
+      continue;
+    }
+    hit |= valid_mask;
+    if (!any) {
+      tmax = _mm256_blendv_ps(tmax, tv, valid);
+      for (unsigned rays = valid_mask; rays != 0; rays &= rays - 1) {
+        index[__builtin_ctz(rays)] = i;
+      }
+    }
+  }
+  if (!any) {
+    _mm256_storeu_ps(tmax_out, tmax);
+  }
+  return hit;
+}
+#endif
+
+}
+
+SphereSoA::SphereSoA(const std::vector<Sphere3df> & spheres) {
+  for (const Sphere3df & sphere : spheres) {
+    push_back(sphere);
+  }
+}
+
+void SphereSoA::push_back(const Sphere3df & sphere) {
+  center_x.resize(count);
+  center_y.resize(count);
+  center_z.resize(count);
+  radius_squared.resize(count);
+  Vector3df center = sphere.get_center();
+  center_x.push_back(center[0]);
+  center_y.push_back(center[1]);
+  center_z.push_back(center[2]);
+  radius_squared.push_back(sphere.get_radius() * sphere.get_radius());
+  count++;
+  pad();
+}
+
+void SphereSoA::pad() {
+  // a negative squared radius makes d = b^2 - 4ac negative for every ray
+  center_x.resize(count + WIDTH - 1, 0.0f);
+  center_y.resize(count + WIDTH - 1, 0.0f);
+  center_z.resize(count + WIDTH - 1, 0.0f);
+  radius_squared.resize(count + WIDTH - 1, -1.0f);
+}
+
+void SphereSoA::clear() {
+  center_x.clear();
+  center_y.clear();
+  center_z.clear();
+  radius_squared.clear();
+  count = 0;
+}
+
+Sphere3df SphereSoA::operator[](size_t i) const {
+  return Sphere3df({center_x[i], center_y[i], center_z[i]}, std::sqrt(radius_squared[i]));
+}
+
+bool SphereSoA::closest_hit(const Ray3df & ray, size_t first, size_t count, float tmin, float & tmax, size_t & index) const {
+  Sphere_Arrays spheres = {center_x.data(), center_y.data(), center_z.data(), radius_squared.data()};
+#if defined(__x86_64__) || defined(__i386__)
+  if (has_avx2()) {
+    return closest_hit_avx2(spheres, ray, first, first + count, tmin, tmax, index);
+  }
+#endif
+#if defined(__SSE2__)
+  return closest_hit_sse(spheres, ray, first, first + count, tmin, tmax, index);
+#else
+  return closest_hit_scalar(spheres, ray, first, first + count, tmin, tmax, index);
+#endif
+}
+
+bool SphereSoA::any_hit(const Ray3df & ray, size_t first, size_t count, float tmin, float tmax) const {
+  size_t index;
+  return closest_hit(ray, first, count, tmin, tmax, index);
+}
+
+unsigned SphereSoA::closest_hit(Ray_Packet & packet, size_t first, size_t count, unsigned mask, size_t index[]) const {
+  Sphere_Arrays spheres = {center_x.data(), center_y.data(), center_z.data(), radius_squared.data()};
+#if defined(__x86_64__) || defined(__i386__)
+  if (has_avx2()) {
+    return packet_hit_avx2(spheres, packet, first, first + count, mask, index, packet.tmax);
+  }
+#endif
+#if defined(__SSE2__)
+  return packet_hit_sse(spheres, packet, first, first + count, mask, index, packet.tmax);
+#else
+  unsigned hit = 0;
+  for (unsigned rays = mask; rays != 0; rays &= rays - 1) {
+    unsigned i = static_cast<unsigned>(__builtin_ctz(rays));
+    if (closest_hit_scalar(spheres, packet.ray(i), first, first + count, packet.tmin[i], packet.tmax[i], index[i])) {
+      hit |= 1u << i;
+    }
+  }
+  return hit;
+#endif
+}
+
+unsigned SphereSoA::any_hit(const Ray_Packet & packet, size_t first, size_t count, unsigned mask) const {
+  Sphere_Arrays spheres = {center_x.data(), center_y.data(), center_z.data(), radius_squared.data()};
+#if defined(__x86_64__) || defined(__i386__)
+  if (has_avx2()) {
+    return packet_hit_avx2(spheres, packet, first, first + count, mask, nullptr, nullptr);
+  }
+#endif
+#if defined(__SSE2__)
+  return packet_hit_sse(spheres, packet, first, first + count, mask, nullptr, nullptr);
+#else
+  unsigned hit = 0;
+  for (unsigned lanes = mask; lanes != 0; lanes &= lanes - 1) {
+    unsigned i = static_cast<unsigned>(__builtin_ctz(lanes));
+    float tmax = packet.tmax[i];
+    size_t index;
+    if (closest_hit_scalar(spheres, packet.ray(i), first, first + count, packet.tmin[i], tmax, index)) {
+      hit |= 1u << i;
+    }
+  }
+  return hit;
+#endif
+}
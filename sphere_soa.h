@@ -0,0 +1,62 @@
+#ifndef SPHERE_SOA_H
+#define SPHERE_SOA_H
+
+#include "geometry.h"
+#include "ray_packet.h"
+#include "simd.h"
+#include <cstddef>
+#include <vector>
+
+// contains spheres stored as structure of arrays, which are intersected with a ray 8 (AVX2) or 4 (SSE) at a time
+
+
+// spheres with float coordinates in 3d, stored as separate arrays of center coordinates and squared radii
+// each array is 32 byte aligned and padded with WIDTH - 1 spheres that are never hit, so that the
+// kernels may load WIDTH spheres starting at any index
+class SphereSoA {
+public:
+  static constexpr size_t WIDTH = 8u;
+
+  SphereSoA() = default;
+
+  explicit SphereSoA(const std::vector<Sphere3df> & spheres);
+
+  void push_back(const Sphere3df & sphere);
+
+  void clear();
+
+  size_t size() const { return count; }
+
+  bool empty() const { return count == 0; }
+
+  // returns the i-th sphere
+  Sphere3df operator[](size_t i) const;
+
+  // intersects the ray with the spheres first, ..., first + count - 1
+  // finds the sphere with the smallest t, tmin < t < tmax, where t is chosen as in Sphere::intersects(query)
+  // (the far intersection if the near one lies before tmin, e.g. if the ray starts inside the sphere)
+  // returns false if there is none, otherwise sets tmax to its t and index to its index
+  // the choice of the intersection compares the near one with tmin and does not need a division
+  bool closest_hit(const Ray3df & ray, size_t first, size_t count, float tmin, float & tmax, size_t & index) const;
+
+  // returns true iff one of the spheres first, ..., first + count - 1 is hit at some tmin < t < tmax
+  bool any_hit(const Ray3df & ray, size_t first, size_t count, float tmin, float tmax) const;
+
+  // the same for the rays of a prepared packet given by mask, each sphere is tested against all rays at once
+  // lowers packet.tmax[i] and sets index[i] for every ray i which hits a sphere at packet.tmin[i] < t < packet.tmax[i]
+  // returns the mask of these rays, every ray finds the same sphere and t as closest_hit(packet.ray(i), ...)
+  unsigned closest_hit(Ray_Packet & packet, size_t first, size_t count, unsigned mask, size_t index[]) const;
+
+  // returns the mask of the rays in mask which hit one of the spheres at some packet.tmin[i] < t < packet.tmax[i]
+  unsigned any_hit(const Ray_Packet & packet, size_t first, size_t count, unsigned mask) const;
+
+private:
+  typedef std::vector<float, Aligned_Allocator<float, 32u>> Array;
+
+  void pad();
+
+  Array center_x, center_y, center_z, radius_squared;
+  size_t count = 0;
+};
+
+#endif
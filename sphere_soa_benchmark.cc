@@ -0,0 +1,57 @@
+#include "sphere_soa.h"
+#include "random_spheres.h"
+#include "benchmark/benchmark.h"
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace {
+
+std::vector<Ray3df> random_rays() {
+  std::mt19937 generator(7);
+  std::uniform_real_distribution<float> direction(-0.5f, 0.5f);
+  std::vector<Ray3df> rays;
+  for (int i = 0; i < 1024; i++) {
+    rays.push_back(Ray3df{{0.f, 0.f, 0.f}, {direction(generator), direction(generator), -1.f}});
+  }
+  return rays;
+}
+
+// one ray against all spheres, one sphere at a time, items are sphere tests
+void BM_SpheresScalar(benchmark::State & state) {
+  std::vector<Sphere3df> spheres = random_spheres(static_cast<size_t>(state.range(0)), 42, 20.f, 0.1f, 2.f, {0.f, 0.f, -40.f});
+  std::vector<Ray3df> rays = random_rays();
+  size_t r = 0;
+  for (auto _ : state) {
+    const Ray3df & ray = rays[r++ & 1023u];
+    float tmax = std::numeric_limits<float>::max();
+    size_t index = spheres.size();
+    for (size_t i = 0; i < spheres.size(); i++) {
+      float t = spheres[i].intersects(ray);
+      if (t > 0.f && t < tmax) {
+        tmax = t;
+        index = i;
+      }
+    }
+    benchmark::DoNotOptimize(index);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SpheresScalar)->RangeMultiplier(4)->Range(4, 1024);
+
+// the same with the SIMD kernel (8 spheres per step with AVX2, 4 with SSE)
+void BM_SpheresSoA(benchmark::State & state) {
+  SphereSoA spheres(random_spheres(static_cast<size_t>(state.range(0)), 42, 20.f, 0.1f, 2.f, {0.f, 0.f, -40.f}));
+  std::vector<Ray3df> rays = random_rays();
+  size_t r = 0;
+  for (auto _ : state) {
+    float tmax = std::numeric_limits<float>::max();
+    size_t index = spheres.size();
+    benchmark::DoNotOptimize(spheres.closest_hit(rays[r++ & 1023u], 0, spheres.size(), 0.f, tmax, index));
+    benchmark::DoNotOptimize(index);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SpheresSoA)->RangeMultiplier(4)->Range(4, 1024);
+
+}
@@ -0,0 +1,151 @@
+#include "sphere_soa.h"
+#include "random_spheres.h"
+#include "gtest/gtest.h"
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace {
+
+// the closest of the spheres first, ..., end - 1 via Sphere::intersects, returns end if none is hit
+size_t scalar_closest(const std::vector<Sphere3df> & spheres, const Ray3df & ray, size_t first, size_t end, float & t) {
+  size_t closest = end;
+  t = std::numeric_limits<float>::max();
+  for (size_t i = first; i < end; i++) {
+    float candidate = spheres[i].intersects(ray);
+    if (candidate > 0.f && candidate < t) {
+      t = candidate;
+      closest = i;
+    }
+  }
+  return closest;
+}
+
+TEST(SPHERE_SOA, StoresSpheres) {
+  std::vector<Sphere3df> spheres = random_spheres(13, 1, 10.f, 0.1f, 3.f);
+  SphereSoA soa(spheres);
+
+  ASSERT_EQ(13u, soa.size());
+  for (size_t i = 0; i < spheres.size(); i++) {
+    for (size_t k = 0; k < 3; k++) {
+      EXPECT_EQ(spheres[i].get_center()[k], soa[i].get_center()[k]);
+    }
+    EXPECT_NEAR(spheres[i].get_radius(), soa[i].get_radius(), 0.00001);
+  }
+  soa.clear();
+  EXPECT_TRUE(soa.empty());
+}
+
+TEST(SPHERE_SOA, ClosestHitMatchesSphereIntersects) {
+  // the ray origins lie between the spheres, some of them inside a sphere
+  std::vector<Sphere3df> spheres = random_spheres(37, 2, 10.f, 0.1f, 3.f);
+  SphereSoA soa(spheres);
+  std::mt19937 generator(3);
+  std::uniform_real_distribution<float> position(-10.f, 10.f), direction(-1.f, 1.f);
+  std::uniform_int_distribution<size_t> offset(0, spheres.size());
+
+  for (int r = 0; r < 2000; r++) {
+    Ray3df ray = { {position(generator), position(generator), position(generator)},
+                   {direction(generator), direction(generator), direction(generator)} };
+    size_t first = offset(generator),
+           end = offset(generator);
+    if (first > end) {
+      std::swap(first, end);
+    }
+    float expected_t;
+    size_t expected = scalar_closest(spheres, ray, first, end, expected_t);
+
+    float t = std::numeric_limits<float>::max();
+    size_t index = end;
+    EXPECT_EQ(expected != end, soa.closest_hit(ray, first, end - first, 0.f, t, index));
+    EXPECT_EQ(expected, index);
+    if (expected != end) {
+      EXPECT_NEAR(expected_t, t, 0.0001f * expected_t);
+    }
+    EXPECT_EQ(expected != end, soa.any_hit(ray, first, end - first, 0.f, std::numeric_limits<float>::max()));
+  }
+}
+
+TEST(SPHERE_SOA, RespectsTmax) {
+  SphereSoA soa(std::vector<Sphere3df>{ Sphere3df({5.0, 0.0, 0.0}, 1.0), Sphere3df({10.0, 0.0, 0.0}, 1.0) });
+  Ray3df ray = { {0.0, 0.0, 0.0}, {1.0, 0.0, 0.0} };
+  size_t index = 2;
+
+  float t = 3.5f;
+  EXPECT_FALSE(soa.closest_hit(ray, 0, 2, 0.f, t, index));
+  EXPECT_FALSE(soa.any_hit(ray, 0, 2, 0.f, 3.5f));
+  EXPECT_EQ(2u, index);
+
+  t = 100.f;
+  EXPECT_TRUE(soa.closest_hit(ray, 0, 2, 0.f, t, index));
+  EXPECT_EQ(0u, index);
+  EXPECT_NEAR(4.f, t, 0.00001);
+
+  // only the second sphere
+  t = 100.f;
+  EXPECT_TRUE(soa.closest_hit(ray, 1, 1, 0.f, t, index));
+  EXPECT_EQ(1u, index);
+  EXPECT_NEAR(9.f, t, 0.00001);
+}
+
+TEST(SPHERE_SOA, RayStartingInside) {
+  SphereSoA soa(std::vector<Sphere3df>{ Sphere3df({0.0, 0.0, 0.0}, 2.0) });
+  Ray3df ray = { {0.0, 0.0, 0.0}, {0.0, 0.0, -1.0} };
+  float t = std::numeric_limits<float>::max();
+  size_t index;
+
+  EXPECT_TRUE(soa.closest_hit(ray, 0, 1, 0.f, t, index));
+  EXPECT_NEAR(2.f, t, 0.00001);
+}
+
+TEST(SPHERE_SOA, PacketMatchesSingleRays) {
+  std::vector<Sphere3df> spheres = random_spheres(37, 4, 10.f, 0.1f, 3.f);
+  SphereSoA soa(spheres);
+  std::mt19937 generator(5);
+  std::uniform_real_distribution<float> position(-10.f, 10.f), direction(-1.f, 1.f), tmin(0.f, 2.f), tmax(1.f, 30.f);
+  std::uniform_int_distribution<size_t> offset(0, spheres.size());
+  std::uniform_int_distribution<unsigned> lanes(1u, 255u);
+
+  for (int p = 0; p < 500; p++) {
+    Ray_Packet packet;
+    for (size_t i = 0; i < Ray_Packet::WIDTH; i++) {
+      Ray3df ray = { {position(generator), position(generator), position(generator)},
+                     {direction(generator), direction(generator), direction(generator)} };
+      // some rays skip the near intersection of the spheres they start close to
+      packet.set(i, Ray_Query3df(ray, i % 2 == 0 ? 0.f : tmin(generator), tmax(generator)));
+    }
+    packet.prepare();
+    size_t first = offset(generator),
+           end = offset(generator);
+    if (first > end) {
+      std::swap(first, end);
+    }
+    unsigned mask = lanes(generator);
+
+    unsigned expected_any = 0;
+    for (size_t i = 0; i < Ray_Packet::WIDTH; i++) {
+      expected_any |= static_cast<unsigned>(soa.any_hit(packet.ray(i), first, end - first, packet.tmin[i], packet.tmax[i]) && (mask & (1u << i))) << i;
+    }
+    EXPECT_EQ(expected_any, soa.any_hit(packet, first, end - first, mask));
+
+    float t[Ray_Packet::WIDTH];
+    size_t expected_index[Ray_Packet::WIDTH], index[Ray_Packet::WIDTH];
+    unsigned expected = 0;
+    for (size_t i = 0; i < Ray_Packet::WIDTH; i++) {
+      t[i] = packet.tmax[i];
+      if ((mask & (1u << i)) && soa.closest_hit(packet.ray(i), first, end - first, packet.tmin[i], t[i], expected_index[i])) {
+        expected |= 1u << i;
+      }
+    }
+    ASSERT_EQ(expected, soa.closest_hit(packet, first, end - first, mask, index));
+    for (size_t i = 0; i < Ray_Packet::WIDTH; i++) {
+      // the same arithmetic gives the same t
+      EXPECT_EQ(t[i], packet.tmax[i]);
+      if (expected & (1u << i)) {
+        EXPECT_EQ(expected_index[i], index[i]);
+      }
+    }
+  }
+}
+
+}
@@ -0,0 +1,268 @@
+#include "triangle_soa.h"
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// rays almost parallel to a triangle's plane (|det| below) miss it, as in Triangle::intersects
+const float EPSILON = 10e-7f;
+
+// pointers to the arrays of a TriangleSoA
+struct Triangle_Arrays {
+  const float * a[3],
+              * edge1[3],
+              * edge2[3];
+};
+
+// the Möller–Trumbore algorithm, with
+//   p = direction x edge2, det = edge1 * p, s = origin - a, q = s x edge1,
+//   u = (s * p) / det, v = (direction * q) / det, t = (edge2 * q) / det
+// the ray hits the triangle at a + u edge1 + v edge2 iff |det| >= EPSILON, u >= 0, v >= 0, u + v <= 1
+
+inline bool moeller_trumbore(const Triangle_Arrays & triangles, size_t i, const Ray3df & ray, float & t, float & u, float & v) {
+  const float * e1[3] = {triangles.edge1[0] + i, triangles.edge1[1] + i, triangles.edge1[2] + i},
+              * e2[3] = {triangles.edge2[0] + i, triangles.edge2[1] + i, triangles.edge2[2] + i};
+  float p[3] = {ray.direction[1] * *e2[2] - ray.direction[2] * *e2[1],
+                ray.direction[2] * *e2[0] - ray.direction[0] * *e2[2],
+                ray.direction[0] * *e2[1] - ray.direction[1] * *e2[0]};
+  float det = *e1[0] * p[0] + *e1[1] * p[1] + *e1[2] * p[2];
+  if (std::fabs(det) < EPSILON) {
+    return false;
+  }
+  float s[3] = {ray.origin[0] - triangles.a[0][i], ray.origin[1] - triangles.a[1][i], ray.origin[2] - triangles.a[2][i]};
+  float q[3] = {s[1] * *e1[2] - s[2] * *e1[1],
+                s[2] * *e1[0] - s[0] * *e1[2],
+                s[0] * *e1[1] - s[1] * *e1[0]};
+  float inverse_det = 1.0f / det;
+  u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * inverse_det;
+  v = (ray.direction[0] * q[0] + ray.direction[1] * q[1] + ray.direction[2] * q[2]) * inverse_det;
+  t = (*e2[0] * q[0] + *e2[1] * q[1] + *e2[2] * q[2]) * inverse_det;
+  return u >= 0.0f && v >= 0.0f && u + v <= 1.0f;
+}
+
+#if !defined(__SSE2__)
+bool closest_hit_scalar(const Triangle_Arrays & triangles, const Ray3df & ray, size_t first, size_t end, float tmin, float & tmax, size_t & index) {
+  bool hit = false;
+  for (size_t i = first; i < end; i++) {
+    float t, u, v;
+    if (moeller_trumbore(triangles, i, ray, t, u, v) && t > tmin && t < tmax) {
+      tmax = t;
+      index = i;
+      hit = true;
+    }
+  }
+  return hit;
+}
+#endif
+
+// visits the lanes set in mask in ascending order and keeps the smallest t below tmax
+inline bool closest_lane(unsigned mask, const float t[], size_t i, float & tmax, size_t & index) {
+  bool hit = false;
+  while (mask != 0) {
+    unsigned lane = static_cast<unsigned>(__builtin_ctz(mask));
+    mask &= mask - 1;
+    if (t[lane] < tmax) {
+      tmax = t[lane];
+      index = i + lane;
+      hit = true;
+    }
+  }
+  return hit;
+}
+
+// the mask of the lanes i, ..., i + width - 1 which lie before end
+inline unsigned lanes_before(size_t i, size_t end, size_t width) {
+  return end - i >= width ? (1u << width) - 1u : (1u << (end - i)) - 1u;
+}
+
+#if defined(__SSE2__)
+bool closest_hit_sse(const Triangle_Arrays & triangles, const Ray3df & ray, size_t first, size_t end, float tmin, float & tmax, size_t & index) {
+  const __m128 zero = _mm_setzero_ps(),
+               one = _mm_set1_ps(1.0f),
+               epsilon = _mm_set1_ps(EPSILON),
+               sign = _mm_set1_ps(-0.0f);
+  const __m128 ox = _mm_set1_ps(ray.origin[0]), oy = _mm_set1_ps(ray.origin[1]), oz = _mm_set1_ps(ray.origin[2]),
+               dx = _mm_set1_ps(ray.direction[0]), dy = _mm_set1_ps(ray.direction[1]), dz = _mm_set1_ps(ray.direction[2]);
+  alignas(16) float t[4];
+  bool hit = false;
+
+  for (size_t i = first; i < end; i += 4) {
+    __m128 e1x = _mm_loadu_ps(triangles.edge1[0] + i), e1y = _mm_loadu_ps(triangles.edge1[1] + i), e1z = _mm_loadu_ps(triangles.edge1[2] + i),
+           e2x = _mm_loadu_ps(triangles.edge2[0] + i), e2y = _mm_loadu_ps(triangles.edge2[1] + i), e2z = _mm_loadu_ps(triangles.edge2[2] + i);
+    __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y)),
+           py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z)),
+           pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+    __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+    __m128 sx = _mm_sub_ps(ox, _mm_loadu_ps(triangles.a[0] + i)),
+           sy = _mm_sub_ps(oy, _mm_loadu_ps(triangles.a[1] + i)),
+           sz = _mm_sub_ps(oz, _mm_loadu_ps(triangles.a[2] + i));
+    __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y)),
+           qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z)),
+           qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+    __m128 inverse_det = _mm_div_ps(one, det);
+    __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), inverse_det),
+           v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), inverse_det),
+           tv = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inverse_det);
+    __m128 valid = _mm_and_ps(_mm_cmpge_ps(_mm_andnot_ps(sign, det), epsilon),
+                   _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmpge_ps(v, zero)),
+                   _mm_and_ps(_mm_cmple_ps(_mm_add_ps(u, v), one),
+                   _mm_and_ps(_mm_cmpgt_ps(tv, _mm_set1_ps(tmin)), _mm_cmplt_ps(tv, _mm_set1_ps(tmax))))));
+    unsigned mask = static_cast<unsigned>(_mm_movemask_ps(valid)) & lanes_before(i, end, 4u);
+    if (mask != 0) {
+      _mm_store_ps(t, tv);
+      hit |= closest_lane(mask, t, i, tmax, index);
+    }
+  }
+  return hit;
+}
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+AVX2_FUNCTION
+bool closest_hit_avx2(const Triangle_Arrays & triangles, const Ray3df & ray, size_t first, size_t end, float tmin, float & tmax, size_t & index) {
+  const __m256 zero = _mm256_setzero_ps(),
+               one = _mm256_set1_ps(1.0f),
+               epsilon = _mm256_set1_ps(EPSILON),
+               sign = _mm256_set1_ps(-0.0f);
+  const __m256 ox = _mm256_set1_ps(ray.origin[0]), oy = _mm256_set1_ps(ray.origin[1]), oz = _mm256_set1_ps(ray.origin[2]),
+               dx = _mm256_set1_ps(ray.direction[0]), dy = _mm256_set1_ps(ray.direction[1]), dz = _mm256_set1_ps(ray.direction[2]);
+  alignas(32) float t[8];
+  bool hit = false;
+
+  for (size_t i = first; i < end; i += 8) {
+    __m256 e1x = _mm256_loadu_ps(triangles.edge1[0] + i), e1y = _mm256_loadu_ps(triangles.edge1[1] + i), e1z = _mm256_loadu_ps(triangles.edge1[2] + i),
+           e2x = _mm256_loadu_ps(triangles.edge2[0] + i), e2y = _mm256_loadu_ps(triangles.edge2[1] + i), e2z = _mm256_loadu_ps(triangles.edge2[2] + i);
+    __m256 px = _mm256_sub_ps(_mm256_mul_ps(dy, e2z), _mm256_mul_ps(dz, e2y)),
+           py = _mm256_sub_ps(_mm256_mul_ps(dz, e2x), _mm256_mul_ps(dx, e2z)),
+           pz = _mm256_sub_ps(_mm256_mul_ps(dx, e2y), _mm256_mul_ps(dy, e2x));
+    __m256 det = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e1x, px), _mm256_mul_ps(e1y, py)), _mm256_mul_ps(e1z, pz));
+    __m256 sx = _mm256_sub_ps(ox, _mm256_loadu_ps(triangles.a[0] + i)),
+           sy = _mm256_sub_ps(oy, _mm256_loadu_ps(triangles.a[1] + i)),
+           sz = _mm256_sub_ps(oz, _mm256_loadu_ps(triangles.a[2] + i));
+    __m256 qx = _mm256_sub_ps(_mm256_mul_ps(sy, e1z), _mm256_mul_ps(sz, e1y)),
+           qy = _mm256_sub_ps(_mm256_mul_ps(sz, e1x), _mm256_mul_ps(sx, e1z)),
+           qz = _mm256_sub_ps(_mm256_mul_ps(sx, e1y), _mm256_mul_ps(sy, e1x));
+    __m256 inverse_det = _mm256_div_ps(one, det);
+    __m256 u = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(sx, px), _mm256_mul_ps(sy, py)), _mm256_mul_ps(sz, pz)), inverse_det),
+           v = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, qx), _mm256_mul_ps(dy, qy)), _mm256_mul_ps(dz, qz)), inverse_det),
+           tv = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e2x, qx), _mm256_mul_ps(e2y, qy)), _mm256_mul_ps(e2z, qz)), inverse_det);
+    __m256 valid = _mm256_and_ps(_mm256_cmp_ps(_mm256_andnot_ps(sign, det), epsilon, _CMP_GE_OQ),
+                   _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(u, zero, _CMP_GE_OQ), _mm256_cmp_ps(v, zero, _CMP_GE_OQ)),
+                   _mm256_and_ps(_mm256_cmp_ps(_mm256_add_ps(u, v), one, _CMP_LE_OQ),
+                   _mm256_and_ps(_mm256_cmp_ps(tv, _mm256_set1_ps(tmin), _CMP_GT_OQ), _mm256_cmp_ps(tv, _mm256_set1_ps(tmax), _CMP_LT_OQ)))));
+    unsigned mask = static_cast<unsigned>(_mm256_movemask_ps(valid)) & lanes_before(i, end, 8u);
+    if (mask != 0) {
+      _mm256_store_ps(t, tv);
+      hit |= closest_lane(mask, t, i, tmax, index);
+    }
+  }
+  return hit;
+}
+#endif
+
+}
+
+TriangleSoA::TriangleSoA(const std::vector<Triangle3df> & triangles) {
+  for (const Triangle3df & triangle : triangles) {
+    push_back(triangle);
+  }
+}
+
+void TriangleSoA::push_back(const Triangle3df & triangle) {
+  Vector3df b_a = triangle.get_b() - triangle.get_a(),
+            c_a = triangle.get_c() - triangle.get_a();
+  for (size_t k = 0; k < 3; k++) {
+    a[k].resize(count);
+    edge1[k].resize(count);
+    edge2[k].resize(count);
+    a[k].push_back(triangle.get_a()[k]);
+    edge1[k].push_back(b_a[k]);
+    edge2[k].push_back(c_a[k]);
+  }
+  count++;
+  pad();
+}
+
+void TriangleSoA::pad() {
+  // zero edges give det = 0, i.e. the padding is never hit
+  for (size_t k = 0; k < 3; k++) {
+    a[k].resize(count + WIDTH - 1, 0.0f);
+    edge1[k].resize(count + WIDTH - 1, 0.0f);
+    edge2[k].resize(count + WIDTH - 1, 0.0f);
+  }
+}
+
+void TriangleSoA::clear() {
+  for (size_t k = 0; k < 3; k++) {
+    a[k].clear();
+    edge1[k].clear();
+    edge2[k].clear();
+  }
+  count = 0;
+}
+
+Triangle3df TriangleSoA::operator[](size_t i) const {
+  Vector3df first = {a[0][i], a[1][i], a[2][i]},
+            b_a = {edge1[0][i], edge1[1][i], edge1[2][i]},
+            c_a = {edge2[0][i], edge2[1][i], edge2[2][i]};
+  return Triangle3df(first, first + b_a, first + c_a);
+}
+
+bool TriangleSoA::closest_hit(const Ray3df & ray, size_t first, size_t count, float tmin, float & tmax, size_t & index) const {
+  Triangle_Arrays triangles = {{a[0].data(), a[1].data(), a[2].data()},
+                               {edge1[0].data(), edge1[1].data(), edge1[2].data()},
+                               {edge2[0].data(), edge2[1].data(), edge2[2].data()}};
+#if defined(__x86_64__) || defined(__i386__)
+  if (has_avx2()) {
+    return closest_hit_avx2(triangles, ray, first, first + count, tmin, tmax, index);
+  }
+#endif
+#if defined(__SSE2__)
+  return closest_hit_sse(triangles, ray, first, first + count, tmin, tmax, index);
+#else
+  return closest_hit_scalar(triangles, ray, first, first + count, tmin, tmax, index);
+#endif
+}
+
+bool TriangleSoA::any_hit(const Ray3df & ray, size_t first, size_t count, float tmin, float tmax) const {
+  size_t index;
+  return closest_hit(ray, first, count, tmin, tmax, index);
+}
+
+bool TriangleSoA::intersects(const Ray3df & ray, size_t i, Intersection_Context<float, 3u> & context) const {
+  Triangle_Arrays triangles = {{a[0].data(), a[1].data(), a[2].data()},
+                               {edge1[0].data(), edge1[1].data(), edge1[2].data()},
+                               {edge2[0].data(), edge2[1].data(), edge2[2].data()}};
+  float t, u, v;
+  if (!moeller_trumbore(triangles, i, ray, t, u, v) || t < 0.0f) {
+    return false;
+  }
+  finalize(ray, i, t, context);
+  return true;
+}
+
+void TriangleSoA::finalize(const Ray3df & ray, size_t i, float t, Intersection_Context<float, 3u> & context) const {
+  Vector3df e1 = {edge1[0][i], edge1[1][i], edge1[2][i]},
+            e2 = {edge2[0][i], edge2[1][i], edge2[2][i]};
+  Vector3df normal = cross(e1, e2);
+  context.t = t;
+  context.intersection = ray.origin + t * ray.direction;
+
+  // the weights of b and c solve intersection - a = weight_b * e1 + weight_c * e2 (cramer's rule), i.e. the signed
+  // areas of the sub-triangles opposite to b and c relative to the area of the triangle
+  Vector3df d = context.intersection - Vector3df{a[0][i], a[1][i], a[2][i]};
+  float inverse_area = 1.0f / (normal * normal),
+        weight_b = (cross(d, e2) * normal) * inverse_area,
+        weight_c = (cross(e1, d) * normal) * inverse_area;
+  context.u = 1.0f - weight_b - weight_c;
+  context.v = weight_b;
+
+  normal.normalize();
+  if (normal * ray.direction > 0.0f) {
+    normal = -1.0f * normal;  // the ray hits the back side
+  }
+  context.normal = normal;
+}
@@ -0,0 +1,61 @@
+#ifndef TRIANGLE_SOA_H
+#define TRIANGLE_SOA_H
+
+#include "geometry.h"
+#include "simd.h"
+#include <cstddef>
+#include <vector>
+
+// contains triangles baked into an intersection-ready structure of arrays, which are intersected with a ray
+// 8 (AVX2) or 4 (SSE) at a time by the Möller–Trumbore algorithm
+
+
+// triangles with float coordinates in 3d, each stored as its first point a and the edges b - a and c - a,
+// so that the intersection tests need neither cross products of the points nor square roots
+// the arrays are 32 byte aligned and padded with WIDTH - 1 degenerate triangles that are never hit
+class TriangleSoA {
+public:
+  static constexpr size_t WIDTH = 8u;
+
+  TriangleSoA() = default;
+
+  explicit TriangleSoA(const std::vector<Triangle3df> & triangles);
+
+  void push_back(const Triangle3df & triangle);
+
+  void clear();
+
+  size_t size() const { return count; }
+
+  bool empty() const { return count == 0; }
+
+  // returns the i-th triangle
+  Triangle3df operator[](size_t i) const;
+
+  // intersects the ray with the triangles first, ..., first + count - 1 (both sides)
+  // finds the triangle with the smallest t, tmin < t < tmax
+  // returns false if there is none, otherwise sets tmax to its t and index to its index
+  bool closest_hit(const Ray3df & ray, size_t first, size_t count, float tmin, float & tmax, size_t & index) const;
+
+  // returns true iff one of the triangles first, ..., first + count - 1 is hit at some tmin < t < tmax
+  bool any_hit(const Ray3df & ray, size_t first, size_t count, float tmin, float tmax) const;
+
+  // intersects the ray with the i-th triangle at t >= 0, e.g. the one found by closest_hit
+  // the context is set by finalize
+  bool intersects(const Ray3df & ray, size_t i, Intersection_Context<float, 3u> & context) const;
+
+  // sets context for shading the hit of the i-th triangle at t found by closest_hit: context.t, the intersection
+  // point, the unit normal of the triangle's plane facing the ray origin (one square root) and the barycentric
+  // coordinates u and v of the intersection like Triangle::finalize (the weights of a and b)
+  void finalize(const Ray3df & ray, size_t i, float t, Intersection_Context<float, 3u> & context) const;
+
+private:
+  typedef std::vector<float, Aligned_Allocator<float, 32u>> Array;
+
+  void pad();
+
+  Array a[3], edge1[3], edge2[3];  // edge1 = b - a, edge2 = c - a
+  size_t count = 0;
+};
+
+#endif
@@ -0,0 +1,73 @@
+#include "triangle_soa.h"
+#include "benchmark/benchmark.h"
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace {
+
+// random triangles in planes z = const in front of the camera, Triangle::intersects handles those exactly
+std::vector<Triangle3df> random_triangles(size_t count) {
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<float> position(-20.f, 20.f), depth(-60.f, -20.f), size(-2.f, 2.f);
+  std::vector<Triangle3df> triangles;
+  for (size_t i = 0; i < count; i++) {
+    Vector3df a = {position(generator), position(generator), depth(generator)};
+    triangles.push_back(Triangle3df(a, a + Vector3df{size(generator), size(generator), 0.f},
+                                    a + Vector3df{size(generator), size(generator), 0.f}));
+  }
+  return triangles;
+}
+
+std::vector<Ray3df> random_rays() {
+  std::mt19937 generator(7);
+  std::uniform_real_distribution<float> direction(-0.5f, 0.5f);
+  std::vector<Ray3df> rays;
+  for (int i = 0; i < 1024; i++) {
+    rays.push_back(Ray3df{{0.f, 0.f, 0.f}, {direction(generator), direction(generator), -1.f}});
+  }
+  return rays;
+}
+
+// one ray against all triangles via Triangle::intersects, items are triangle tests
+void BM_TrianglesScalar(benchmark::State & state) {
+  std::vector<Triangle3df> triangles = random_triangles(static_cast<size_t>(state.range(0)));
+  std::vector<Ray3df> rays = random_rays();
+  Intersection_Context<float, 3u> context;
+  size_t r = 0;
+  for (auto _ : state) {
+    const Ray3df & ray = rays[r++ & 1023u];
+    float tmax = std::numeric_limits<float>::max();
+    size_t index = triangles.size();
+    for (size_t i = 0; i < triangles.size(); i++) {
+      if (triangles[i].intersects(ray, context) && context.t < tmax) {
+        tmax = context.t;
+        index = i;
+      }
+    }
+    benchmark::DoNotOptimize(index);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_TrianglesScalar)->RangeMultiplier(4)->Range(4, 1024);
+
+// the same with the baked triangles and the SIMD kernel, plus the hit context of the closest triangle
+void BM_TrianglesSoA(benchmark::State & state) {
+  TriangleSoA triangles(random_triangles(static_cast<size_t>(state.range(0))));
+  std::vector<Ray3df> rays = random_rays();
+  Intersection_Context<float, 3u> context;
+  size_t r = 0;
+  for (auto _ : state) {
+    const Ray3df & ray = rays[r++ & 1023u];
+    float tmax = std::numeric_limits<float>::max();
+    size_t index = triangles.size();
+    if (triangles.closest_hit(ray, 0, triangles.size(), 0.f, tmax, index)) {
+      benchmark::DoNotOptimize(triangles.intersects(ray, index, context));
+    }
+    benchmark::DoNotOptimize(index);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_TrianglesSoA)->RangeMultiplier(4)->Range(4, 1024);
+
+}
@@ -0,0 +1,159 @@
+#include "triangle_soa.h"
+#include "gtest/gtest.h"
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace {
+
+// random triangles lying in planes z = const, x = const or y = const
+std::vector<Triangle3df> random_axis_aligned_triangles(size_t count, unsigned seed) {
+  std::mt19937 generator(seed);
+  std::uniform_real_distribution<float> position(-10.f, 10.f);
+  std::vector<Triangle3df> triangles;
+  for (size_t i = 0; i < count; i++) {
+    size_t axis = i % 3;
+    float plane = position(generator);
+    Vector3df points[3] = {Vector3df{}, Vector3df{}, Vector3df{}};
+    for (Vector3df & point : points) {
+      point = {position(generator), position(generator), position(generator)};
+      point[axis] = plane;
+    }
+    triangles.push_back(Triangle3df(points[0], points[1], points[2]));
+  }
+  return triangles;
+}
+
+TEST(TRIANGLE_SOA, StoresTriangles) {
+  std::vector<Triangle3df> triangles = random_axis_aligned_triangles(11, 1);
+  TriangleSoA soa(triangles);
+
+  ASSERT_EQ(11u, soa.size());
+  for (size_t i = 0; i < triangles.size(); i++) {
+    for (size_t k = 0; k < 3; k++) {
+      EXPECT_EQ(triangles[i].get_a()[k], soa[i].get_a()[k]);
+      EXPECT_NEAR(triangles[i].get_b()[k], soa[i].get_b()[k], 0.00001);
+      EXPECT_NEAR(triangles[i].get_c()[k], soa[i].get_c()[k], 0.00001);
+    }
+  }
+  soa.clear();
+  EXPECT_TRUE(soa.empty());
+}
+
+TEST(TRIANGLE_SOA, ClosestHitMatchesTriangleIntersects) {
+  std::vector<Triangle3df> triangles = random_axis_aligned_triangles(45, 2);
+  TriangleSoA soa(triangles);
+  std::mt19937 generator(3);
+  std::uniform_real_distribution<float> position(-10.f, 10.f), direction(-1.f, 1.f);
+  std::uniform_int_distribution<size_t> offset(0, triangles.size());
+  size_t hits = 0;
+
+  for (int r = 0; r < 2000; r++) {
+    Ray3df ray = { {position(generator), position(generator), position(generator)},
+                   {direction(generator), direction(generator), direction(generator)} };
+    size_t first = offset(generator),
+           end = offset(generator);
+    if (first > end) {
+      std::swap(first, end);
+    }
+    Intersection_Context<float, 3u> context, expected_context;
+    expected_context.t = std::numeric_limits<float>::max();
+    size_t expected = end;
+    for (size_t i = first; i < end; i++) {
+      if (triangles[i].intersects(ray, context) && context.t > 0.f && context.t < expected_context.t) {
+        expected_context = context;
+        expected = i;
+      }
+    }
+
+    float t = std::numeric_limits<float>::max();
+    size_t index = end;
+    EXPECT_EQ(expected != end, soa.closest_hit(ray, first, end - first, 0.f, t, index));
+    EXPECT_EQ(expected != end, soa.any_hit(ray, first, end - first, 0.f, std::numeric_limits<float>::max()));
+    EXPECT_EQ(expected, index);
+    if (expected == end || index != expected) {
+      continue;
+    }
+    hits++;
+    ASSERT_TRUE(soa.intersects(ray, index, context));
+    EXPECT_NEAR(expected_context.t, t, 0.0001f * t);
+    EXPECT_NEAR(expected_context.t, context.t, 0.0001f * t);
+    EXPECT_NEAR(expected_context.u, context.u, 0.001);
+    EXPECT_NEAR(expected_context.v, context.v, 0.001);
+    for (size_t k = 0; k < 3; k++) {
+      EXPECT_NEAR(expected_context.intersection[k], context.intersection[k], 0.001);
+    }
+    // the unit normal of the triangle's plane facing the ray, Triangle's normal is neither normalized nor turned
+    // towards the ray (the triangles are axis aligned, so it is parallel)
+    Vector3df normal = expected_context.normal;
+    normal.normalize();
+    EXPECT_NEAR(1.0, std::fabs(normal * context.normal), 0.0001);
+    EXPECT_LE(context.normal * ray.direction, 0.f);
+  }
+  EXPECT_GT(hits, 100u);
+}
+
+TEST(TRIANGLE_SOA, BarycentricCoordinates) {
+  // the same triangle and ray as TRIANGLE.Intersects3dfWithRay_1, the ray hits the first point
+  TriangleSoA soa(std::vector<Triangle3df>{ Triangle3df({0.0, 0.0, 0.0}, {0.0, 3.0, 0.0}, {3.0, 0.0, 0.0}) });
+  Ray3df ray{ {0.0, 0.0, 2.0}, {0.0, 0.0, -1.0} };
+  Intersection_Context<float, 3u> context;
+
+  ASSERT_TRUE(soa.intersects(ray, 0, context));
+  EXPECT_NEAR(2.0, context.t, 0.000001);
+  EXPECT_NEAR(1.0, context.u, 0.000001);
+  EXPECT_NEAR(0.0, context.v, 0.000001);
+
+  ray.origin = {1.0, 1.0, 2.0};
+  ASSERT_TRUE(soa.intersects(ray, 0, context));
+  EXPECT_NEAR(1.0 / 3.0, context.u, 0.000001);
+  EXPECT_NEAR(1.0 / 3.0, context.v, 0.000001);
+}
+
+TEST(TRIANGLE_SOA, RespectsTmaxAndParallelRays) {
+  TriangleSoA soa(std::vector<Triangle3df>{ Triangle3df({-1.0, -1.0, -5.0}, {1.0, -1.0, -5.0}, {0.0, 1.0, -5.0}) });
+  Ray3df ray{ {0.0, 0.0, 0.0}, {0.0, 0.0, -1.0} };
+  float t = 4.f;
+  size_t index = 1;
+
+  EXPECT_FALSE(soa.closest_hit(ray, 0, 1, 0.f, t, index));
+  EXPECT_TRUE(soa.any_hit(ray, 0, 1, 0.f, 6.f));
+  EXPECT_FALSE(soa.any_hit(Ray3df{ {0.0, 0.0, -5.0}, {1.0, 0.0, 0.0} }, 0, 1, 0.f, 100.f));
+  EXPECT_FALSE(soa.any_hit(Ray3df{ {0.0, 0.0, 0.0}, {0.0, 0.0, 1.0} }, 0, 1, 0.f, 100.f));
+}
+
+TEST(TRIANGLE_SOA, RespectsTminAndFinalizes) {
+  // a slanted triangle, its normal has components on all axes
+  TriangleSoA soa(std::vector<Triangle3df>{ Triangle3df({-1.0, -1.0, -5.0}, {1.0, -1.0, -4.0}, {0.0, 1.0, -6.0}) });
+  Ray3df ray{ {0.0, 0.0, 0.0}, {0.0, 0.0, -1.0} };
+  float t = 100.f;
+  size_t index = 1;
+
+  ASSERT_TRUE(soa.closest_hit(ray, 0, 1, 0.f, t, index));
+  EXPECT_EQ(0u, index);
+  EXPECT_FALSE(soa.any_hit(ray, 0, 1, t + 0.01f, 100.f));
+
+  Intersection_Context<float, 3u> context;
+  soa.finalize(ray, 0, t, context);
+  EXPECT_EQ(t, context.t);
+  EXPECT_NEAR(1.0, context.normal.length(), 0.00001);
+  EXPECT_GT(context.normal[2], 0.f);
+  Vector3df edge1 = Vector3df{2.0f, 0.0f, 1.0f},
+            edge2 = Vector3df{1.0f, 2.0f, -1.0f};
+  EXPECT_NEAR(0.0, context.normal * edge1, 0.00001);
+  EXPECT_NEAR(0.0, context.normal * edge2, 0.00001);
+
+  // the hit point is the weighted sum of the points
+  Vector3df point = context.u * Vector3df{-1.0f, -1.0f, -5.0f} + context.v * Vector3df{1.0f, -1.0f, -4.0f}
+                    + (1.0f - context.u - context.v) * Vector3df{0.0f, 1.0f, -6.0f};
+  for (size_t k = 0; k < 3; k++) {
+    EXPECT_NEAR(context.intersection[k], point[k], 0.00001);
+  }
+  Intersection_Context<float, 3u> expected;
+  ASSERT_TRUE(soa.intersects(ray, 0, expected));
+  EXPECT_NEAR(expected.u, context.u, 0.00001);
+  EXPECT_NEAR(expected.v, context.v, 0.00001);
+}
+
+}
@@ -0,0 +1,194 @@
+#include "wavefront.h"
+#include <algorithm>
+#include <utility>
+
+void Path_Queue::resize(size_t size) {
+  for (size_t k = 0; k < 3; k++) {
+    origin[k].resize(size);
+    direction[k].resize(size);
+  }
+  tmin.resize(size);
+  throughput.resize(size);
+  x.resize(size);
+  y.resize(size);
+  random_state.resize(size);
+}
+
+void Path_Queue::push_back(const Ray_Query3df & query, float path_throughput, int pixel_x, int pixel_y, uint32_t state) {
+  for (size_t k = 0; k < 3; k++) {
+    origin[k].push_back(query.ray.origin[k]);
+    direction[k].push_back(query.ray.direction[k]);
+  }
+  tmin.push_back(query.tmin);
+  throughput.push_back(path_throughput);
+  x.push_back(pixel_x);
+  y.push_back(pixel_y);
+  random_state.push_back(state);
+}
+
+void Path_Queue::assign(size_t i, size_t j) {
+  for (size_t k = 0; k < 3; k++) {
+    origin[k][i] = origin[k][j];
+    direction[k][i] = direction[k][j];
+  }
+  tmin[i] = tmin[j];
+  throughput[i] = throughput[j];
+  x[i] = x[j];
+  y[i] = y[j];
+  random_state[i] = random_state[j];
+}
+
+Ray3df Path_Queue::ray(size_t i) const {
+  return Ray3df{{origin[0][i], origin[1][i], origin[2][i]}, {direction[0][i], direction[1][i], direction[2][i]}};
+}
+
+Ray_Query3df Path_Queue::query(size_t i) const {
+  return Ray_Query3df(ray(i), tmin[i]);
+}
+
+void wavefront_generate(const Camera & camera, const Tile & tile, Path_Queue & paths) {
+  Ray_Batch batch;
+  for (int j = tile.y0; j < tile.y1; ++j) {
+    for (int i = tile.x0; i < tile.x1; i += static_cast<int>(Ray_Batch::WIDTH)) {
+      size_t count = std::min(Ray_Batch::WIDTH, static_cast<size_t>(tile.x1 - i));
+      camera.rays(i, j, count, batch);
+      for (size_t lane = 0; lane < count; lane++) {
+        int x = i + static_cast<int>(lane);
+        Ray3df ray = {camera.eye(), {batch.direction[0][lane], batch.direction[1][lane], batch.direction[2][lane]}};
+        paths.push_back(ray, 1.f, x, j, pixel_random_state(x, j));
+      }
+    }
+  }
+}
+
+void wavefront_terminate(Path_Queue & paths, int depth, const Path_Termination & termination, Framebuffer & framebuffer,
+                         Path_Statistics & statistics) {
+  size_t kept = 0;
+  for (size_t i = 0; i < paths.size(); i++) {
+    if (continue_path(paths.throughput[i], depth, termination, paths.random_state[i], statistics)) {
+      paths.assign(kept++, i);
+    } else {
+      framebuffer.set_pixel(paths.x[i], paths.y[i], Vector3df{0.f, 0.f, 0.f});
+    }
+  }
+  paths.resize(kept);
+}
+
+void wavefront_extend(const worldObjects & world, const Path_Queue & paths, Hit_Queue & hits, Packet_Statistics * statistics) {
+  size_t size = paths.size();
+  hits.records.resize(size);
+  hits.hit.assign(size, 0);
+  Ray_Packet packet;
+  for (size_t first = 0; first < size; first += Ray_Packet::WIDTH) {
+    size_t count = std::min(Ray_Packet::WIDTH, size - first);
+    packet.active = 0;
+    for (size_t lane = 0; lane < count; lane++) {
+      packet.set(lane, paths.query(first + lane));
+    }
+    unsigned hit = world.closest_hit(packet, &hits.records[first], statistics);
+    for (; hit != 0; hit &= hit - 1) {
+      hits.hit[first + static_cast<size_t>(__builtin_ctz(hit))] = 1;
+    }
+  }
+}
+
+void wavefront_shadow(const worldObjects & world, const Path_Queue & paths, Hit_Queue & hits, Packet_Statistics * statistics) {
+  size_t size = paths.size();
+  hits.occluded.assign(size, 0);
+  Ray_Packet packet;
+  for (size_t first = 0; first < size; first += Ray_Packet::WIDTH) {
+    size_t count = std::min(Ray_Packet::WIDTH, size - first);
+    packet.active = 0;
+    for (size_t lane = 0; lane < count; lane++) {
+      if (hits.hit[first + lane]) {
+        packet.set(lane, shadow_ray(world, hits.records[first + lane].context));
+      }
+    }
+    if (packet.active == 0) {
+      continue;
+    }
+    unsigned occluded = world.occluded(packet, statistics);
+    for (; occluded != 0; occluded &= occluded - 1) {
+      hits.occluded[first + static_cast<size_t>(__builtin_ctz(occluded))] = 1;
+    }
+  }
+}
+
+void wavefront_shade(const worldObjects & world, const Path_Queue & paths, const Hit_Queue & hits, Path_Queue & next,
+                     Framebuffer & framebuffer) {
+  for (size_t i = 0; i < paths.size(); i++) {
+    if (!hits.hit[i]) {
+      framebuffer.set_pixel(paths.x[i], paths.y[i], Vector3df{0.f, 0.f, 0.f});
+      continue;
+    }
+    const Intersection_Context<float, 3u> & rec = hits.records[i].context;
+    float intensity = light_intensity(rec, shadow_ray(world, rec).ray, hits.occluded[i] != 0);
+    if (!world.reflective(hits.records[i])) {
+      framebuffer.set_pixel(paths.x[i], paths.y[i], (paths.throughput[i] * intensity) * world.color(hits.records[i]));
+      continue;
+    }
+    next.push_back(reflected_ray(paths.ray(i), rec), paths.throughput[i] * intensity, paths.x[i], paths.y[i],
+                   paths.random_state[i]);
+  }
+}
+
+namespace {
+
+// returns the octant of the direction of path i, bit k is set if the direction is negative on axis k
+inline unsigned octant(const Path_Queue & paths, size_t i) {
+  return static_cast<unsigned>(paths.direction[0][i] < 0.f)
+       | static_cast<unsigned>(paths.direction[1][i] < 0.f) << 1
+       | static_cast<unsigned>(paths.direction[2][i] < 0.f) << 2;
+}
+
+}
+
+void group_by_direction(Path_Queue & paths, Path_Queue & scratch) {
+  size_t start[9] = {};
+  for (size_t i = 0; i < paths.size(); i++) {
+    start[octant(paths, i) + 1]++;
+  }
+  for (size_t o = 1; o < 9; o++) {
+    start[o] += start[o - 1];
+  }
+  scratch.resize(paths.size());
+  for (size_t i = 0; i < paths.size(); i++) {
+    size_t j = start[octant(paths, i)]++;
+    for (size_t k = 0; k < 3; k++) {
+      scratch.origin[k][j] = paths.origin[k][i];
+      scratch.direction[k][j] = paths.direction[k][i];
+    }
+    scratch.tmin[j] = paths.tmin[i];
+    scratch.throughput[j] = paths.throughput[i];
+    scratch.x[j] = paths.x[i];
+    scratch.y[j] = paths.y[i];
+    scratch.random_state[j] = paths.random_state[i];
+  }
+  std::swap(paths, scratch);
+}
+
+void render_tile_wavefront(const worldObjects & world, const Camera & camera, const Tile & tile, Framebuffer & framebuffer,
+                           int depth, const Path_Termination & termination, Path_Statistics * statistics,
+                           Packet_Statistics * packets) {
+  Path_Queue paths, next, scratch;
+  Hit_Queue hits;
+  Path_Statistics tile_statistics;
+  wavefront_generate(camera, tile, paths);
+
+  for (; depth > 0 && paths.size() > 0; depth--) {
+    wavefront_terminate(paths, depth, termination, framebuffer, tile_statistics);
+    tile_statistics.bounces += paths.size();
+    wavefront_extend(world, paths, hits, packets);
+    wavefront_shadow(world, paths, hits, packets);
+    next.clear();
+    wavefront_shade(world, paths, hits, next, framebuffer);
+    group_by_direction(next, scratch);
+    std::swap(paths, next);
+  }
+  for (size_t i = 0; i < paths.size(); i++) {
+    framebuffer.set_pixel(paths.x[i], paths.y[i], Vector3df{0.f, 0.f, 0.f});
+  }
+  if (statistics) {
+    *statistics += tile_statistics;
+  }
+}
@@ -0,0 +1,86 @@
+#ifndef WAVEFRONT_H
+#define WAVEFRONT_H
+
+#include "scene.h"
+#include "camera.h"
+#include "framebuffer.h"
+#include "ray_packet.h"
+#include "renderer.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// contains the wavefront renderer: instead of following the path of one pixel after the other (ray_color), the paths
+// of all pixels of a tile are followed bounce by bounce, every bounce runs the stages
+//   terminate (path termination), extend (closest hits), shadow (occlusion of the light) and shade (colors and
+//   reflected rays)
+// over queues of paths, so that every stage is one loop over many rays and neighbouring rays are traced as packets
+// the stages are the functions wavefront_<stage>
+
+
+// the paths still followed, stored as structure of arrays
+struct Path_Queue {
+  std::vector<float> origin[3],     // origin[axis][path], the ray of the next bounce
+                     direction[3],
+                     tmin,          // its hits are searched at tmin < t
+                     throughput;    // the product of the intensities of the reflective surfaces hit so far
+  std::vector<int> x, y;            // the pixel of the path
+  std::vector<uint32_t> random_state;
+
+  size_t size() const { return throughput.size(); }
+
+  void clear() { resize(0); }
+
+  void resize(size_t size);
+
+  // appends a path, query.tmax is not kept
+  void push_back(const Ray_Query3df & query, float throughput, int x, int y, uint32_t random_state);
+
+  // sets path i to (a copy of) path j
+  void assign(size_t i, size_t j);
+
+  // returns the ray of path i
+  Ray3df ray(size_t i) const;
+
+  // returns the ray of path i with its interval tmin < t (without upper bound)
+  Ray_Query3df query(size_t i) const;
+};
+
+// the results of wavefront_extend and wavefront_shadow for the paths of a queue, hit[i] tells whether records[i] is valid
+struct Hit_Queue {
+  std::vector<Hit_Record3df> records;
+  std::vector<uint8_t> hit,
+                       occluded;
+};
+
+// wavefront_generate: appends the primary rays of the pixels of the tile, row by row
+void wavefront_generate(const Camera & camera, const Tile & tile, Path_Queue & paths);
+
+// wavefront_terminate: removes the paths that termination cuts off with depth bounces left, their pixels become black
+// the remaining paths keep their order, the terminations are counted in statistics
+void wavefront_terminate(Path_Queue & paths, int depth, const Path_Termination & termination, Framebuffer & framebuffer,
+                         Path_Statistics & statistics);
+
+// wavefront_extend: finds the closest hits of all paths, each 8 consecutive paths are traced as a packet
+void wavefront_extend(const worldObjects & world, const Path_Queue & paths, Hit_Queue & hits, Packet_Statistics * statistics = nullptr);
+
+// wavefront_shadow: tests the shadow rays of all hits of wavefront_extend, as packets like wavefront_extend
+void wavefront_shadow(const worldObjects & world, const Path_Queue & paths, Hit_Queue & hits, Packet_Statistics * statistics = nullptr);
+
+// wavefront_shade: sets the pixels of the paths which hit nothing (black) or a diffuse surface (its shaded color),
+// appends the reflected rays of the paths hitting reflective surfaces to next
+void wavefront_shade(const worldObjects & world, const Path_Queue & paths, const Hit_Queue & hits, Path_Queue & next,
+                     Framebuffer & framebuffer);
+
+// reorders the paths by the signs of their directions (a stable counting sort through scratch), so that the packets
+// of the next wavefront_extend contain rays of the same octant, which are traced together
+void group_by_direction(Path_Queue & paths, Path_Queue & scratch);
+
+// renders a tile like render() does without wavefront, i.e. into the same pixels: wavefront_generate, then the other stages
+// for up to depth bounces, the paths left after depth bounces become black
+// the bounces and terminations are added to statistics and the packets traced to packets, if they are given
+void render_tile_wavefront(const worldObjects & world, const Camera & camera, const Tile & tile, Framebuffer & framebuffer,
+                           int depth, const Path_Termination & termination, Path_Statistics * statistics = nullptr,
+                           Packet_Statistics * packets = nullptr);
+
+#endif
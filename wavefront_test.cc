@@ -0,0 +1,107 @@
+#include "wavefront.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+void expect_same_image(const Framebuffer & expected, const Framebuffer & actual) {
+  for (int y = 0; y < expected.height(); y++) {
+    for (int x = 0; x < expected.width(); x++) {
+      for (size_t k = 0; k < 3; k++) {
+        EXPECT_EQ(expected.get_pixel(x, y)[k], actual.get_pixel(x, y)[k]) << "pixel " << x << ", " << y;
+      }
+    }
+  }
+}
+
+TEST(WAVEFRONT, RenderMatchesRayColor) {
+  Render_Options options;
+  options.threads = 2;
+  options.tile_size = 13;
+  Path_Termination roulette;
+  roulette.roulette_throughput = 0.5f;
+
+  for (BVH_Layout layout : {BVH_Layout::BINARY, BVH_Layout::AUTOMATIC}) {
+    for (worldObjects world : {cornell_box(), sphere_field(300, 42, 0.5f), mixed_field(300, 42, 0.5f)}) {
+      world.build({}, layout);
+      for (const Path_Termination & termination : {Path_Termination(), roulette}) {
+        Framebuffer expected(47, 26), actual(47, 26);
+        Path_Statistics expected_statistics, statistics;
+        render(world, expected, options, 6, termination, &expected_statistics);
+        options.wavefront = true;
+        render(world, actual, options, 6, termination, &statistics);
+        options.wavefront = false;
+
+        expect_same_image(expected, actual);
+        EXPECT_EQ(expected_statistics.bounces, statistics.bounces);
+        EXPECT_EQ(expected_statistics.terminated_by_roulette, statistics.terminated_by_roulette);
+        EXPECT_EQ(expected_statistics.bounces_saved, statistics.bounces_saved);
+      }
+    }
+  }
+}
+
+TEST(WAVEFRONT, ShadeCompactsReflectedPaths) {
+  worldObjects world = sphere_field(200, 7, 0.5f);
+  world.build({}, BVH_Layout::BINARY);
+  Camera camera(40, 24);
+  Framebuffer framebuffer(40, 24);
+  Path_Queue paths, next, scratch;
+  Hit_Queue hits;
+  wavefront_generate(camera, Tile{0, 0, 40, 24}, paths);
+  ASSERT_EQ(40u * 24u, paths.size());
+  EXPECT_EQ(3, paths.x[43]);
+  EXPECT_EQ(1, paths.y[43]);
+
+  wavefront_extend(world, paths, hits);
+  wavefront_shadow(world, paths, hits);
+  wavefront_shade(world, paths, hits, next, framebuffer);
+  size_t reflected = 0;
+  for (size_t i = 0; i < paths.size(); i++) {
+    reflected += hits.hit[i] && world.reflective(hits.records[i]);
+  }
+  EXPECT_GT(reflected, 0u);
+  ASSERT_EQ(reflected, next.size());
+
+  // the reflected paths keep their order and pixel, grouping them by direction keeps every path
+  std::vector<int> pixels;
+  for (size_t i = 0; i < next.size(); i++) {
+    pixels.push_back(next.y[i] * 40 + next.x[i]);
+    if (i > 0) {
+      EXPECT_LT(pixels[i - 1], pixels[i]);
+    }
+  }
+  group_by_direction(next, scratch);
+  ASSERT_EQ(reflected, next.size());
+  unsigned previous = 0;
+  for (size_t i = 0; i < next.size(); i++) {
+    unsigned octant = (next.direction[0][i] < 0.f) | (next.direction[1][i] < 0.f) << 1 | (next.direction[2][i] < 0.f) << 2;
+    EXPECT_LE(previous, octant);
+    previous = octant;
+    EXPECT_NE(pixels.end(), std::find(pixels.begin(), pixels.end(), next.y[i] * 40 + next.x[i]));
+  }
+}
+
+TEST(WAVEFRONT, TerminateCompactsPaths) {
+  Path_Queue paths;
+  Framebuffer framebuffer(4, 1);
+  for (int i = 0; i < 4; i++) {
+    framebuffer.set_pixel(i, 0, Vector3df{1.f, 1.f, 1.f});
+    paths.push_back(Ray3df{{0.f, 0.f, 0.f}, {0.f, 0.f, -1.f}}, i % 2 == 0 ? 1.f : 0.01f, i, 0, 1u);
+  }
+  Path_Termination termination;
+  termination.min_throughput = 0.1f;
+  Path_Statistics statistics;
+  wavefront_terminate(paths, 3, termination, framebuffer, statistics);
+
+  ASSERT_EQ(2u, paths.size());
+  EXPECT_EQ(0, paths.x[0]);
+  EXPECT_EQ(2, paths.x[1]);
+  EXPECT_EQ(2u, statistics.terminated_by_throughput);
+  EXPECT_EQ(6u, statistics.bounces_saved);
+  EXPECT_EQ(1.f, framebuffer.get_pixel(0, 0)[0]);
+  EXPECT_EQ(0.f, framebuffer.get_pixel(1, 0)[0]);
+}
+
+}
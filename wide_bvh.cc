@@ -0,0 +1,180 @@
+#include "wide_bvh.h"
+#include "wide_bvh.tcc"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// an entry of the traversal stack, either a node (count == 0) or the primitive range of a leaf
+struct Stack_Entry {
+  uint32_t child,
+           count;
+  float entry;  // distance at which the ray enters the child's aabb
+};
+
+// tests the aabbs of all children of node against the ray of the query for query.tmin <= t <= tmax
+// the near and far plane of each slab only depend on the sign of the direction, which the query precomputes
+// returns a bit mask of the children hit and sets entry[i] to the distance at which the ray enters child i
+// NaN plane distances (0 * inf for rays parallel to a slab) never narrow the interval
+template <size_t WIDTH>
+inline unsigned intersect_children_scalar(const Wide_BVH_Node<WIDTH> & node, const Ray_Query3df & query, float tmax, float entry[WIDTH]) {
+  unsigned mask = 0;
+  for (size_t i = 0; i < WIDTH; i++) {
+    float tnear = query.tmin,
+          tfar = tmax;
+    for (size_t k = 0; k < 3; k++) {
+      float near = ((query.negative[k] ? node.upper[k][i] : node.lower[k][i]) - query.ray.origin[k]) * query.inverse_direction[k],
+            far = ((query.negative[k] ? node.lower[k][i] : node.upper[k][i]) - query.ray.origin[k]) * query.inverse_direction[k];
+      tnear = near > tnear ? near : tnear;
+      tfar = far < tfar ? far : tfar;
+    }
+    entry[i] = tnear;
+    mask |= static_cast<unsigned>(tnear <= tfar) << i;
+  }
+  return mask;
+}
+
+#if defined(__SSE2__)
+inline unsigned intersect_children(const Wide_BVH_Node<4u> & node, const Ray_Query3df & query, float tmax, float entry[4]) {
+  __m128 tnear = _mm_set1_ps(query.tmin),
+         tfar = _mm_set1_ps(tmax);
+  for (size_t k = 0; k < 3; k++) {
+    __m128 origin = _mm_set1_ps(query.ray.origin[k]),
+           inverse_direction = _mm_set1_ps(query.inverse_direction[k]);
+    __m128 near = _mm_load_ps(query.negative[k] ? node.upper[k] : node.lower[k]),
+           far = _mm_load_ps(query.negative[k] ? node.lower[k] : node.upper[k]);
+    // max/min return their second operand if one is NaN
+    tnear = _mm_max_ps(_mm_mul_ps(_mm_sub_ps(near, origin), inverse_direction), tnear);
+    tfar = _mm_min_ps(_mm_mul_ps(_mm_sub_ps(far, origin), inverse_direction), tfar);
+  }
+  _mm_storeu_ps(entry, tnear);
+  return static_cast<unsigned>(_mm_movemask_ps(_mm_cmple_ps(tnear, tfar)));
+}
+#else
+inline unsigned intersect_children(const Wide_BVH_Node<4u> & node, const Ray_Query3df & query, float tmax, float entry[4]) {
+  return intersect_children_scalar(node, query, tmax, entry);
+}
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+inline unsigned intersect_children(const Wide_BVH_Node<8u> & node, const Ray_Query3df & query, float tmax, float entry[8]) {
+  __m256 tnear = _mm256_set1_ps(query.tmin),
+         tfar = _mm256_set1_ps(tmax);
+  for (size_t k = 0; k < 3; k++) {
+    __m256 origin = _mm256_set1_ps(query.ray.origin[k]),
+           inverse_direction = _mm256_set1_ps(query.inverse_direction[k]);
+    __m256 near = _mm256_load_ps(query.negative[k] ? node.upper[k] : node.lower[k]),
+           far = _mm256_load_ps(query.negative[k] ? node.lower[k] : node.upper[k]);
+    tnear = _mm256_max_ps(_mm256_mul_ps(_mm256_sub_ps(near, origin), inverse_direction), tnear);
+    tfar = _mm256_min_ps(_mm256_mul_ps(_mm256_sub_ps(far, origin), inverse_direction), tfar);
+  }
+  _mm256_storeu_ps(entry, tnear);
+  return static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(tnear, tfar, _CMP_LE_OQ)));
+}
+#else
+inline unsigned intersect_children(const Wide_BVH_Node<8u> & node, const Ray_Query3df & query, float tmax, float entry[8]) {
+  return intersect_children_scalar(node, query, tmax, entry);
+}
+#endif
+
+template <size_t WIDTH, class LEAF_FUNCTION>
+inline bool traverse_closest_hit(const std::vector<Wide_BVH_Node<WIDTH>> & nodes, const Ray_Query3df & query,
+                                 LEAF_FUNCTION leaf, void * context, BVH_Traversal_Statistics * statistics) {
+  float tmax = query.tmax;
+  Stack_Entry stack[BVH3df::MAX_DEPTH * WIDTH];
+  size_t size = 0;
+  stack[size++] = {0u, 0u, query.tmin};
+  float entry[WIDTH];
+  bool hit = false;
+
+  while (size > 0) {
+    Stack_Entry current = stack[--size];
+    if (current.entry > tmax) {
+      continue;  // a closer hit was found after the child had been pushed
+    }
+    if (current.count > 0) {
+      hit |= leaf(context, current.child, current.count, tmax);
+      continue;
+    }
+    if (statistics) {
+      statistics->nodes_visited++;
+    }
+    const Wide_BVH_Node<WIDTH> & node = nodes[current.child];
+    unsigned mask = intersect_children(node, query, tmax, entry);
+
+    // the children hit are pushed sorted by decreasing entry distance, so that the nearest one is visited next
+    size_t first = size;
+    while (mask != 0) {
+      unsigned i = static_cast<unsigned>(__builtin_ctz(mask));
+      mask &= mask - 1;
+      Stack_Entry child = {node.child[i], node.count[i], entry[i]};
+      size_t j = size++;
+      while (j > first && stack[j - 1].entry < child.entry) {
+        stack[j] = stack[j - 1];
+        j--;
+      }
+      stack[j] = child;
+    }
+  }
+  return hit;
+}
+
+template <size_t WIDTH, class LEAF_FUNCTION>
+inline bool traverse_any_hit(const std::vector<Wide_BVH_Node<WIDTH>> & nodes, const Ray_Query3df & query, LEAF_FUNCTION leaf, void * context) {
+  float tmax = query.tmax;
+  Stack_Entry stack[BVH3df::MAX_DEPTH * WIDTH];
+  size_t size = 0;
+  stack[size++] = {0u, 0u, query.tmin};
+  float entry[WIDTH];
+
+  while (size > 0) {
+    Stack_Entry current = stack[--size];
+    if (current.count > 0) {
+      if (leaf(context, current.child, current.count, tmax)) {
+        return true;
+      }
+      continue;
+    }
+    const Wide_BVH_Node<WIDTH> & node = nodes[current.child];
+    unsigned mask = intersect_children(node, query, tmax, entry);
+    while (mask != 0) {
+      unsigned i = static_cast<unsigned>(__builtin_ctz(mask));
+      mask &= mask - 1;
+      stack[size++] = {node.child[i], node.count[i], entry[i]};
+    }
+  }
+  return false;
+}
+
+}
+
+template <>
+bool Wide_BVH<4u>::traverse_closest(const Ray_Query3df & query, Leaf_Function leaf, void * context, BVH_Traversal_Statistics * statistics) const {
+  return !empty() && traverse_closest_hit(nodes, query, leaf, context, statistics);
+}
+
+template <>
+bool Wide_BVH<4u>::traverse_any(const Ray_Query3df & query, Leaf_Function leaf, void * context) const {
+  return !empty() && traverse_any_hit(nodes, query, leaf, context);
+}
+
+template <>
+AVX2_FUNCTION
+bool Wide_BVH<8u>::traverse_closest(const Ray_Query3df & query, Leaf_Function leaf, void * context, BVH_Traversal_Statistics * statistics) const {
+  return !empty() && traverse_closest_hit(nodes, query, leaf, context, statistics);
+}
+
+template <>
+AVX2_FUNCTION
+bool Wide_BVH<8u>::traverse_any(const Ray_Query3df & query, Leaf_Function leaf, void * context) const {
+  return !empty() && traverse_any_hit(nodes, query, leaf, context);
+}
+
+template struct Wide_BVH_Node<4u>;
+template struct Wide_BVH_Node<8u>;
+
+template class Wide_BVH<4u>;
+template class Wide_BVH<8u>;
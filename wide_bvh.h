@@ -0,0 +1,96 @@
+#ifndef WIDE_BVH_H
+#define WIDE_BVH_H
+
+#include "bvh.h"
+#include "simd.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// contains bvhs with 4 or 8 children per node (BVH4, BVH8), the aabbs of all children of a node are
+// tested against a ray with one sequence of SIMD instructions (SSE for BVH4, AVX2 for BVH8)
+
+
+// a node with up to WIDTH children, the children's aabbs are stored as structure of arrays
+template <size_t WIDTH>
+struct alignas(32) Wide_BVH_Node {
+  float lower[3][WIDTH],   // lower[axis][child]
+        upper[3][WIDTH];   // unused children have lower = +inf and upper = -inf and are never hit
+  uint32_t child[WIDTH],   // inner children: index of their node, leaves: position of their first primitive
+           count[WIDTH];   // number of primitives of a leaf child, 0 for inner and unused children
+};
+
+// a bvh with up to WIDTH children per node, collapsed from a binary BVH
+// leaves reference ranges of primitive_order() like the leaves of a Linear_BVH
+template <size_t WIDTH>
+class Wide_BVH {
+public:
+  static_assert(WIDTH == 4u || WIDTH == 8u);
+
+  // returns the SIMD instruction set the child tests need
+  static constexpr SIMD_Level required_simd_level() { return WIDTH == 8u ? SIMD_Level::AVX2 : SIMD_Level::SSE; }
+
+  // creates an empty bvh
+  Wide_BVH() = default;
+
+  // collapses the given binary bvh: the inner child with the largest surface area is replaced by its children
+  // until a node has WIDTH children or only leaves
+  explicit Wide_BVH(const BVH<float, 3u> & bvh);
+
+  bool empty() const { return nodes.empty(); }
+
+  size_t primitive_count() const { return primitives.size(); }
+
+  size_t node_count() const { return nodes.size(); }
+
+  const BVH_Build_Statistics & build_statistics() const { return statistics; }
+
+  const std::vector<Wide_BVH_Node<WIDTH>> & node_array() const { return nodes; }
+
+  // returns the primitive indices (wrt the bounds the bvh was built over) in leaf order
+  const std::vector<size_t> & primitive_order() const { return primitives; }
+
+  // same as Linear_BVH::closest_hit, statistics->nodes_visited counts the visited wide nodes
+  // needs a cpu supporting required_simd_level()
+  template <class INTERSECT>
+  bool closest_hit(const Ray<float, 3u> & ray, float tmax, INTERSECT && intersect, BVH_Traversal_Statistics * statistics = nullptr) const;
+
+  // same as Linear_BVH::any_hit
+  // needs a cpu supporting required_simd_level()
+  template <class OCCLUDES>
+  bool any_hit(const Ray<float, 3u> & ray, float tmax, OCCLUDES && occludes) const;
+
+  // same as Linear_BVH::closest_hit_leaves
+  template <class INTERSECT_LEAF>
+  bool closest_hit_leaves(const Ray<float, 3u> & ray, float tmax, INTERSECT_LEAF && intersect_leaf, BVH_Traversal_Statistics * statistics = nullptr) const;
+
+  template <class INTERSECT_LEAF>
+  bool closest_hit_leaves(const Ray_Query<float, 3u> & query, INTERSECT_LEAF && intersect_leaf, BVH_Traversal_Statistics * statistics = nullptr) const;
+
+  // same as Linear_BVH::any_hit_leaves
+  template <class OCCLUDES_LEAF>
+  bool any_hit_leaves(const Ray<float, 3u> & ray, float tmax, OCCLUDES_LEAF && occludes_leaf) const;
+
+  template <class OCCLUDES_LEAF>
+  bool any_hit_leaves(const Ray_Query<float, 3u> & query, OCCLUDES_LEAF && occludes_leaf) const;
+
+private:
+  // called for the primitive positions first, ..., first + count - 1 of a leaf hit by the ray
+  // returns true if a primitive is hit (closer than tmax for closest hit queries, tmax is lowered then)
+  typedef bool (*Leaf_Function)(void * context, uint32_t first, uint32_t count, float & tmax);
+
+  // the traversal loops are not templates, so that they can be compiled for the SIMD level they need
+  bool traverse_closest(const Ray_Query<float, 3u> & query, Leaf_Function leaf, void * context, BVH_Traversal_Statistics * statistics) const;
+  bool traverse_any(const Ray_Query<float, 3u> & query, Leaf_Function leaf, void * context) const;
+
+  uint32_t collapse(const BVH_Node<float, 3u> * node);
+
+  std::vector<Wide_BVH_Node<WIDTH>> nodes;
+  std::vector<size_t> primitives;
+  BVH_Build_Statistics statistics;
+};
+
+typedef Wide_BVH<4u> BVH4;
+typedef Wide_BVH<8u> BVH8;
+
+#endif
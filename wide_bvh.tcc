@@ -0,0 +1,125 @@
+#include "wide_bvh.h"
+#include <algorithm>
+#include <limits>
+
+template <size_t WIDTH>
+Wide_BVH<WIDTH>::Wide_BVH(const BVH<float, 3u> & bvh)
+  : primitives(bvh.primitive_order()), statistics(bvh.build_statistics())
+{
+  if (!bvh.empty()) {
+    collapse(bvh.root());
+  }
+}
+
+template <size_t WIDTH>
+uint32_t Wide_BVH<WIDTH>::collapse(const BVH_Node<float, 3u> * node) {
+  uint32_t index = static_cast<uint32_t>(nodes.size());
+  nodes.emplace_back();
+  for (size_t k = 0; k < 3; k++) {
+    std::fill(nodes[index].lower[k], nodes[index].lower[k] + WIDTH, std::numeric_limits<float>::infinity());
+    std::fill(nodes[index].upper[k], nodes[index].upper[k] + WIDTH, -std::numeric_limits<float>::infinity());
+  }
+  std::fill(nodes[index].child, nodes[index].child + WIDTH, 0u);
+  std::fill(nodes[index].count, nodes[index].count + WIDTH, 0u);
+
+  // a leaf only becomes a node of its own if it is the root
+  std::vector<const BVH_Node<float, 3u> *> children;
+  if (node->is_leaf()) {
+    children.push_back(node);
+  } else {
+    children = {node->left.get(), node->right.get()};
+  }
+  while (children.size() < WIDTH) {
+    auto largest = children.end();
+    for (auto child = children.begin(); child != children.end(); ++child) {
+      if (!(*child)->is_leaf() && (largest == children.end() || (*child)->bounds.surface_area() > (*largest)->bounds.surface_area())) {
+        largest = child;
+      }
+    }
+    if (largest == children.end()) {
+      break;
+    }
+    const BVH_Node<float, 3u> * expanded = *largest;
+    *largest = expanded->left.get();
+    children.push_back(expanded->right.get());
+  }
+
+  for (size_t slot = 0; slot < children.size(); slot++) {
+    Vector<float, 3u> lower = children[slot]->bounds.minimum(),
+                      upper = children[slot]->bounds.maximum();
+    for (size_t k = 0; k < 3; k++) {
+      nodes[index].lower[k][slot] = lower[k];
+      nodes[index].upper[k][slot] = upper[k];
+    }
+    if (children[slot]->is_leaf()) {
+      nodes[index].child[slot] = static_cast<uint32_t>(children[slot]->first);
+      nodes[index].count[slot] = static_cast<uint32_t>(children[slot]->count);
+    } else {
+      uint32_t child = collapse(children[slot]);  // may reallocate nodes
+      nodes[index].child[slot] = child;
+    }
+  }
+  return index;
+}
+
+template <size_t WIDTH>
+template <class INTERSECT>
+bool Wide_BVH<WIDTH>::closest_hit(const Ray<float, 3u> & ray, float tmax, INTERSECT && intersect, BVH_Traversal_Statistics * statistics) const {
+  return closest_hit_leaves(ray, tmax, [&](uint32_t first, uint32_t count, float & t) {
+    bool hit = false;
+    for (uint32_t i = first; i < first + count; i++) {
+      hit |= intersect(i, t);
+    }
+    return hit;
+  }, statistics);
+}
+
+template <size_t WIDTH>
+template <class OCCLUDES>
+bool Wide_BVH<WIDTH>::any_hit(const Ray<float, 3u> & ray, float tmax, OCCLUDES && occludes) const {
+  return any_hit_leaves(ray, tmax, [&](uint32_t first, uint32_t count) {
+    for (uint32_t i = first; i < first + count; i++) {
+      if (occludes(i)) {
+        return true;
+      }
+    }
+    return false;
+  });
+}
+
+template <size_t WIDTH>
+template <class INTERSECT_LEAF>
+bool Wide_BVH<WIDTH>::closest_hit_leaves(const Ray<float, 3u> & ray, float tmax, INTERSECT_LEAF && intersect_leaf, BVH_Traversal_Statistics * statistics) const {
+  return closest_hit_leaves(Ray_Query<float, 3u>(ray, 0.0f, tmax), intersect_leaf, statistics);
+}
+
+template <size_t WIDTH>
+template <class INTERSECT_LEAF>
+bool Wide_BVH<WIDTH>::closest_hit_leaves(const Ray_Query<float, 3u> & query, INTERSECT_LEAF && intersect_leaf, BVH_Traversal_Statistics * statistics) const {
+  auto leaf = [&](uint32_t first, uint32_t count, float & t) {
+    if (statistics) {
+      statistics->primitives_tested += count;
+    }
+    return intersect_leaf(first, count, t);
+  };
+  return traverse_closest(query, [](void * context, uint32_t first, uint32_t count, float & t) {
+    return (*static_cast<decltype(leaf) *>(context))(first, count, t);
+  }, &leaf, statistics);
+}
+
+template <size_t WIDTH>
+template <class OCCLUDES_LEAF>
+bool Wide_BVH<WIDTH>::any_hit_leaves(const Ray<float, 3u> & ray, float tmax, OCCLUDES_LEAF && occludes_leaf) const {
+  return any_hit_leaves(Ray_Query<float, 3u>(ray, 0.0f, tmax), occludes_leaf);
+}
+
+template <size_t WIDTH>
+template <class OCCLUDES_LEAF>
+bool Wide_BVH<WIDTH>::any_hit_leaves(const Ray_Query<float, 3u> & query, OCCLUDES_LEAF && occludes_leaf) const {
+  auto leaf = [&](uint32_t first, uint32_t count) {
+    return occludes_leaf(first, count);
+  };
+  return traverse_any(query, [](void * context, uint32_t first, uint32_t count, float &) {
+    return (*static_cast<decltype(leaf) *>(context))(first, count);
+  }, &leaf);
+}
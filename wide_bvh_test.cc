@@ -0,0 +1,183 @@
+#include "wide_bvh.h"
+#include "bvh.tcc"
+#include "wide_bvh.tcc"
+#include "scene.h"
+#include "random_spheres.h"
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace {
+
+// checks that every primitive is in exactly one leaf slot and every inner node is referenced once
+template <size_t WIDTH>
+void check_structure(const Wide_BVH<WIDTH> & bvh) {
+  const std::vector<Wide_BVH_Node<WIDTH>> & nodes = bvh.node_array();
+  std::vector<int> seen(bvh.primitive_count(), 0), referenced(nodes.size(), 0);
+
+  for (const Wide_BVH_Node<WIDTH> & node : nodes) {
+    size_t used = 0;
+    for (size_t i = 0; i < WIDTH; i++) {
+      if (node.lower[0][i] > node.upper[0][i]) {
+        continue;  // unused slot
+      }
+      used++;
+      if (node.count[i] > 0) {
+        for (size_t p = node.child[i]; p < node.child[i] + node.count[i]; p++) {
+          seen[p]++;
+        }
+      } else {
+        ASSERT_LT(node.child[i], nodes.size());
+        referenced[node.child[i]]++;
+      }
+    }
+    EXPECT_GE(used, 1u);
+  }
+  for (int count : seen) {
+    EXPECT_EQ(1, count);
+  }
+  EXPECT_EQ(0, referenced[0]);
+  for (size_t i = 1; i < referenced.size(); i++) {
+    EXPECT_EQ(1, referenced[i]);
+  }
+}
+
+// compares closest and any hit queries of a wide bvh with testing every sphere
+template <size_t WIDTH>
+void check_queries(const Wide_BVH<WIDTH> & bvh, const std::vector<Sphere3df> & spheres, unsigned seed) {
+  std::mt19937 generator(seed);
+  std::uniform_real_distribution<float> direction(-1.f, 1.f);
+
+  for (int r = 0; r < 500; r++) {
+    Ray3df ray = { {0.0, 0.0, 0.0}, {direction(generator), direction(generator), direction(generator)} };
+    size_t expected = spheres.size();
+    float expected_t = std::numeric_limits<float>::max();
+    for (size_t i = 0; i < spheres.size(); i++) {
+      float t = spheres[i].intersects(ray);
+      if (t > 0.f && t < expected_t) {
+        expected_t = t;
+        expected = i;
+      }
+    }
+
+    size_t closest = spheres.size();
+    bvh.closest_hit(ray, std::numeric_limits<float>::max(), [&](size_t position, float & tmax) {
+      size_t i = bvh.primitive_order()[position];
+      float t = spheres[i].intersects(ray);
+      if (t > 0.f && t < tmax) {
+        tmax = t;
+        closest = i;
+        return true;
+      }
+      return false;
+    });
+    EXPECT_EQ(expected, closest);
+
+    auto occludes = [&](size_t position) {
+      float t = spheres[bvh.primitive_order()[position]].intersects(ray);
+      return t > 0.f && t < expected_t;
+    };
+    EXPECT_FALSE(bvh.any_hit(ray, expected_t, occludes));
+    if (expected != spheres.size()) {
+      EXPECT_TRUE(bvh.any_hit(ray, std::numeric_limits<float>::max(), [&](size_t position) {
+        return spheres[bvh.primitive_order()[position]].intersects(ray) > 0.f;
+      }));
+    }
+  }
+}
+
+TEST(WIDE_BVH, NodeLayout) {
+  EXPECT_EQ(128u, sizeof(Wide_BVH_Node<4u>));
+  EXPECT_EQ(256u, sizeof(Wide_BVH_Node<8u>));
+
+  BVH4 bvh{BVH3df(bounding_boxes(random_spheres(1000, 1)))};
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(bvh.node_array().data()) % 32u);
+}
+
+TEST(WIDE_BVH, EmptyBVH) {
+  BVH4 bvh{BVH3df(std::vector<AABB3df>{})};
+  Ray3df ray = { {0.0, 0.0, 0.0}, {1.0, 0.0, 0.0} };
+
+  EXPECT_TRUE(bvh.empty());
+  EXPECT_FALSE(bvh.closest_hit(ray, 100.f, [](size_t, float &) { return true; }));
+  EXPECT_FALSE(bvh.any_hit(ray, 100.f, [](size_t) { return true; }));
+}
+
+TEST(WIDE_BVH, SingleLeafRoot) {
+  std::vector<Sphere3df> spheres = { Sphere3df({5.0, 0.0, 0.0}, 1.0) };
+  BVH4 bvh{BVH3df(bounding_boxes(spheres))};
+  Ray3df ray = { {0.0, 0.0, 0.0}, {1.0, 0.0, 0.0} };
+
+  ASSERT_EQ(1u, bvh.node_count());
+  check_structure(bvh);
+  EXPECT_TRUE(bvh.any_hit(ray, 100.f, [](size_t) { return true; }));
+}
+
+TEST(WIDE_BVH, CollapsedNodesAreFewer) {
+  BVH3df tree(bounding_boxes(random_spheres(2000, 2)));
+  BVH4 bvh4(tree);
+  BVH8 bvh8(tree);
+
+  check_structure(bvh4);
+  check_structure(bvh8);
+  EXPECT_EQ(tree.primitive_order(), bvh4.primitive_order());
+  EXPECT_LT(bvh4.node_count(), tree.node_count() / 2);
+  EXPECT_LT(bvh8.node_count(), bvh4.node_count());
+}
+
+TEST(WIDE_BVH, BVH4QueriesMatchBruteForce) {
+  std::vector<Sphere3df> spheres = random_spheres(2000, 3);
+  check_queries(BVH4(BVH3df(bounding_boxes(spheres))), spheres, 4);
+}
+
+TEST(WIDE_BVH, BVH8QueriesMatchBruteForce) {
+  if (simd_level() < BVH8::required_simd_level()) {
+    GTEST_SKIP() << "cpu does not support AVX2";
+  }
+  std::vector<Sphere3df> spheres = random_spheres(2000, 5);
+  check_queries(BVH8(BVH3df(bounding_boxes(spheres))), spheres, 6);
+}
+
+TEST(WIDE_BVH, AxisParallelRays) {
+  // rays parallel to the slabs of some children produce 0 * inf in the child tests
+  std::vector<Sphere3df> spheres = random_spheres(500, 7);
+  BVH4 bvh{BVH3df(bounding_boxes(spheres))};
+  for (const Sphere3df & sphere : spheres) {
+    AABB3df box = sphere.bounding_box();
+    Ray3df ray = { {box.get_center()[0], box.get_center()[1], -100.f}, {0.0, 0.0, 1.0} };
+    EXPECT_TRUE(bvh.any_hit(ray, std::numeric_limits<float>::max(), [&](size_t position) {
+      return spheres[bvh.primitive_order()[position]].intersects(ray) > 0.f;
+    }));
+  }
+}
+
+TEST(WIDE_BVH, SceneLayoutsAgree) {
+  worldObjects world = cornell_box();
+  std::mt19937 generator(8);
+  std::uniform_real_distribution<float> direction(-1.f, 1.f);
+  std::vector<Ray3df> rays;
+  for (int r = 0; r < 200; r++) {
+    rays.push_back(Ray3df{ {0.0, 0.0, 0.0}, {direction(generator), direction(generator), direction(generator)} });
+  }
+
+  world.build({}, BVH_Layout::BINARY);
+  EXPECT_EQ(BVH_Layout::BINARY, world.bvh_layout());
+  std::vector<Vector3df> expected;
+  for (const Ray3df & ray : rays) {
+    expected.push_back(ray_color(ray, world, 5));
+  }
+  for (BVH_Layout layout : {BVH_Layout::WIDE_4, BVH_Layout::WIDE_8, BVH_Layout::AUTOMATIC}) {
+    world.build({}, layout);
+    EXPECT_NE(BVH_Layout::AUTOMATIC, world.bvh_layout());
+    for (size_t r = 0; r < rays.size(); r++) {
+      Vector3df color = ray_color(rays[r], world, 5);
+      for (size_t k = 0; k < 3; k++) {
+        EXPECT_EQ(expected[r][k], color[k]);
+      }
+    }
+  }
+}
+
+}